@@ -0,0 +1,35 @@
+#include "Bench_common.h"
+#include "BenchRoms.h"
+
+#include <cstdlib>
+
+/** @brief Instructions executed per benchmark iteration. */
+const uint64_t BENCH_CYCLES_PER_ITERATION = 10'000;
+
+// ====== Whole-ROM throughput, per engine ======
+
+// items_per_second is the emulated instructions per second
+static void BM_Rom(benchmark::State& state, std::vector<uint8_t> rom) {
+    auto chip8 = std::make_unique<Chip8>(engineFromArg(state.range(0)));
+    chip8->LoadROM(rom);
+
+    for (auto _ : state)
+        chip8->Run(BENCH_CYCLES_PER_ITERATION);
+
+    benchmark::DoNotOptimize(chip8->StateHash());
+    state.SetItemsProcessed(state.iterations() * BENCH_CYCLES_PER_ITERATION);
+    state.SetLabel(engineNames[state.range(0)]);
+}
+BENCHMARK_CAPTURE(BM_Rom, alu, aluRom)->DenseRange(0, 3);
+BENCHMARK_CAPTURE(BM_Rom, memory, memoryRom)->DenseRange(0, 3);
+BENCHMARK_CAPTURE(BM_Rom, sprites, spriteRom)->DenseRange(0, 3);
+
+// CHIP8_BENCH_ROM=path/to/rom.ch8 adds a real game to the suite
+static const bool externalRomRegistered = [] {
+    const char* filename = std::getenv("CHIP8_BENCH_ROM");
+    if (!filename)
+        return false;
+
+    benchmark::RegisterBenchmark("BM_Rom/external", BM_Rom, Chip8::ReadROM(filename))->DenseRange(0, 3);
+    return true;
+}();
@@ -0,0 +1,136 @@
+#include "Bench_common.h"
+#include "XoChip.h"
+
+// ====== Opcode handlers, called directly on a decoded opcode ======
+
+// DRW V0, V1, n: one row of sprite per unit of height
+static void BM_OP_Dxyn(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0xD010 | state.range(0));
+    for (auto _ : state)
+        chip8->OP_Dxyn();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OP_Dxyn)->Arg(1)->Arg(5)->Arg(15);
+
+// LD B, V0: three divisions and three memory writes
+static void BM_OP_Fx33(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0xF033);
+    for (auto _ : state)
+        chip8->OP_Fx33();
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OP_Fx33);
+
+// LD [I], Vx: x + 1 bytes stored, plus the code invalidation of the caching engines
+static void BM_OP_Fx55(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0xF055 | (state.range(0) << 8), engineFromArg(state.range(1)));
+    for (auto _ : state)
+        chip8->OP_Fx55();
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(engineNames[state.range(1)]);
+}
+BENCHMARK(BM_OP_Fx55)->ArgsProduct({{0, 7, 15}, {0, 1}});
+
+// LD Vx, [I]: x + 1 bytes loaded
+static void BM_OP_Fx65(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0xF065 | (state.range(0) << 8));
+    for (auto _ : state) {
+        chip8->OP_Fx65();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OP_Fx65)->Arg(0)->Arg(7)->Arg(15);
+
+// ====== Table dispatch, against the handler it lands on ======
+
+// ADD V0, V1 called directly
+static void BM_OP_8xy4(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0x8014);
+    for (auto _ : state) {
+        chip8->OP_8xy4();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OP_8xy4);
+
+// ADD V0, V1 through Table8
+static void BM_Table8(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0x8014);
+    for (auto _ : state) {
+        chip8->Table8();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Table8);
+
+// SHR V0, V1 through Table8 under every quirk profile: each one dispatches to its own specialization
+static void BM_Table8_Quirks(benchmark::State& state) {
+    auto profile = static_cast<Chip8QuirkProfile>(state.range(0));
+    auto chip8 = prepareOpcode(0x8016, Chip8Engine::Table, profile);
+    for (auto _ : state) {
+        chip8->Table8();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(QuirkProfileName(profile));
+}
+BENCHMARK(BM_Table8_Quirks)->DenseRange(0, 3);
+
+// LD V0, DT called directly
+static void BM_OP_Fx07(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0xF007);
+    for (auto _ : state) {
+        chip8->OP_Fx07();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_OP_Fx07);
+
+// LD V0, DT through TableF
+static void BM_TableF(benchmark::State& state) {
+    auto chip8 = prepareOpcode(0xF007);
+    for (auto _ : state) {
+        chip8->TableF();
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TableF);
+
+// XO-CHIP DRW V0, V0, n then JP back, in lo-res or hi-res: n = 0 draws 16x16 across both row words
+static void BM_XoChip_Dxyn(benchmark::State& state) {
+    uint8_t mode = state.range(1) ? 0xFF : 0xFE;
+    uint8_t draw = 0x00 | static_cast<uint8_t>(state.range(0));
+    std::vector<uint8_t> rom = {0x00, mode, 0x60, 0x10, 0xD0, draw, 0x12, 0x04};
+
+    auto xochip = std::make_unique<XoChip>();
+    xochip->LoadROM(rom);
+    xochip->Run(2);
+    for (auto _ : state)
+        xochip->Run(2);
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(1) ? "hires" : "lores");
+}
+BENCHMARK(BM_XoChip_Dxyn)->ArgsProduct({{5, 0}, {0, 1}});
+
+// Whole 128x64 display of a drawn screen to RGBA, in lo-res or hi-res
+static void BM_XoChip_ExpandVideo(benchmark::State& state) {
+    uint8_t mode = state.range(0) ? 0xFF : 0xFE;
+    std::vector<uint8_t> rom = {0x00, mode, 0xF3, 0x01, 0xA2, 0x00, 0xD0, 0x10, 0x70, 0x0B, 0x71, 0x05, 0x12, 0x06};
+
+    auto xochip = std::make_unique<XoChip>();
+    xochip->LoadROM(rom);
+    xochip->Run(400);
+    std::vector<uint32_t> pixels(XO_VIDEO_WIDTH * XO_VIDEO_HEIGHT);
+    for (auto _ : state) {
+        xochip->ExpandVideo(0, XO_VIDEO_HEIGHT, pixels.data(), XO_VIDEO_WIDTH * sizeof(uint32_t));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(0) ? "hires" : "lores");
+}
+BENCHMARK(BM_XoChip_ExpandVideo)->Arg(0)->Arg(1);
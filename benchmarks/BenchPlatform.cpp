@@ -0,0 +1,36 @@
+#include "Bench_common.h"
+#include "Platform.h"
+
+#include <cstdlib>
+
+// Renders without a window, so the suite runs on headless machines
+static std::unique_ptr<Platform> offscreenPlatform() {
+    setenv("SDL_VIDEODRIVER", "offscreen", 0);
+    return std::make_unique<Platform>("Benchmark", VIDEO_WIDTH * 10, VIDEO_HEIGHT * 10, VIDEO_WIDTH, VIDEO_HEIGHT);
+}
+
+// ====== Display upload ======
+
+// Whole RGBA frame, the path of the original renderer
+static void BM_PlatformUpdate(benchmark::State& state) {
+    auto platform = offscreenPlatform();
+    std::vector<uint32_t> pixels(VIDEO_WIDTH * VIDEO_HEIGHT, PIXEL_ON_COLOR);
+
+    for (auto _ : state)
+        platform->Update(pixels.data(), VIDEO_WIDTH * sizeof(uint32_t));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PlatformUpdate);
+
+// Packed framebuffer with `n` dirty rows
+static void BM_PlatformUpdatePacked(benchmark::State& state) {
+    auto platform = offscreenPlatform();
+    std::array<uint64_t, VIDEO_HEIGHT> rows;
+    rows.fill(0xAAAAAAAAAAAAAAAAULL);
+    uint64_t dirtyRows = state.range(0) >= 64 ? ~0ULL : (1ULL << state.range(0)) - 1;
+
+    for (auto _ : state)
+        platform->UpdatePacked(rows.data(), dirtyRows);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_PlatformUpdatePacked)->Arg(1)->Arg(8)->Arg(VIDEO_HEIGHT);
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Workloads bundled with the benchmarks, each one loops forever
+
+// Register arithmetic only: 0x204: ADD V0, 1 ; ADD V1, V0 ; SHR V2 ; XOR V3, V1 ; LD I, 0x300 ; SE V0, 0 ; JP 0x204
+static const std::vector<uint8_t> aluRom = {0x60, 0x00, 0x61, 0x00, 0x70, 0x01, 0x81, 0x04, 0x82, 0x06,
+                                            0x83, 0x13, 0xA3, 0x00, 0x30, 0x00, 0x12, 0x04, 0x12, 0x04};
+
+// Arithmetic plus memory writes: the same loop with LD B, V0 (Fx33) storing into data memory
+static const std::vector<uint8_t> memoryRom = {0x60, 0x00, 0x61, 0x00, 0x70, 0x01, 0x81, 0x04, 0x82, 0x06,
+                                               0x83, 0x13, 0xA3, 0x00, 0xF0, 0x33, 0x30, 0x00, 0x12, 0x04,
+                                               0x12, 0x04};
+
+// Sprite drawing: I = font glyph 5, then 0x208: DRW V0, V1, 5 ; ADD V0, 5 ; ADD V1, 3 ; JP 0x208
+static const std::vector<uint8_t> spriteRom = {0x60, 0x00, 0x61, 0x00, 0x62, 0x05, 0xF2, 0x29,
+                                               0xD0, 0x15, 0x70, 0x05, 0x71, 0x03, 0x12, 0x08};
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "Chip8.h"
+
+// Names of the Chip8Engine values, indexed by the benchmark argument
+static const std::array<const char*, 4> engineNames = {"table", "predecoded", "block", "jit"};
+
+inline Chip8Engine engineFromArg(int64_t arg) {
+    return static_cast<Chip8Engine>(arg);
+}
+
+// CPU with `instruction` as its current opcode, V0 = 0x12, V1 = 0x08 and I = 0x300.
+// The OP_* handlers can then be called directly, without fetch nor dispatch.
+inline std::unique_ptr<Chip8> prepareOpcode(uint16_t instruction, Chip8Engine engine = Chip8Engine::Table,
+                                            Chip8QuirkProfile profile = Chip8QuirkProfile::Default) {
+    std::vector<uint8_t> rom = {0xA3, 0x00, 0x60, 0x12, 0x61, 0x08,
+                                static_cast<uint8_t>(instruction >> 8), static_cast<uint8_t>(instruction & 0xFF)};
+
+    // The CPU and its caches are too large for the benchmark stack
+    auto chip8 = std::make_unique<Chip8>(engine, profile);
+    chip8->LoadROM(rom);
+    chip8->Run(4);
+    return chip8;
+}
@@ -0,0 +1,206 @@
+/**
+ * @file Audio.h
+ * @brief Beeper and XO-CHIP audio output
+ *
+ * This file contains the declaration of the AudioSynth class, which turns the sound state of the
+ * emulation into samples, and of the AudioOutput class, which plays them through SDL. The
+ * emulation thread only pushes changes (beeper edges, XO-CHIP patterns) into a lock-free ring,
+ * the SDL audio thread synthesises every sample from it.
+ */
+
+#pragma once
+
+#include "SpscRing.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <SDL2/SDL.h>
+
+/** @brief Output sample rate (in Hz). */
+const unsigned int AUDIO_SAMPLE_RATE = 48000;
+
+/** @brief Samples per SDL callback, about 5 ms at AUDIO_SAMPLE_RATE. */
+const unsigned int AUDIO_BUFFER_SAMPLES = 256;
+
+/** @brief Frequency of the plain CHIP-8 beeper (in Hz). */
+const unsigned int AUDIO_TONE_FREQUENCY = 440;
+
+/** @brief Amplitude of the square wave, a quarter of the signed 16-bit range. */
+const int16_t AUDIO_AMPLITUDE = 8192;
+
+/** @brief Number of sound changes the emulation can queue ahead of the audio thread. */
+const std::size_t AUDIO_EVENT_CAPACITY = 256;
+
+/** @brief Size (in bytes) of an XO-CHIP audio pattern, 128 one-bit samples. */
+const unsigned int AUDIO_PATTERN_SIZE = 16;
+
+/** @brief Playback rate of an XO-CHIP pattern at the default pitch of 64 (in bits per second). */
+const double AUDIO_PATTERN_BASE_RATE = 4000.0;
+
+/**
+ * @brief Kind of change carried by an AudioEvent.
+ */
+enum class AudioEventType : uint8_t
+{
+    Tone,       /**< The beeper starts or stops. */
+    Pattern     /**< A new XO-CHIP pattern or pitch, played while the beeper is on. */
+};
+
+/**
+ * @brief A change of the sound state, stamped with the output sample it applies at.
+ */
+struct AudioEvent
+{
+    uint64_t sample = 0;                                    /**< Producer time, in output samples. */
+    AudioEventType type = AudioEventType::Tone;             /**< Kind of change. */
+    bool on = false;                                        /**< Tone: new beeper state. */
+    uint8_t pitch = 64;                                     /**< Pattern: XO-CHIP pitch register. */
+    std::array<uint8_t, AUDIO_PATTERN_SIZE> pattern{};      /**< Pattern: the bits, MSB first. */
+};
+
+/**
+ * @class AudioSynth
+ * @brief Square wave and 1-bit pattern synthesiser fed through an SpscRing.
+ * @details SetTone() and SetPattern() are called by the emulation thread and only queue the
+ * changes, Render() is called by the audio thread and neither locks nor allocates.
+ *
+ * The first event anchors the producer clock one buffer ahead of the playhead, so the changes
+ * queued during a callback land at their exact sample in the next one. An event too far ahead or
+ * behind (the host and audio clocks drifted, or the emulation stalled) re-anchors the clocks,
+ * which bounds the latency to about three buffers including the one SDL is playing.
+ */
+class AudioSynth
+{
+public:
+    /**
+     * @brief Constructs a silent synthesiser.
+     * @param sampleRate Output sample rate (in Hz).
+     * @param bufferSamples Samples per Render() call, the scheduling delay of the events.
+     */
+    explicit AudioSynth(unsigned int sampleRate = AUDIO_SAMPLE_RATE, unsigned int bufferSamples = AUDIO_BUFFER_SAMPLES);
+
+    /**
+     * @brief Queues a beeper edge, emulation thread.
+     * @details Nothing is queued when the state did not change, so it can be called every frame.
+     * @param on True while the sound timer is non-zero.
+     * @param sample Producer time of the change, in output samples.
+     * @return False when the ring is full, the edge is retried by the next call.
+     */
+    bool SetTone(bool on, uint64_t sample);
+
+    /**
+     * @brief Queues an XO-CHIP pattern, emulation thread.
+     * @details Nothing is queued when neither the pattern nor the pitch changed.
+     * @param pattern The 16 bytes loaded by F002.
+     * @param pitch The pitch register set by Fx3A.
+     * @param sample Producer time of the change, in output samples.
+     * @return False when the ring is full, the pattern is retried by the next call.
+     */
+    bool SetPattern(std::span<const uint8_t, AUDIO_PATTERN_SIZE> pattern, uint8_t pitch, uint64_t sample);
+
+    /**
+     * @brief Synthesises the next samples, audio thread.
+     * @param out Receives the mono signed 16-bit samples.
+     * @param count Number of samples to write.
+     */
+    void Render(int16_t* out, std::size_t count);
+
+    /**
+     * @brief Get the producer time of the next sample to render.
+     * @return The playhead, only meaningful on the audio thread.
+     */
+    inline uint64_t get_playhead() const { return this->playhead; }
+
+    /**
+     * @brief Get the output sample rate.
+     * @return The rate given at construction (in Hz).
+     */
+    inline unsigned int get_sample_rate() const { return this->sampleRate; }
+
+private:
+    /** @brief Applies a due event to the oscillator. */
+    void Apply(const AudioEvent& event);
+
+    /** @brief Writes count samples of the current waveform. */
+    void Synthesize(int16_t* out, std::size_t count);
+
+    SpscRing<AudioEvent, AUDIO_EVENT_CAPACITY> events;      /**< Changes from the emulation thread. */
+    unsigned int sampleRate;                                /**< Output sample rate (in Hz). */
+    unsigned int bufferSamples;                             /**< Scheduling delay (in samples). */
+
+    // Emulation thread
+    bool queuedOn = false;                                  /**< Last beeper state queued. */
+    AudioEvent queuedPattern{.type = AudioEventType::Pattern}; /**< Last pattern queued. */
+
+    // Audio thread
+    bool anchored = false;                                  /**< False until the first event. */
+    uint64_t playhead = 0;                                  /**< Producer time of the next sample. */
+    bool on = false;                                        /**< Beeper state being played. */
+    bool patterned = false;                                 /**< Plays the pattern instead of the square wave. */
+    std::array<uint8_t, AUDIO_PATTERN_SIZE> pattern{};      /**< Pattern being played. */
+    uint32_t phase = 0;                                     /**< Position in the period (or the 128 bits), full range. */
+    uint32_t step = 0;                                      /**< Phase increment per sample. */
+};
+
+/**
+ * @class AudioOutput
+ * @brief Plays an AudioSynth on the default SDL audio device.
+ * @details Opening the device never fails the emulator: without audio, is_open() is false and the
+ * setters do nothing. SDL_AUDIODRIVER selects the driver, "dummy" and "disk" run without hardware.
+ * The changes are stamped with the host clock, the producer time of the synthesiser.
+ */
+class AudioOutput
+{
+public:
+    /**
+     * @brief Opens and starts the audio device.
+     * @param sampleRate Requested sample rate (in Hz), SDL converts if the device differs.
+     * @param bufferSamples Requested samples per callback.
+     */
+    explicit AudioOutput(unsigned int sampleRate = AUDIO_SAMPLE_RATE, unsigned int bufferSamples = AUDIO_BUFFER_SAMPLES);
+
+    /** @brief Stops and closes the device. */
+    ~AudioOutput();
+
+    AudioOutput(const AudioOutput&) = delete;
+    AudioOutput& operator=(const AudioOutput&) = delete;
+
+    /**
+     * @brief Tells whether a device is playing.
+     * @return False when SDL could not open one.
+     */
+    inline bool is_open() const { return this->device != 0; }
+
+    /**
+     * @brief Get the expected delay between a change and its playback.
+     * @return The scheduling delay plus the device buffering, in seconds.
+     */
+    double get_latency() const;
+
+    /**
+     * @brief Starts or stops the beeper, see AudioSynth::SetTone().
+     * @param on True while the sound timer is non-zero.
+     */
+    void SetTone(bool on);
+
+    /**
+     * @brief Sets the XO-CHIP pattern, see AudioSynth::SetPattern().
+     * @param pattern The 16 bytes loaded by F002.
+     * @param pitch The pitch register set by Fx3A.
+     */
+    void SetPattern(std::span<const uint8_t, AUDIO_PATTERN_SIZE> pattern, uint8_t pitch);
+
+private:
+    /** @brief SDL audio callback, renders the synthesiser given as userdata. */
+    static void Callback(void* userdata, Uint8* stream, int length);
+
+    /** @brief Get the host time since the device opened, in output samples. */
+    uint64_t Now() const;
+
+    std::unique_ptr<AudioSynth> synth;                      /**< Shared with the callback, never moves. */
+    SDL_AudioSpec spec{};                                   /**< Format of the opened device. */
+    SDL_AudioDeviceID device = 0;                           /**< Device, 0 when none could be opened. */
+    std::chrono::steady_clock::time_point start;            /**< Origin of the producer time. */
+};
@@ -0,0 +1,98 @@
+/**
+ * @file BatchRunner.h
+ * @brief Multi-instance batch execution of CHIP-8 ROMs
+ *
+ * This file contains the declaration of the BatchRunner class, which runs many independent
+ * Chip8 or XoChip instances on a work-stealing thread pool. Each job carries a ROM, a cycle
+ * budget and a scripted input, and reports the final state hash so runs can be compared across builds.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Chip8.h"
+#include "Movie.h"
+#include "RomStore.h"
+#include "Scheduler.h"
+
+/**
+ * @brief One independent run of the batch.
+ */
+struct BatchJob
+{
+    std::string name;                                   /**< Label reported with the result. */
+    std::shared_ptr<const RomImage> rom;                /**< ROM image, shared between jobs. */
+    uint64_t cycles = 0;                                /**< Maximum number of instructions. */
+    std::vector<InputEvent> inputs;                     /**< Scripted input, sorted by cycle. */
+    uint64_t seed = 0;                                  /**< Seed of the Cxkk random generator. */
+    Chip8Engine engine = Chip8Engine::Table;            /**< Dispatch strategy. */
+    unsigned int instructionsPerFrame = DEFAULT_INSTRUCTIONS_PER_FRAME; /**< Timer tick ratio. */
+    Chip8QuirkProfile quirks = Chip8QuirkProfile::Default; /**< Interpreter whose quirks are emulated, schip and xochip run on XoChip. */
+};
+
+/**
+ * @brief Outcome of a BatchJob.
+ */
+struct BatchResult
+{
+    std::string name;       /**< Label of the job. */
+    uint64_t stateHash = 0; /**< StateHash() of the core at the end of the run. */
+    uint64_t cycles = 0;    /**< Instructions executed (less than the budget if the ROM halted). */
+    uint64_t frames = 0;    /**< 60 Hz timer ticks. */
+    bool halted = false;    /**< True if the ROM halted before the budget was spent. */
+    std::string error;      /**< Failure message, empty on success. */
+};
+
+/**
+ * @class BatchRunner
+ * @brief Runs batches of jobs, one Chip8 (XoChip for SUPER-CHIP and XO-CHIP ROMs) per job, on a ThreadPool.
+ *
+ * Jobs share nothing but their read-only ROM image, so the batch scales with the number of
+ * cores. Every job runs under the FixedRatio scheduler with a fixed seed: its result only
+ * depends on the job, never on the thread or the wall clock.
+ */
+class BatchRunner
+{
+public:
+    /**
+     * @brief Constructs a runner.
+     * @param threads Number of worker threads, 0 uses one per hardware thread.
+     */
+    explicit BatchRunner(unsigned int threads = 0);
+
+    /**
+     * @brief Get the number of worker threads.
+     * @return The size of the thread pool.
+     */
+    inline unsigned int get_threads() const { return this->threads; }
+
+    /**
+     * @brief Runs every job of a batch.
+     * @param jobs Jobs to run.
+     * @return The results, in the order of `jobs`.
+     */
+    std::vector<BatchResult> Run(const std::vector<BatchJob>& jobs) const;
+
+    /**
+     * @brief Runs a single job on the calling thread.
+     * @param job Job to run.
+     * @return Its result, errors are reported in BatchResult::error.
+     */
+    static BatchResult RunJob(const BatchJob& job);
+
+    /**
+     * @brief Reads a scripted input file.
+     * @details One event per line: `<cycle> <key> <down|up>`, the key in hexadecimal.
+     * Empty lines and lines starting with `#` are ignored.
+     * @param filename Path to the script.
+     * @return The events sorted by cycle.
+     */
+    static std::vector<InputEvent> LoadInputScript(const std::string& filename);
+
+private:
+    unsigned int threads; /**< Number of worker threads. */
+};
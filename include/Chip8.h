@@ -9,28 +9,54 @@
  #pragma once
 
  #include <cstdint>
- #include <random>
+ #include <algorithm>
  #include <chrono>
  #include <cstring>
  #include <fstream>
  #include <filesystem>
+ #include <bitset>
+ #include <memory>
+ #include <span>
+ #include <vector>
  
  #include "Chip8_common.h"
+ #include "Chip8State.h"
+ #include "Rng.h"
+ #include "Jit.h"
+ #include "Profiler.h"
+ #include "Quirks.h"
  
+ /**
+  * @brief Instruction dispatch strategies available to the CPU.
+  */
+ enum class Chip8Engine
+ {
+     Table,      /**< Fetch and decode through the opcode tables on every cycle. */
+     Predecoded, /**< Decode each memory word once and dispatch from the decoded cache. */
+     Block,      /**< Cache straight-line runs keyed by PC and execute a whole block per dispatch. */
+     Jit         /**< Translate basic blocks to native x86-64 code (falls back to Block elsewhere). */
+ };
+
  /**
   * @class Chip8
   * @brief CHIP-8 Emulator
   *
   * This class emulates a CHIP-8 CPU, providing methods to load ROMs, execute instructions,
   * and interact with the display and keypad.
+  *
+  * The handlers whose behaviour depends on the interpreter being emulated are templates on a
+  * Chip8Quirks set. The constructor fills the opcode tables with the specializations of the
+  * requested profile, so every engine dispatches to code compiled for that profile alone.
   */
  class Chip8
  {
  public:
      /**
       * @brief Constructor: Initializes the CHIP-8 emulator.
+      * @param engine Instruction dispatch strategy used by Cycle() and Run().
+      * @param profile Interpreter whose quirks are emulated, see DetectQuirkProfile().
       */
-     Chip8();
+     explicit Chip8(Chip8Engine engine = Chip8Engine::Table, Chip8QuirkProfile profile = Chip8QuirkProfile::Default);
  
      /**
       * @brief Default destructor.
@@ -41,16 +67,121 @@
  
      /**
       * @brief Get the current state of the keypad.
-      * @return An array representing the keypad state (pressed keys).
+      * @return A reference to the keypad state (pressed keys), no copy is made.
       */
-     inline std::array<uint8_t, NUM_KEYS> get_keypad() const { return this->keypad; }
- 
+     inline const std::array<uint8_t, NUM_KEYS>& get_keypad() const { return this->keypad; }
+
+     /**
+      * @brief Get a read-only view of the memory.
+      * @return A view of the 4KB address space, no copy is made.
+      */
+     inline std::span<const uint8_t, MEMORY_SIZE> get_memory() const { return this->memory; }
+
+     /**
+      * @brief Get a read-only view of the registers.
+      * @return A view of V0 to VF, no copy is made.
+      */
+     inline std::span<const uint8_t, NUM_REGISTERS> get_registers() const { return this->registers; }
+
      /**
       * @brief Get the current state of the video display.
+      * @details The packed framebuffer is expanded to RGBA8888 on each call, render paths
+      * should use get_framebuffer() which does not copy.
       * @return An array representing the monochrome 64x32 display.
       */
-     inline std::array<uint32_t, VIDEO_HEIGHT * VIDEO_WIDTH> get_video() const { return this->video; }
- 
+     std::array<uint32_t, VIDEO_HEIGHT * VIDEO_WIDTH> get_video() const;
+
+     /**
+      * @brief Get the packed video display.
+      * @return One word per row, one bit per pixel, bit 63 being the leftmost pixel.
+      */
+     inline const std::array<uint64_t, VIDEO_HEIGHT>& get_framebuffer() const { return this->video; }
+
+     /**
+      * @brief Tells whether the display changed since the last ClearDirty().
+      * @return True if at least one row was cleared or drawn to.
+      */
+     inline bool is_dirty() const { return this->draw_flag; }
+
+     /**
+      * @brief Get the rows touched since the last ClearDirty().
+      * @return A mask with bit `n` set when row `n` was cleared or drawn to.
+      */
+     inline uint64_t get_dirty_rows() const { return this->dirtyRows; }
+
+     /** @brief Marks the display as presented. */
+     inline void ClearDirty()
+     {
+         dirtyRows = 0;
+         draw_flag = false;
+     }
+
+     // ====== Input injection ======
+
+     /**
+      * @brief Presses or releases a key of the keypad.
+      * @param key Key number (0x0 to 0xF), out of range keys are ignored.
+      * @param pressed True when the key is held down.
+      */
+     inline void SetKey(uint8_t key, bool pressed)
+     {
+         if (key < NUM_KEYS)
+             keypad[key] = pressed ? 1 : 0;
+     }
+
+     /**
+      * @brief Get a writable view of the keypad for input backends.
+      * @return A view of the keypad state written in place by Platform::ProcessInput().
+      */
+     inline std::span<uint8_t, NUM_KEYS> get_keypad_input() { return this->keypad; }
+
+     /**
+      * @brief Get the current program counter.
+      * @return The address of the next instruction to be fetched.
+      */
+     inline uint16_t get_pc() const { return this->pc; }
+
+     /**
+      * @brief Get the sound timer.
+      * @return The remaining 60 Hz ticks of the beeper, it sounds while non-zero.
+      */
+     inline uint8_t get_sound_timer() const { return this->soundTimer; }
+
+     /**
+      * @brief Get the dispatch strategy selected at construction.
+      * @return The execution engine used by Cycle() and Run().
+      */
+     inline Chip8Engine get_engine() const { return this->engine; }
+
+     /**
+      * @brief Get the quirk profile selected at construction.
+      * @return The interpreter whose behaviour the handlers follow.
+      */
+     inline Chip8QuirkProfile get_quirk_profile() const { return this->quirkProfile; }
+
+     /**
+      * @brief Checks whether the CPU can no longer make progress.
+      * @details A ROM is considered halted when the last instruction was a jump to itself
+      * (the usual CHIP-8 idiom to end a program) or when the PC ran off the end of memory.
+      * @return True if running more cycles would not change the machine state.
+      */
+     inline bool is_halted() const
+     {
+         // After a 1nnn the PC equals nnn, so a jump-to-self fetches the very same opcode again
+         return (pc > MEMORY_SIZE - 2)
+             || ((opcode & 0xF000u) == 0x1000u && ((memory[pc] << 8u) | memory[pc + 1]) == opcode);
+     }
+
+     /**
+      * @brief Recognizes the idle loops that cannot change the machine state until a timer
+      * tick or a key change.
+      * @details Only loops already settled are reported (the instruction before the PC in the
+      * loop has just run, with the same outcome as every following iteration), so skipping them
+      * with SkipIdleCycles() is exact.
+      * @return The kind of wait, Running when the CPU is not provably idle.
+      */
+     Chip8IdleState get_idle_state() const;
+
      // ====== CPU Functions ======
  
      /**
@@ -58,6 +189,61 @@
       * @param filename Path to the ROM file.
       */
      void LoadROM(const std::string& filename);
+
+     /**
+      * @brief Loads a ROM image already in memory.
+      * @param rom ROM contents, copied at 0x200.
+      */
+     void LoadROM(std::span<const uint8_t> rom);
+
+     /** 
+      * @brief Checks and reads a ROM file without loading it.
+      * @param filename Path to the ROM file.
+      * @return A vector containing the ROM's binary data.
+      */
+     static std::vector<uint8_t> ReadROM(const std::string& filename);
+
+     /**
+      * @brief Captures the whole machine state.
+      * @details A flat copy, cheap enough to be taken every frame.
+      * @param state Receives the snapshot.
+      */
+     void SaveState(Chip8State& state) const;
+
+     /**
+      * @brief Restores a snapshot taken by SaveState().
+      * @details The instruction caches are dropped and the whole display is marked dirty.
+      * @param state Snapshot to restore.
+      */
+     void LoadState(const Chip8State& state);
+
+     /**
+      * @brief Writes the machine state to a save-state file.
+      * @param filename Path to the file, overwritten.
+      */
+     void SaveState(const std::string& filename) const;
+
+     /**
+      * @brief Restores the machine state from a save-state file.
+      * @param filename Path to a file written by SaveState().
+      */
+     void LoadState(const std::string& filename);
+
+     /**
+      * @brief Reseeds the random number generator used by Cxkk.
+      * @details A new CPU is seeded with DEFAULT_RNG_SEED, so runs are reproducible unless the
+      * front end seeds it from a clock.
+      * @param seed Seed, equal seeds give equal random sequences.
+      */
+     void Seed(uint64_t seed);
+
+     /**
+      * @brief Hashes the architectural state (FNV-1a).
+      * @details Covers the registers, memory, index, PC, stack, timers and display, which is
+      * enough to compare runs for regressions without storing whole states.
+      * @return The 64-bit hash of the state.
+      */
+     uint64_t StateHash() const;
  
      /** @brief Clears the display. */
      void OP_00E0();
@@ -89,13 +275,16 @@
      /** @brief Sets Vx = Vy. */
      void OP_8xy0();
  
-     /** @brief Performs bitwise OR: Vx = Vx | Vy. */
+     /** @brief Performs bitwise OR: Vx = Vx | Vy, then clears VF under logicResetsVF. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_8xy1();
  
-     /** @brief Performs bitwise AND: Vx = Vx & Vy. */
+     /** @brief Performs bitwise AND: Vx = Vx & Vy, then clears VF under logicResetsVF. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_8xy2();
  
-     /** @brief Performs bitwise XOR: Vx = Vx ^ Vy. */
+     /** @brief Performs bitwise XOR: Vx = Vx ^ Vy, then clears VF under logicResetsVF. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_8xy3();
  
      /** @brief Adds Vx and Vy, storing result in Vx and setting VF if overflow occurs. */
@@ -104,13 +293,15 @@
      /** @brief Subtracts Vy from Vx, storing result in Vx and setting VF to NOT borrow. */
      void OP_8xy5();
  
-     /** @brief Shifts Vx right by 1, storing the least significant bit in VF. */
+     /** @brief Shifts Vx (Vy under shiftReadsVy) right by 1 into Vx, storing the least significant bit in VF. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_8xy6();
  
      /** @brief Sets Vx = Vy - Vx, setting VF to NOT borrow. */
      void OP_8xy7();
  
-     /** @brief Shifts Vx left by 1, storing the most significant bit in VF. */
+     /** @brief Shifts Vx (Vy under shiftReadsVy) left by 1 into Vx, storing the most significant bit in VF. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_8xyE();
  
      /** @brief Skips next instruction if Vx != Vy. */
@@ -119,7 +310,8 @@
      /** @brief Sets I = NNN. */
      void OP_Annn();
  
-     /** @brief Jumps to location NNN + V0. */
+     /** @brief Jumps to location NNN + V0 (XNN + Vx under jumpAddsVx). */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_Bnnn();
  
      /** @brief Sets Vx = random byte & kk. */
@@ -129,7 +321,10 @@
       * @brief Draws a sprite at coordinate (Vx, Vy).
       * @details The sprite is `n` bytes in height and starts at memory location I.
       * VF is set to 1 if any pixels are erased due to collision.
+      * The origin wraps around the screen, the parts of the sprite past the edges are clipped
+      * (wrapped around under spritesWrap).
       */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_Dxyn();
  
      /** @brief Skips next instruction if key Vx is pressed. */
@@ -169,10 +364,12 @@
       */
      void OP_Fx33();
  
-     /** @brief Stores registers V0 through Vx in memory starting at I. */
+     /** @brief Stores registers V0 through Vx in memory starting at I, then I += x + 1 under memoryAdvancesIndex. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_Fx55();
  
-     /** @brief Reads registers V0 through Vx from memory starting at I. */
+     /** @brief Reads registers V0 through Vx from memory starting at I, then I += x + 1 under memoryAdvancesIndex. */
+     template<Chip8Quirks Quirks = Chip8Quirks{}>
      void OP_Fx65();
  
      /** @brief Handles OP_00E* opcode. */
@@ -190,8 +387,52 @@
      /** @brief Handles unimplemented opcodes (NOP). */
      void OP_NULL(){};
  
-     /** @brief Executes one cycle of the CHIP-8 CPU. */
+     /**
+      * @brief Executes one cycle of the CHIP-8 CPU.
+      * @details The timers are not touched, they run at 60 Hz through TickTimers().
+      */
      void Cycle();
+
+     /**
+      * @brief Executes several cycles back to back with the selected engine.
+      * @details Equivalent to calling Cycle() `cycles` times, but the engine is only
+      * selected once, which keeps the dispatch loop tight.
+      * @param cycles Number of instructions to execute.
+      */
+     void Run(uint64_t cycles);
+
+     /**
+      * @brief Fast-forwards through an idle loop instead of interpreting it.
+      * @details Counts the next instructions that would leave the machine exactly as it is
+      * (whole iterations of the loop reported by get_idle_state()), to be accounted as executed
+      * by the caller. Keys and timers must not change over those instructions, so the caller
+      * stops at the next timer tick or input event.
+      * @param cycles Maximum number of instructions to skip.
+      * @return The number of instructions skipped, 0 when running.
+      */
+     uint64_t SkipIdleCycles(uint64_t cycles) const;
+
+     /**
+      * @brief Decrements the delay and sound timers if they are set.
+      * @details Called once per 60 Hz frame by the Scheduler, independently of the instruction rate.
+      */
+     void TickTimers();
+
+     // ====== Profiling ======
+
+     /**
+      * @brief Starts counting the executed instructions per handler and per PC.
+      * @details Only available in builds defining CHIP8_PROFILE (CMake option ENABLE_PROFILING),
+      * throws otherwise. A profiled JIT CPU runs the block interpreter.
+      * @param timing True to also measure the host time of every handler.
+      */
+     void EnableProfiling(bool timing = false);
+
+     /**
+      * @brief Get the execution profile.
+      * @return The profiler, nullptr unless EnableProfiling() was called.
+      */
+     inline const Profiler* get_profiler() const { return this->profiler.get(); }
  
  private:
      // CHIP-8 CPU registers, memory, and peripherals
@@ -204,23 +445,101 @@
      uint8_t delayTimer; /**< Delay timer. */
      uint8_t soundTimer; /**< Sound timer. */
      std::array<uint8_t, NUM_KEYS> keypad; /**< Keypad state (16 keys). */
-     std::array<uint32_t, VIDEO_HEIGHT * VIDEO_WIDTH> video; /**< 64x32 monochrome display. */
+     std::array<uint64_t, VIDEO_HEIGHT> video; /**< 64x32 monochrome display, one bit per pixel (bit 63 is x = 0). */
      uint16_t opcode; /**< Current opcode being executed. */
      
      bool draw_flag; /**< Flag indicating if the display needs updating. */
+     uint64_t dirtyRows; /**< Rows touched since the last ClearDirty(), bit `n` for row `n`. */
  
-     /** @brief Random number generator engine. */
-     std::default_random_engine randGen;
-
-     /** 
-      * @brief Uniform distribution for random number generation.
-      * @details Used for generating random bytes, typically in the OP_Cxkk instruction.
-      */
-     std::uniform_int_distribution<unsigned int> randByte;
+     /** @brief Random byte generator of OP_Cxkk, saved with the state. */
+     Chip8Rng rng{DEFAULT_RNG_SEED};
 
      /** @brief Typedef for CHIP-8 opcode function pointers. */
      using Chip8Func = void (Chip8::*)();
 
+     /** @brief Execution profile, only fed by CHIP8_PROFILE builds. */
+     std::unique_ptr<Profiler> profiler;
+
+     /**
+      * @brief Calls the handler of the fetched instruction.
+      * @details Without CHIP8_PROFILE this is the bare call, the profiling hook compiles to nothing.
+      * @param handler Handler to call, the PC already points past the instruction.
+      */
+     inline void Execute(Chip8Func handler)
+     {
+ #ifdef CHIP8_PROFILE
+         if (profiler)
+         {
+             ExecuteProfiled(handler);
+             return;
+         }
+ #endif
+         ((*this).*handler)();
+     }
+
+     /**
+      * @brief Calls a handler and records it in the profiler.
+      * @param handler Handler to call.
+      */
+     void ExecuteProfiled(Chip8Func handler);
+
+     /**
+      * @brief Instruction decoded once from memory.
+      * @details The operands stay packed in `opcode` so an entry is 4 bytes and the whole
+      * cache fits in 16KB. `handler` indexes the `handlers` table, 0 meaning "not decoded yet".
+      */
+     struct DecodedOp
+     {
+         uint16_t opcode;
+         uint8_t handler;
+     };
+
+     Chip8Engine engine; /**< Dispatch strategy selected at construction. */
+
+     Chip8QuirkProfile quirkProfile; /**< Interpreter emulated, selected at construction. */
+
+     Chip8Quirks quirks; /**< Quirks of `quirkProfile`, read when translating code (JIT). */
+
+     /**
+      * @brief Decoded instruction for every memory address (Predecoded engine).
+      * @details Indexed by address since a jump may land on an odd byte.
+      */
+     std::array<DecodedOp, MEMORY_SIZE> decoded{};
+
+     /**
+      * @brief Leaf handlers referenced by DecodedOp::handler.
+      * @details Entry 0 is OP_Decode, so an invalidated entry decodes itself on its next fetch.
+      */
+     std::array<Chip8Func, 0x30> handlers{};
+
+     /** @brief Number of used entries in `handlers`. */
+     uint8_t handlerCount = 0;
+
+     /**
+      * @brief Location of a cached basic block in `blockOps`.
+      * @details A length of 0 means no block was built at this address yet.
+      */
+     struct BlockRef
+     {
+         uint16_t first;
+         uint8_t length;
+     };
+
+     /** @brief Cached basic block starting at every memory address (Block engine). */
+     std::array<BlockRef, MEMORY_SIZE> blocks{};
+
+     /** @brief Decoded instructions of all cached blocks, stored back to back. */
+     std::array<DecodedOp, BLOCK_POOL_SIZE> blockOps{};
+
+     /** @brief Number of used entries in `blockOps`. */
+     uint16_t blockOpsUsed = 0;
+
+     /** @brief Bytes of memory read by at least one cached block. */
+     std::bitset<MEMORY_SIZE> blockCode;
+
+     /** @brief Native code cache, only allocated by the Jit engine. */
+     std::unique_ptr<Chip8Jit> jit;
+
      /** 
       * @brief Main opcode function table (0x0 - 0xF).
       * @details Maps opcode prefixes to their corresponding handler functions.
@@ -251,12 +570,6 @@
       */
      std::array<Chip8Func, 0x66> tableF{};
 
-     /** 
-      * @brief Checks and processes the ROM file before loading it.
-      * @param filename Path to the ROM file.
-      * @return A vector containing the ROM's binary data.
-      */
-     std::vector<uint8_t> filenameHandling(const std::string& filename);
 
      /** @brief Initializes CHIP-8 system components (memory, registers, etc.). */
      void InitChip8();
@@ -264,8 +577,59 @@
      /** @brief Initializes opcode function tables. */
      void InitializeTables();
 
+     /** @brief Points the quirk-dependent table entries to their specialization for `Quirks`. */
+     template<Chip8Quirks Quirks>
+     void InitializeQuirkTables();
+
+     /**
+      * @brief Resolves an opcode to its leaf handler through the opcode tables.
+      * @param instruction The 16-bit opcode to decode.
+      * @return The handler that Cycle() would end up calling for this opcode.
+      */
+     Chip8Func Decode(uint16_t instruction) const;
+
+     /**
+      * @brief Finds (or registers) the index of a leaf handler in `handlers`.
+      * @param func Leaf handler returned by Decode().
+      * @return Index usable in DecodedOp::handler.
+      */
+     uint8_t HandlerIndex(Chip8Func func);
+
+     /**
+      * @brief Tells whether a handler must be the last instruction of a basic block.
+      * @details True for everything that changes the PC (jumps, calls, returns, skips,
+      * key wait) and for the memory writes that may modify code (Fx33, Fx55).
+      */
+     bool EndsBlock(Chip8Func func) const;
+
+     /**
+      * @brief Decodes the basic block starting at an address and caches it.
+      * @param address Address of the first instruction of the block.
+      * @return The cached block.
+      */
+     BlockRef BuildBlock(uint16_t address);
+
+     /** @brief Drops every cached basic block. */
+     void FlushBlocks();
+
+     /** @brief Decodes the instruction at PC - 2 into the cache, then executes it. */
+     void OP_Decode();
+
+     /**
+      * @brief Drops cached decodes overlapping a memory write.
+      * @param address First written byte.
+      * @param length Number of written bytes.
+      */
+     void InvalidateCode(uint16_t address, uint16_t length);
+
      /** @brief Allows TestChip8 to access private members for unit testing. */
      friend class TestChip8;
 
+     /** @brief Allows the JIT to translate blocks against the CPU state layout. */
+     friend class Chip8Jit;
+
+     /** @brief Allows the lockstep engine to run the handlers on its per-lane machines. */
+     friend class VectorMachine;
+
  };
  
\ No newline at end of file
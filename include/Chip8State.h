@@ -0,0 +1,57 @@
+/**
+ * @file Chip8State.h
+ * @brief Save-state layout of the CHIP-8 CPU
+ *
+ * This file contains the declaration of the Chip8State structure, a flat and versioned copy of
+ * the whole machine state. It is trivially copyable, so a snapshot is a single memcpy and a
+ * save-state file is the structure itself.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <array>
+#include <type_traits>
+
+#include "Chip8_common.h"
+
+/** @brief Magic number starting every save state ("C8ST" in little-endian). */
+const uint32_t CHIP8_STATE_MAGIC = 0x54533843;
+
+/** @brief Layout version of Chip8State, bumped on every layout change. */
+const uint16_t CHIP8_STATE_VERSION = 2;
+
+/** @brief Bytes reserved for the random generator state. */
+const unsigned int CHIP8_STATE_RNG_SIZE = 32;
+
+/**
+ * @brief Flat snapshot of a Chip8.
+ * @details The derived caches (decoded instructions, blocks, native code) are not saved,
+ * they are rebuilt after Chip8::LoadState(). The layout is the host one: save states are
+ * portable between builds of the same version on hosts of the same endianness.
+ */
+struct Chip8State
+{
+    uint32_t magic = CHIP8_STATE_MAGIC;         /**< CHIP8_STATE_MAGIC. */
+    uint16_t version = CHIP8_STATE_VERSION;     /**< CHIP8_STATE_VERSION. */
+    uint16_t size = 0;                          /**< sizeof(Chip8State), checked on load. */
+
+    std::array<uint8_t, MEMORY_SIZE> memory;    /**< Memory (4KB). */
+    std::array<uint64_t, VIDEO_HEIGHT> video;   /**< Packed display, one bit per pixel. */
+    std::array<uint16_t, STACK_SIZE> stack;     /**< Return addresses. */
+    std::array<uint8_t, NUM_REGISTERS> registers; /**< V0 to VF. */
+    std::array<uint8_t, NUM_KEYS> keypad;       /**< Keys held down. */
+    std::array<uint8_t, CHIP8_STATE_RNG_SIZE> rng; /**< Raw state of the Chip8Rng generator. */
+
+    uint16_t index;         /**< Index register (I). */
+    uint16_t pc;            /**< Program counter. */
+    uint16_t opcode;        /**< Last executed instruction. */
+    uint8_t sp;             /**< Stack pointer. */
+    uint8_t delayTimer;     /**< Delay timer. */
+    uint8_t soundTimer;     /**< Sound timer. */
+    std::array<uint8_t, 7> reserved{}; /**< Zero, keeps the structure free of padding. */
+};
+
+static_assert(std::is_trivially_copyable_v<Chip8State>, "Chip8State must be memcpy-able");
+static_assert(std::has_unique_object_representations_v<Chip8State>, "Chip8State must not have padding");
+static_assert(sizeof(Chip8State) < 5 * 1024, "Chip8State must stay under 5KB");
@@ -35,6 +35,24 @@ const unsigned int VIDEO_WIDTH = 64;
 /** @brief Height of the CHIP-8 display (in pixels). */
 const unsigned int VIDEO_HEIGHT = 32;
 
+/** @brief Maximum number of instructions in a cached basic block. */
+const unsigned int MAX_BLOCK_LENGTH = 32;
+
+/** @brief Number of decoded instructions the basic block cache can hold before being flushed. */
+const unsigned int BLOCK_POOL_SIZE = 4096;
+
+/** @brief Dirty row mask covering the whole display. */
+const uint64_t ALL_ROWS_DIRTY = VIDEO_HEIGHT >= 64 ? ~0ULL : (1ULL << VIDEO_HEIGHT) - 1;
+
+/** @brief Size of a cache line, data written by different threads never shares one. */
+const std::size_t CACHE_LINE_SIZE = 64;
+
+/** @brief RGBA8888 colour of a lit pixel. */
+const uint32_t PIXEL_ON_COLOR = 0xFFFFFFFF;
+
+/** @brief RGBA8888 colour of an unlit pixel. */
+const uint32_t PIXEL_OFF_COLOR = 0x00000000;
+
 /** @brief Total size of the CHIP-8 fontset (in bytes). */
 const unsigned int FONTSET_SIZE = 80;
 
@@ -69,3 +87,69 @@ const unsigned int STACK_SIZE = 16;
 
 /** @brief Number of keys in the CHIP-8 hexadecimal keypad (0-F). */
 const unsigned int NUM_KEYS = 16;
+
+/**
+ * @brief What a CPU core is doing, as far as skipping instructions is concerned.
+ */
+enum class Chip8IdleState
+{
+    Running,            /**< Making progress, or in a loop that is not recognized. */
+    Halted,             /**< Jumping to itself (or off memory), nothing will ever change. */
+    WaitingForKey,      /**< Spinning on Fx0A with no key down, only input releases it. */
+    WaitingForTimer     /**< Polling the delay timer (Fx07, 3xkk/4xkk, 1nnn), only a tick releases it. */
+};
+
+// ====== SUPER-CHIP / XO-CHIP ======
+
+/** @brief Total size of the XO-CHIP memory (64KB). */
+const unsigned int XO_MEMORY_SIZE = 0x10000;
+
+/** @brief Width of the hi-res display (in pixels), the lo-res one keeps VIDEO_WIDTH. */
+const unsigned int XO_VIDEO_WIDTH = 128;
+
+/** @brief Height of the hi-res display (in pixels), the lo-res one keeps VIDEO_HEIGHT. */
+const unsigned int XO_VIDEO_HEIGHT = 64;
+
+/** @brief Number of 64-bit words of a packed hi-res row. */
+const unsigned int XO_ROW_WORDS = XO_VIDEO_WIDTH / 64;
+
+/** @brief Number of XO-CHIP bit-planes. */
+const unsigned int XO_PLANE_COUNT = 2;
+
+/** @brief Number of persistent flag registers (Fx75/Fx85). */
+const unsigned int XO_FLAG_COUNT = 16;
+
+/** @brief Size (in bytes) of each character in the big fontset. */
+const unsigned int BIG_FONT_SIZE = 10;
+
+/** @brief Memory address where the big fontset starts, right after the small one. */
+const unsigned int BIG_FONTSET_START_ADDRESS = FONTSET_START_ADDRESS + FONTSET_SIZE;
+
+/** @brief Total size of the big fontset (in bytes). */
+const unsigned int BIG_FONTSET_SIZE = 16 * BIG_FONT_SIZE;
+
+/**
+ * @brief SUPER-CHIP 8x10 fontset, extended to A-F as in XO-CHIP.
+ * @details Selected by Fx30.
+ */
+constexpr std::array<uint8_t, BIG_FONTSET_SIZE> bigFontset = {
+    0xFF, 0xFF, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF,  // 0
+    0x18, 0x78, 0x78, 0x18, 0x18, 0x18, 0x18, 0x18, 0xFF, 0xFF,  // 1
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,  // 2
+    0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,  // 3
+    0xC3, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0x03, 0x03,  // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,  // 5
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,  // 6
+    0xFF, 0xFF, 0x03, 0x03, 0x06, 0x0C, 0x18, 0x18, 0x18, 0x18,  // 7
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF,  // 8
+    0xFF, 0xFF, 0xC3, 0xC3, 0xFF, 0xFF, 0x03, 0x03, 0xFF, 0xFF,  // 9
+    0x7E, 0xFF, 0xC3, 0xC3, 0xC3, 0xFF, 0xFF, 0xC3, 0xC3, 0xC3,  // A
+    0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC, 0xC3, 0xC3, 0xFC, 0xFC,  // B
+    0x3C, 0xFF, 0xC3, 0xC0, 0xC0, 0xC0, 0xC0, 0xC3, 0xFF, 0x3C,  // C
+    0xFC, 0xFE, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xC3, 0xFE, 0xFC,  // D
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF,  // E
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFF, 0xFF, 0xC0, 0xC0, 0xC0, 0xC0   // F
+};
+
+/** @brief RGBA8888 colours of the four plane combinations (none, plane 1, plane 2, both). */
+constexpr std::array<uint32_t, 4> XO_DEFAULT_PALETTE = {PIXEL_OFF_COLOR, PIXEL_ON_COLOR, 0xFF5555FF, 0x555555FF};
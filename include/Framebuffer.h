@@ -0,0 +1,51 @@
+/**
+ * @file Framebuffer.h
+ * @brief Conversion of the packed CHIP-8 framebuffer to RGBA8888 pixels
+ *
+ * This file contains the functions expanding the 1 bit per pixel display rows of the CHIP-8,
+ * and the two bit-planes of the XO-CHIP, into the 32-bit pixel layout of the SDL streaming texture.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "Chip8_common.h"
+
+/**
+ * @brief Expands packed display rows into RGBA8888 pixels.
+ * @details Uses AVX2 or SSE2 when the host supports them, the scalar version otherwise.
+ * @param rows Packed rows, one bit per pixel, bit 63 being the leftmost pixel.
+ * @param rowCount Number of rows to expand.
+ * @param pixels Destination of the first pixel of the first row.
+ * @param pitch Distance in bytes between two destination rows.
+ * @param onColor Colour of the lit pixels.
+ * @param offColor Colour of the unlit pixels.
+ */
+void ExpandFramebuffer(const uint64_t* rows, unsigned int rowCount, uint32_t* pixels, int pitch,
+                       uint32_t onColor = PIXEL_ON_COLOR, uint32_t offColor = PIXEL_OFF_COLOR);
+
+/**
+ * @brief Portable version of ExpandFramebuffer().
+ * @details Same parameters and output, used as fallback and as reference.
+ */
+void ExpandFramebufferScalar(const uint64_t* rows, unsigned int rowCount, uint32_t* pixels, int pitch,
+                             uint32_t onColor = PIXEL_ON_COLOR, uint32_t offColor = PIXEL_OFF_COLOR);
+
+/**
+ * @brief Expands the two XO-CHIP bit-planes into RGBA8888 pixels.
+ * @details Each plane is read one 64-bit word at a time and shifted out pixel by pixel, an empty
+ * word is a single fill. In lo-res every pixel is doubled and every row is copied once.
+ * @param plane0 Packed rows of plane 1, XO_ROW_WORDS words per row.
+ * @param plane1 Packed rows of plane 2, same layout.
+ * @param hires True in 128x64, false in 64x32 (first word of the first VIDEO_HEIGHT rows).
+ * @param firstRow First row to expand, in XO_VIDEO_HEIGHT output rows.
+ * @param rowCount Number of output rows to expand.
+ * @param pixels Destination of the first pixel of the first row, XO_VIDEO_WIDTH pixels per row.
+ * @param pitch Distance in bytes between two destination rows.
+ * @param palette Colours of the four plane combinations, plane 1 being bit 0.
+ */
+void ExpandPlanes(const uint64_t* plane0, const uint64_t* plane1, bool hires, unsigned int firstRow,
+                  unsigned int rowCount, uint32_t* pixels, int pitch,
+                  const std::array<uint32_t, 4>& palette = XO_DEFAULT_PALETTE);
@@ -0,0 +1,30 @@
+/**
+ * @file InputQueue.h
+ * @brief Timestamped key events between the input thread and the CPU
+ *
+ * This file contains the KeyEvent structure and the InputQueue ring that carries them from the
+ * SDL event handling to the Scheduler, which applies each change at the instruction matching its
+ * host time. Both sides may run on different threads, neither locks nor allocates.
+ */
+
+#pragma once
+
+#include "SpscRing.h"
+#include <chrono>
+#include <cstdint>
+
+/** @brief Number of key changes the input side can queue ahead of the CPU. */
+const std::size_t INPUT_QUEUE_CAPACITY = 64;
+
+/**
+ * @brief Key press or release, stamped with the host time it happened at.
+ */
+struct KeyEvent
+{
+    std::chrono::steady_clock::time_point time; /**< Host time of the change. */
+    uint8_t key = 0;                            /**< Key number (0x0 to 0xF). */
+    bool pressed = false;                       /**< True for a press, false for a release. */
+};
+
+/** @brief Fixed-capacity lock-free queue of key changes, one producer and one consumer. */
+using InputQueue = SpscRing<KeyEvent, INPUT_QUEUE_CAPACITY>;
@@ -0,0 +1,107 @@
+/**
+ * @file Jit.h
+ * @brief x86-64 JIT backend for the CHIP-8 CPU
+ *
+ * This file contains the declaration of the Chip8Jit class, which translates CHIP-8 basic blocks
+ * into native x86-64 code. Instructions that are not translated are executed through the
+ * interpreter handlers, so the JIT always produces the same machine state as Chip8::Cycle().
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <initializer_list>
+
+#include "Chip8_common.h"
+
+class Chip8;
+
+/** @brief Size (in bytes) of the executable buffer holding translated blocks. */
+const std::size_t JIT_CODE_SIZE = 1024 * 1024;
+
+/**
+ * @class Chip8Jit
+ * @brief Translates and caches CHIP-8 basic blocks as native functions.
+ *
+ * Translated code keeps a pointer to the Chip8 object in a callee-saved register and reads and
+ * writes `registers`, `index` and `pc` in place. It is only available on x86-64
+ * POSIX hosts, elsewhere available() is false and the CPU falls back to the block interpreter.
+ */
+class Chip8Jit
+{
+public:
+    /** @brief Signature of a translated block. */
+    using BlockFunc = void (*)(Chip8*);
+
+    /** @brief Translated block cached for an address. */
+    struct Entry
+    {
+        BlockFunc code;     /**< Native code, nullptr if not translated yet. */
+        uint8_t length;     /**< Number of CHIP-8 instructions executed by `code`. */
+    };
+
+    /**
+     * @brief Maps the executable buffer.
+     * @param capacity Size of the buffer in bytes.
+     */
+    explicit Chip8Jit(std::size_t capacity = JIT_CODE_SIZE);
+
+    /** @brief Unmaps the executable buffer. */
+    ~Chip8Jit();
+
+    Chip8Jit(const Chip8Jit&) = delete;
+    Chip8Jit& operator=(const Chip8Jit&) = delete;
+
+    /**
+     * @brief Tells whether native code can be generated on this host.
+     * @return True if the executable buffer was mapped.
+     */
+    inline bool available() const { return code != nullptr; }
+
+    /**
+     * @brief Returns the translated block starting at an address.
+     * @param address Address of the first instruction.
+     * @return The cached entry, with a null `code` if not translated yet.
+     */
+    inline const Entry& Lookup(uint16_t address) const { return entries[address]; }
+
+    /**
+     * @brief Translates the basic block starting at an address.
+     * @param chip8 CPU owning the memory and the block discovery.
+     * @param address Address of the first instruction.
+     * @return The new entry.
+     */
+    const Entry& Compile(Chip8& chip8, uint16_t address);
+
+    /** @brief Drops every translated block. */
+    void Flush();
+
+private:
+    uint8_t* code = nullptr;    /**< Executable buffer. */
+    std::size_t capacity = 0;   /**< Size of `code` in bytes. */
+    std::size_t used = 0;       /**< Bytes of `code` already holding translated blocks. */
+    std::size_t cursor = 0;     /**< Write position while emitting a block. */
+
+    std::array<Entry, MEMORY_SIZE> entries{}; /**< Translated block for every address. */
+
+    /**
+     * @brief Executes one instruction through its interpreter handler.
+     * @details Called from translated code for every instruction without a native translation.
+     */
+    static void Interpret(Chip8* chip8, uint32_t instruction, uint32_t handler);
+
+    void Emit8(uint8_t value);
+    void Emit16(uint16_t value);
+    void Emit32(uint32_t value);
+    void Emit64(uint64_t value);
+
+    /**
+     * @brief Emits `op [rbx + disp32]` with the given register in the ModRM reg field.
+     * @param op Opcode bytes (1 to 3).
+     * @param reg Register number or opcode extension.
+     * @param displacement Offset from the Chip8 object.
+     */
+    void EmitMem(std::initializer_list<uint8_t> op, uint8_t reg, int32_t displacement);
+};
@@ -0,0 +1,157 @@
+/**
+ * @file Movie.h
+ * @brief Input recording and replay
+ *
+ * This file contains the declaration of the Movie format and of the MovieRecorder and
+ * MoviePlayer classes. A movie is the list of keypad changes of a session, timestamped in
+ * executed instructions, together with the seed, the speed, the quirks and the ROM it was
+ * recorded with.
+ * Replaying it under the FixedRatio scheduler reproduces the session without SDL.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Chip8_common.h"
+#include "Quirks.h"
+
+class Chip8;
+class XoChip;
+
+/** @brief Magic number starting every movie file ("C8MV" in little-endian). */
+const uint32_t CHIP8_MOVIE_MAGIC = 0x564D3843;
+
+/** @brief Version of the movie file format. */
+const uint16_t CHIP8_MOVIE_VERSION = 2;
+
+/**
+ * @brief Scripted key press or release.
+ */
+struct InputEvent
+{
+    uint64_t cycle;     /**< Instruction count at which the event applies. */
+    uint8_t key;        /**< Key number (0x0 to 0xF). */
+    bool pressed;       /**< True for a press, false for a release. */
+};
+
+/**
+ * @brief Recorded input session.
+ * @details On disk: a 32-byte little-endian header (magic, version, quirk profile, seed, ROM hash,
+ * instructions per frame, event count), then one event per key change: the cycles since the previous event
+ * as a LEB128 varint and one byte holding the key and, in bit 7, the press. A key change costs
+ * two or three bytes.
+ */
+struct Movie
+{
+    uint64_t seed = 0;                      /**< Seed of the Cxkk random generator. */
+    uint64_t romHash = 0;                   /**< HashRom() of the ROM played. */
+    uint32_t instructionsPerFrame = 0;      /**< Instructions between two timer ticks. */
+    Chip8QuirkProfile quirks = Chip8QuirkProfile::Default; /**< Quirks the session ran with. */
+    std::vector<InputEvent> events;         /**< Key changes, sorted by cycle. */
+
+    /**
+     * @brief Writes the movie to a file.
+     * @param filename Path of the movie.
+     */
+    void Save(const std::string& filename) const;
+
+    /**
+     * @brief Reads a movie file.
+     * @param filename Path of a file written by Save().
+     * @return The movie.
+     */
+    static Movie Load(const std::string& filename);
+
+    /**
+     * @brief Hashes a ROM image (FNV-1a), to detect a movie replayed on another ROM.
+     * @param rom ROM contents.
+     * @return The 64-bit hash of the image.
+     */
+    static uint64_t HashRom(std::span<const uint8_t> rom);
+};
+
+/**
+ * @class MovieRecorder
+ * @brief Builds a Movie from the successive keypad states of a session.
+ */
+class MovieRecorder
+{
+public:
+    /**
+     * @brief Starts an empty recording.
+     * @param seed Seed of the recorded CPU.
+     * @param instructionsPerFrame Speed of the recorded session.
+     * @param rom ROM played.
+     * @param quirks Quirk profile of the recorded CPU.
+     */
+    MovieRecorder(uint64_t seed, unsigned int instructionsPerFrame, std::span<const uint8_t> rom,
+                  Chip8QuirkProfile quirks = Chip8QuirkProfile::Default);
+
+    /**
+     * @brief Get the recording.
+     * @return The movie recorded so far.
+     */
+    inline const Movie& get_movie() const { return this->movie; }
+
+    /**
+     * @brief Records the keys that changed since the previous call.
+     * @param cycle Instructions executed so far, not lower than at the previous call.
+     * @param keypad Current keypad state.
+     */
+    void Record(uint64_t cycle, std::span<const uint8_t, NUM_KEYS> keypad);
+
+private:
+    Movie movie;                                /**< Recording. */
+    std::array<uint8_t, NUM_KEYS> keys{};       /**< Keypad state at the previous Record(). */
+};
+
+/**
+ * @class MoviePlayer
+ * @brief Feeds recorded key changes to a Chip8 or XoChip in place of the SDL input.
+ *
+ * The driver runs the CPU up to get_next_cycle(), then calls Apply() with the instruction count,
+ * so every event lands on the exact instruction it was recorded at.
+ */
+class MoviePlayer
+{
+public:
+    /**
+     * @brief Starts a replay.
+     * @param events Key changes sorted by cycle, must outlive the player.
+     */
+    explicit MoviePlayer(std::span<const InputEvent> events);
+
+    /**
+     * @brief Get the timestamp of the next event.
+     * @return The cycle of the next event, or the maximum value once every event was applied.
+     */
+    inline uint64_t get_next_cycle() const
+    {
+        return this->next < this->events.size() ? this->events[this->next].cycle : std::numeric_limits<uint64_t>::max();
+    }
+
+    /**
+     * @brief Tells whether every event was applied.
+     * @return True at the end of the movie.
+     */
+    inline bool is_finished() const { return this->next == this->events.size(); }
+
+    /**
+     * @brief Applies the events due.
+     * @tparam Core Chip8 or XoChip.
+     * @param core CPU receiving the key changes.
+     * @param cycle Instructions executed so far.
+     */
+    template<typename Core>
+    void Apply(Core& core, uint64_t cycle);
+
+private:
+    std::span<const InputEvent> events; /**< Key changes. */
+    std::size_t next = 0;               /**< Index of the next event. */
+};
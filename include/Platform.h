@@ -9,7 +9,11 @@
 #pragma once
 
 #include "Chip8_common.h"
+#include "InputQueue.h"
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <SDL2/SDL.h>
 
 /**
@@ -43,6 +47,37 @@ public:
      */
     void Update(const void* buffer, int pitch);
 
+    /**
+     * @brief Updates the display from the packed CHIP-8 framebuffer.
+     * @details The dirty rows are expanded straight into the locked streaming texture,
+     * with the colours set by SetColors(). Nothing is uploaded nor presented when no row is dirty.
+     *
+     * @param rows One word per row, one bit per pixel, bit 63 being the leftmost pixel.
+     * @param dirtyRows Rows to upload, bit `n` for row `n`.
+     */
+    void UpdatePacked(const uint64_t* rows, uint64_t dirtyRows = ALL_ROWS_DIRTY);
+
+    /** @brief Writes `rowCount` texture rows from `firstRow` into `pixels`, `pitch` bytes apart. */
+    using RowWriter = std::function<void(unsigned int firstRow, unsigned int rowCount, uint32_t* pixels, int pitch)>;
+
+    /**
+     * @brief Updates the display with rows drawn straight into the texture.
+     * @details Used by the cores whose display is not a single packed plane (see XoChip::ExpandVideo()).
+     * Nothing is uploaded nor presented when no row is dirty.
+     *
+     * @param dirtyRows Texture rows to upload, bit `n` for row `n`.
+     * @param write Draws the span of rows from the first to the last dirty one.
+     */
+    void UpdateRows(uint64_t dirtyRows, const RowWriter& write);
+
+    /**
+     * @brief Sets the colours used by UpdatePacked().
+     *
+     * @param on RGBA8888 colour of the lit pixels.
+     * @param off RGBA8888 colour of the unlit pixels.
+     */
+    void SetColors(uint32_t on, uint32_t off);
+
     /**
      * @brief Processes user input and updates the CHIP-8 keypad state.
      * 
@@ -51,10 +86,45 @@ public:
      */
     bool ProcessInput(uint8_t* keys);
 
+    /**
+     * @brief Processes user input and queues the keypad changes for the CPU.
+     * @details Each change keeps the host time SDL saw it at, so a press and a release polled
+     * together are both delivered, in order, to the Scheduler reading the queue. Keyboard
+     * auto-repeat is ignored. When the queue is full, the latest state of each key waits here and
+     * is queued again by the next calls, so a release is never lost.
+     *
+     * @param input Queue of key changes, this thread being its only producer.
+     * @return True if the user wants to quit, otherwise false.
+     */
+    bool ProcessInput(InputQueue& input);
+
+    /**
+     * @brief Tells whether the rewind key (Backspace) is held down.
+     * @return True while the user asks to go back in time, updated by ProcessInput().
+     */
+    inline bool is_rewinding() const { return this->rewinding; }
+
 private:
     friend class TestPlatform; /**< Allows unit tests to access private members. */
 
+    /** @brief Receives a keypad change: key number, new state and host time. */
+    using KeyHandler = std::function<void(uint8_t, bool, std::chrono::steady_clock::time_point)>;
+
+    /**
+     * @brief Polls the pending SDL events, handling quit and rewind.
+     * @param onKey Called for every change of a keypad key.
+     * @return True if the user wants to quit, otherwise false.
+     */
+    bool PollEvents(const KeyHandler& onKey);
+
     SDL_Window* window{};   /**< Pointer to the SDL window. */
     SDL_Renderer* renderer{}; /**< Pointer to the SDL renderer. */
     SDL_Texture* texture{}; /**< Pointer to the SDL texture used for rendering. */
+    int textureWidth{};     /**< Number of columns of the texture. */
+    int textureHeight{};    /**< Number of rows of the texture. */
+    uint32_t onColor = PIXEL_ON_COLOR;   /**< Colour of the lit pixels. */
+    uint32_t offColor = PIXEL_OFF_COLOR; /**< Colour of the unlit pixels. */
+    bool rewinding = false; /**< True while the rewind key is held down. */
+    uint16_t unsentKeys = 0; /**< Keys whose change did not fit in the queue, bit `n` for key `n`. */
+    std::array<KeyEvent, NUM_KEYS> unsent{}; /**< Latest change of each key flagged in `unsentKeys`. */
 };
@@ -0,0 +1,138 @@
+/**
+ * @file Profiler.h
+ * @brief Per-opcode execution profiler
+ *
+ * This file contains the declaration of the Profiler class, which counts the instructions
+ * executed per opcode handler and per address, and optionally the host time spent in each
+ * handler. The dispatch hooks feeding it only exist in builds defining CHIP8_PROFILE
+ * (CMake option ENABLE_PROFILING); other builds dispatch exactly as before.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+#include "Chip8_common.h"
+
+/** @brief Number of opcode handlers told apart by the profiler, OP_NULL included. */
+const unsigned int PROFILER_HANDLER_COUNT = 35;
+
+/** @brief Number of hot addresses listed by Profiler::WriteReport(). */
+const unsigned int PROFILER_HOT_PC_COUNT = 16;
+
+/** @brief File written by the front ends with Profiler::WriteFolded(). */
+const char* const PROFILER_FOLDED_FILENAME = "chip8_profile.folded";
+
+/** @brief True when the dispatch hooks are compiled in. */
+#ifdef CHIP8_PROFILE
+const bool CHIP8_PROFILING = true;
+#else
+const bool CHIP8_PROFILING = false;
+#endif
+
+/**
+ * @class Profiler
+ * @brief Execution counts per opcode handler and per PC.
+ *
+ * Only the interpreted paths are observed: a CPU using the JIT engine runs the block
+ * interpreter while profiled, since native blocks cannot be split per instruction.
+ */
+class Profiler
+{
+public:
+    /**
+     * @brief Creates an empty profile.
+     * @param timing True to also measure the host time of every handler (slower).
+     */
+    explicit Profiler(bool timing = false) : timing(timing) {}
+
+    // ====== Getters of the class ======
+
+    /**
+     * @brief Tells whether handler times are measured.
+     * @return True if Record() is given host times.
+     */
+    inline bool is_timing() const { return this->timing; }
+
+    /**
+     * @brief Get the number of instructions executed.
+     * @return The sum of every handler count.
+     */
+    uint64_t get_total() const;
+
+    /**
+     * @brief Get the executions of the handler of an opcode.
+     * @param opcode Any instruction handled by the same OP_* handler.
+     * @return The number of executions of that handler.
+     */
+    inline uint64_t get_count(uint16_t opcode) const { return this->counts[Classify(opcode)]; }
+
+    /**
+     * @brief Get the executions of the instruction at an address.
+     * @param pc Address of the instruction.
+     * @return The number of executions at `pc`.
+     */
+    inline uint64_t get_pc_count(uint16_t pc) const { return this->pcCounts[pc % MEMORY_SIZE]; }
+
+    // ====== Recording ======
+
+    /**
+     * @brief Counts one executed instruction.
+     * @param opcode Instruction executed.
+     * @param pc Address it was fetched from.
+     * @param nanoseconds Host time of its handler, 0 when not timing.
+     */
+    inline void Record(uint16_t opcode, uint16_t pc, uint64_t nanoseconds = 0)
+    {
+        unsigned int handler = Classify(opcode);
+        ++this->counts[handler];
+        this->times[handler] += nanoseconds;
+        ++this->pcCounts[pc % MEMORY_SIZE];
+        this->pcTimes[pc % MEMORY_SIZE] += nanoseconds;
+        this->pcOpcodes[pc % MEMORY_SIZE] = opcode;
+    }
+
+    /** @brief Clears every count. */
+    void Reset();
+
+    // ====== Reports ======
+
+    /**
+     * @brief Writes the handlers sorted by executions (or by time when timing), then the hot PCs.
+     * @param out Stream receiving the text report.
+     */
+    void WriteReport(std::ostream& out) const;
+
+    /**
+     * @brief Writes the profile as folded stacks (`handler;pc weight` lines).
+     * @details The format of flamegraph.pl and speedscope, one frame per handler with its
+     * addresses on top. The weight is the host time in nanoseconds when timing, the execution
+     * count otherwise. An address is filed under the last handler it executed.
+     * @param out Stream receiving the folded stacks.
+     */
+    void WriteFolded(std::ostream& out) const;
+
+    /**
+     * @brief Get the name of the handler of an opcode.
+     * @param opcode Any instruction.
+     * @return The OP_* name, "OP_NULL" for invalid instructions.
+     */
+    static const char* HandlerName(uint16_t opcode);
+
+private:
+    bool timing;                                                /**< Handler times measured. */
+    std::array<uint64_t, PROFILER_HANDLER_COUNT> counts{};      /**< Executions per handler. */
+    std::array<uint64_t, PROFILER_HANDLER_COUNT> times{};       /**< Nanoseconds per handler. */
+    std::array<uint64_t, MEMORY_SIZE> pcCounts{};               /**< Executions per address. */
+    std::array<uint64_t, MEMORY_SIZE> pcTimes{};                /**< Nanoseconds per address. */
+    std::array<uint16_t, MEMORY_SIZE> pcOpcodes{};              /**< Last opcode seen per address. */
+
+    /**
+     * @brief Maps an opcode to its handler.
+     * @param opcode Any instruction.
+     * @return The handler index, below PROFILER_HANDLER_COUNT.
+     */
+    static unsigned int Classify(uint16_t opcode);
+};
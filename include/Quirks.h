@@ -0,0 +1,83 @@
+/**
+ * @file Quirks.h
+ * @brief CHIP-8 compatibility quirks
+ *
+ * Interpreters disagree on a handful of instructions and ROMs rely on the behaviour of the one
+ * they were written for. This file describes those behaviours as quirk sets, the profiles that
+ * group them, and how a profile is chosen for a ROM.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+
+/**
+ * @brief Behaviours that differ between CHIP-8 interpreters.
+ * @details Used as a template argument of the quirk-dependent Chip8 handlers, every field is
+ * resolved at compile time: a profile costs no check per instruction.
+ */
+struct Chip8Quirks
+{
+    bool shiftReadsVy = false;          /**< 8xy6/8xyE shift Vy into Vx, instead of Vx in place. */
+    bool memoryAdvancesIndex = false;   /**< Fx55/Fx65 leave I past the last register. */
+    bool jumpAddsVx = false;            /**< Bxnn jumps to xnn + Vx, instead of nnn + V0. */
+    bool logicResetsVF = false;         /**< 8xy1/8xy2/8xy3 clear VF. */
+    bool spritesWrap = false;           /**< Dxyn wraps sprites around the edges, instead of clipping. */
+};
+
+/**
+ * @brief Interpreters whose quirks are supported.
+ */
+enum class Chip8QuirkProfile
+{
+    Default,    /**< The behaviour of this emulator so far, right for most modern CHIP-8 ROMs. */
+    Cosmac,     /**< The original COSMAC VIP interpreter. */
+    SuperChip,  /**< SUPER-CHIP 1.1 on the HP 48. */
+    XoChip      /**< XO-CHIP (Octo). */
+};
+
+/**
+ * @brief Get the quirks of a profile.
+ * @param profile Interpreter to emulate.
+ * @return Its quirk set, usable as a template argument.
+ */
+constexpr Chip8Quirks QuirksOf(Chip8QuirkProfile profile)
+{
+    switch (profile)
+    {
+    case Chip8QuirkProfile::Cosmac:
+        return Chip8Quirks{.shiftReadsVy = true, .memoryAdvancesIndex = true, .logicResetsVF = true};
+    case Chip8QuirkProfile::SuperChip:
+        return Chip8Quirks{.jumpAddsVx = true};
+    case Chip8QuirkProfile::XoChip:
+        return Chip8Quirks{.shiftReadsVy = true, .memoryAdvancesIndex = true, .spritesWrap = true};
+    case Chip8QuirkProfile::Default:
+    default:
+        return Chip8Quirks{};
+    }
+}
+
+/**
+ * @brief Parses a profile name.
+ * @param name One of "default", "cosmac", "schip" or "xochip".
+ * @return The profile, throws std::runtime_error for an unknown name.
+ */
+Chip8QuirkProfile ParseQuirkProfile(const std::string& name);
+
+/**
+ * @brief Get the name of a profile.
+ * @param profile Profile to name.
+ * @return The name accepted by ParseQuirkProfile().
+ */
+const char* QuirkProfileName(Chip8QuirkProfile profile);
+
+/**
+ * @brief Guesses the interpreter a ROM was written for.
+ * @details Follows the control flow from START_ADDRESS, so sprite data is never mistaken for
+ * code, and looks for the instructions only SUPER-CHIP or XO-CHIP provide.
+ * @param rom ROM contents, as loaded at START_ADDRESS.
+ * @return XoChip or SuperChip when their instructions are reachable, Default otherwise.
+ */
+Chip8QuirkProfile DetectQuirkProfile(std::span<const uint8_t> rom);
@@ -0,0 +1,143 @@
+/**
+ * @file RewindBuffer.h
+ * @brief Rewind history of delta-compressed save states
+ *
+ * This file contains the declaration of the RewindBuffer class, which records one Chip8State
+ * per frame and steps back through them. Frames are stored as keyframes plus XOR deltas against
+ * the previous frame, run-length encoded, in a ring arena allocated once: recording a frame
+ * never allocates and the memory use is fixed at construction.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Chip8State.h"
+
+/** @brief Default size of the rewind arena, in bytes. */
+const std::size_t DEFAULT_REWIND_ARENA_SIZE = 4 * 1024 * 1024;
+
+/** @brief Default number of frames kept, five minutes at 60 Hz. */
+const std::size_t DEFAULT_REWIND_FRAMES = 5 * 60 * 60;
+
+/** @brief Default number of frames between two keyframes. */
+const unsigned int DEFAULT_REWIND_KEYFRAME_INTERVAL = 60;
+
+/**
+ * @class RewindBuffer
+ * @brief Bounded history of frames, newest first.
+ *
+ * A keyframe stores a whole state, a delta stores `frame ^ previous frame`. Both are encoded as
+ * (unchanged run, changed run, changed bytes) tokens, or kept raw when that is smaller. The XOR
+ * goes both ways, so stepping back applies the newest delta to the newest frame; only stepping
+ * back over a keyframe replays the previous keyframe and its deltas. Frames are evicted oldest
+ * first, a keyframe together with its deltas, when the arena or the frame count runs out.
+ */
+class RewindBuffer
+{
+public:
+    /**
+     * @brief Allocates the arena.
+     * @param arenaSize Bytes available for the encoded frames, at least two raw states.
+     * @param maxFrames Maximum number of frames kept.
+     * @param keyframeInterval Frames between two keyframes.
+     */
+    explicit RewindBuffer(std::size_t arenaSize = DEFAULT_REWIND_ARENA_SIZE,
+                          std::size_t maxFrames = DEFAULT_REWIND_FRAMES,
+                          unsigned int keyframeInterval = DEFAULT_REWIND_KEYFRAME_INTERVAL);
+
+    // ====== Getters of the class ======
+
+    /**
+     * @brief Get the number of frames recorded.
+     * @return The number of frames StepBack() can go through, plus the newest one.
+     */
+    inline std::size_t get_frame_count() const { return this->count; }
+
+    /**
+     * @brief Get the memory used by the encoded frames.
+     * @return The bytes of the arena in use, including the padding left when wrapping.
+     */
+    inline std::size_t get_used_bytes() const { return this->used; }
+
+    /**
+     * @brief Get the size of the arena.
+     * @return The bytes allocated for the encoded frames.
+     */
+    inline std::size_t get_capacity() const { return this->arena.size(); }
+
+    // ====== History ======
+
+    /**
+     * @brief Records a frame, evicting the oldest ones if needed.
+     * @param state State at the end of the frame.
+     */
+    void Push(const Chip8State& state);
+
+    /**
+     * @brief Drops the newest frame and returns the one before it.
+     * @param state Receives the previous frame.
+     * @return False, leaving the history untouched, when there is no previous frame.
+     */
+    bool StepBack(Chip8State& state);
+
+    /** @brief Forgets every frame. */
+    void Clear();
+
+private:
+    /** @brief Location of an encoded frame in the arena. */
+    struct Record
+    {
+        uint32_t offset;    /**< First byte in the arena. */
+        uint16_t size;      /**< Encoded size. */
+        bool keyframe;      /**< True for a whole state, false for a delta. */
+    };
+
+    std::vector<uint8_t> arena;     /**< Encoded frames, used as a byte ring. */
+    std::vector<Record> records;    /**< Frame ring, oldest at `first`. */
+    std::size_t first = 0;          /**< Ring index of the oldest frame. */
+    std::size_t count = 0;          /**< Number of frames. */
+    std::size_t head = 0;           /**< Arena offset of the next frame. */
+    std::size_t tail = 0;           /**< Arena offset of the oldest frame. */
+    std::size_t used = 0;           /**< Bytes from `tail` to `head`. */
+    unsigned int keyframeInterval;  /**< Frames between two keyframes. */
+    unsigned int sinceKeyframe = 0; /**< Deltas recorded after the newest keyframe. */
+
+    /** @brief Newest frame, decoded. */
+    Chip8State current{};
+
+    /**
+     * @brief Gets a record by age.
+     * @param age 0 for the oldest frame.
+     * @return The record in the frame ring.
+     */
+    inline Record& At(std::size_t age) { return this->records[(this->first + age) % this->records.size()]; }
+
+    /**
+     * @brief Finds room for one encoded frame, evicting the oldest frames until it fits.
+     * @return The arena offset of the room, sizeof(Chip8State) contiguous bytes.
+     */
+    std::size_t Reserve();
+
+    /** @brief Evicts the oldest keyframe and its deltas. */
+    void EvictOldest();
+
+    /**
+     * @brief XORs an encoded frame into a state.
+     * @param record Frame to apply.
+     * @param state State receiving the frame, zeroed first for a keyframe.
+     */
+    void Apply(const Record& record, Chip8State& state) const;
+
+    /**
+     * @brief Run-length encodes `a ^ b`.
+     * @param a First buffer.
+     * @param b Second buffer.
+     * @param size Bytes of the buffers.
+     * @param out Output, `size` bytes available.
+     * @return The encoded size, `size` when `a ^ b` was written raw because encoding did not help.
+     */
+    static std::size_t Encode(const uint8_t* a, const uint8_t* b, std::size_t size, uint8_t* out);
+};
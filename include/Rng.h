@@ -0,0 +1,139 @@
+/**
+ * @file Rng.h
+ * @brief Random byte generators for the Cxkk instruction
+ *
+ * This file contains the random generators the CPU can use and the concept they satisfy. The
+ * generators are small, seedable and trivially copyable, so their state is saved with the rest
+ * of the machine and a replay draws the same bytes as the original run.
+ */
+
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <type_traits>
+
+#include "Chip8State.h"
+
+/** @brief Seed of the random generator of a new CPU. */
+const uint64_t DEFAULT_RNG_SEED = 0;
+
+/**
+ * @brief Requirements of a random byte generator usable by Chip8.
+ * @details Seeding must be deterministic and the whole state must fit the save state.
+ */
+template <typename T>
+concept Chip8RandomGenerator =
+    std::is_trivially_copyable_v<T> && sizeof(T) <= CHIP8_STATE_RNG_SIZE &&
+    requires(T rng, uint64_t seed) {
+        { rng.Seed(seed) };
+        { rng.NextByte() } -> std::same_as<uint8_t>;
+    };
+
+/**
+ * @class SplitMix64
+ * @brief SplitMix64 generator, 8 bytes of state.
+ * @details Used to expand seeds, and cheap enough to serve as a generator on its own.
+ */
+class SplitMix64
+{
+public:
+    /**
+     * @brief Constructs a seeded generator.
+     * @param seed Initial state.
+     */
+    explicit SplitMix64(uint64_t seed = 0) : state(seed) {}
+
+    /**
+     * @brief Restarts the sequence.
+     * @param seed Initial state, any value.
+     */
+    inline void Seed(uint64_t seed) { this->state = seed; }
+
+    /**
+     * @brief Draws 64 random bits.
+     * @return The next value of the sequence.
+     */
+    inline uint64_t Next()
+    {
+        uint64_t z = (this->state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * @brief Draws a random byte.
+     * @return The top byte of Next().
+     */
+    inline uint8_t NextByte() { return static_cast<uint8_t>(Next() >> 56); }
+
+private:
+    uint64_t state; /**< Weyl sequence counter. */
+};
+
+/**
+ * @class Xoshiro256
+ * @brief xoshiro256** generator, 32 bytes of state.
+ * @details Default generator of the CPU: one step is a handful of shifts, rotations and a
+ * multiply, with no distribution object on top since every output byte is already uniform.
+ */
+class Xoshiro256
+{
+public:
+    /**
+     * @brief Constructs a seeded generator.
+     * @param seed Seed, see Seed().
+     */
+    explicit Xoshiro256(uint64_t seed = 0) { Seed(seed); }
+
+    /**
+     * @brief Restarts the sequence.
+     * @details The seed is expanded with SplitMix64, so close seeds still give unrelated sequences.
+     * @param seed Any value.
+     */
+    inline void Seed(uint64_t seed)
+    {
+        SplitMix64 expand(seed);
+        for (uint64_t& word : this->state)
+            word = expand.Next();
+    }
+
+    /**
+     * @brief Draws 64 random bits.
+     * @return The next value of the sequence.
+     */
+    inline uint64_t Next()
+    {
+        uint64_t* s = this->state;
+        const uint64_t result = Rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = Rotl(s[3], 45);
+
+        return result;
+    }
+
+    /**
+     * @brief Draws a random byte.
+     * @return The top byte of Next().
+     */
+    inline uint8_t NextByte() { return static_cast<uint8_t>(Next() >> 56); }
+
+private:
+    uint64_t state[4];  /**< Generator state, never all zero. */
+
+    /** @brief Rotates `x` left by `k` bits. */
+    static inline uint64_t Rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+};
+
+/** @brief Generator used by Chip8, any Chip8RandomGenerator can be plugged in here. */
+using Chip8Rng = Xoshiro256;
+
+static_assert(Chip8RandomGenerator<SplitMix64>);
+static_assert(Chip8RandomGenerator<Xoshiro256>);
@@ -0,0 +1,162 @@
+/**
+ * @file RomStore.h
+ * @brief Shared, validated ROM images
+ *
+ * This file contains the declaration of the RomImage and RomStore classes. A RomImage is an
+ * immutable ROM, validated once and hashed, backed either by a read-only memory mapping of the
+ * file or by an owned buffer. Any number of Chip8 instances load from the same image, the only
+ * copy being the one into their memory. The RomStore deduplicates images by content hash so a
+ * batch over a large corpus maps every distinct ROM once.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Chip8_common.h"
+
+/**
+ * @brief Largest ROM that fits the memory above START_ADDRESS.
+ * @details Sized for the 64KB XO-CHIP memory, Chip8::LoadROM() still rejects ROMs above its 4KB.
+ */
+const std::size_t MAX_ROM_SIZE = XO_MEMORY_SIZE - START_ADDRESS;
+
+/**
+ * @class RomImage
+ * @brief Read-only ROM contents with their hash.
+ *
+ * Images are only handled through `std::shared_ptr<const RomImage>`: the mapping or buffer
+ * lives as long as the last instance referencing it.
+ */
+class RomImage
+{
+public:
+    /**
+     * @brief Maps a ROM file.
+     * @details Any file name is accepted, only the contents are validated. Hosts without mmap
+     * read the file into an owned buffer instead.
+     * @param filename Path to the ROM.
+     * @return The validated image.
+     */
+    static std::shared_ptr<const RomImage> Map(const std::string& filename);
+
+    /**
+     * @brief Copies a ROM already in memory.
+     * @param rom ROM contents, copied once.
+     * @param name Label of the image, for error messages and reports.
+     * @return The validated image.
+     */
+    static std::shared_ptr<const RomImage> Copy(std::span<const uint8_t> rom, const std::string& name = "");
+
+    /**
+     * @brief Checks that a ROM can be loaded at START_ADDRESS.
+     * @param size Size of the ROM, in bytes.
+     * @param name Label used in the error message.
+     */
+    static void Validate(std::size_t size, const std::string& name);
+
+    RomImage(const RomImage&) = delete;
+    RomImage& operator=(const RomImage&) = delete;
+    ~RomImage();
+
+    // ====== Getters of the class ======
+
+    /**
+     * @brief Get the ROM contents.
+     * @return A view of the image, valid as long as the image.
+     */
+    inline std::span<const uint8_t> get_data() const { return this->data; }
+
+    /**
+     * @brief Get the content hash.
+     * @return Movie::HashRom() of the contents, so movies are checked without hashing again.
+     */
+    inline uint64_t get_hash() const { return this->hash; }
+
+    /**
+     * @brief Get the label of the image.
+     * @return The file name, or the name given to Copy().
+     */
+    inline const std::string& get_name() const { return this->name; }
+
+    /**
+     * @brief Tells whether the contents are a memory mapping of the file.
+     * @return True for a mapped file, false for an owned buffer.
+     */
+    inline bool is_mapped() const { return this->mapping != nullptr; }
+
+private:
+    std::string name;                   /**< File name or label. */
+    std::span<const uint8_t> data;      /**< Contents, in `mapping` or `buffer`. */
+    uint64_t hash = 0;                  /**< Movie::HashRom() of the contents. */
+    void* mapping = nullptr;            /**< Read-only mapping of the file, if any. */
+    std::size_t mappingSize = 0;        /**< Length of `mapping`. */
+    std::vector<uint8_t> buffer;        /**< Owned contents when not mapped. */
+
+    /** @brief Only built by Map() and Copy(). */
+    RomImage() = default;
+
+    /** @brief Validates `data` and computes its hash. */
+    void Seal();
+};
+
+/**
+ * @class RomStore
+ * @brief Cache of ROM images keyed by path and by content hash.
+ *
+ * Opening the same path twice returns the cached image, and two files or buffers with the same
+ * contents share one image. The store is thread-safe and keeps its images alive until it is
+ * destroyed or cleared.
+ */
+class RomStore
+{
+public:
+    /**
+     * @brief Maps a ROM file, or returns the cached image.
+     * @param filename Path to the ROM.
+     * @return The shared image.
+     */
+    std::shared_ptr<const RomImage> Open(const std::string& filename);
+
+    /**
+     * @brief Adds a ROM already in memory, or returns the cached image with the same contents.
+     * @param rom ROM contents, only copied when new.
+     * @param name Label of the image.
+     * @return The shared image.
+     */
+    std::shared_ptr<const RomImage> Add(std::span<const uint8_t> rom, const std::string& name = "");
+
+    /**
+     * @brief Looks an image up by content hash.
+     * @param hash Movie::HashRom() of the contents.
+     * @return The image, nullptr if none was opened or added.
+     */
+    std::shared_ptr<const RomImage> Find(uint64_t hash) const;
+
+    /**
+     * @brief Get the number of distinct images.
+     * @return The number of images held by content.
+     */
+    std::size_t get_size() const;
+
+    /** @brief Releases every cached image (instances still holding one keep it alive). */
+    void Clear();
+
+private:
+    mutable std::mutex mutex;                                                   /**< Guards both maps. */
+    std::unordered_map<std::string, std::shared_ptr<const RomImage>> paths;     /**< Images by path. */
+    std::unordered_map<uint64_t, std::shared_ptr<const RomImage>> images;       /**< Images by hash. */
+
+    /**
+     * @brief Returns the cached image with the contents of `image`, caching `image` if none.
+     * @details Called with `mutex` held. On a hash collision the new image is returned uncached.
+     */
+    std::shared_ptr<const RomImage> Intern(std::shared_ptr<const RomImage> image);
+};
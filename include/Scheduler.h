@@ -0,0 +1,237 @@
+/**
+ * @file Scheduler.h
+ * @brief Frame scheduler for the CHIP-8 CPU
+ *
+ * This file contains the declaration of the BasicScheduler class template, which drives a CPU
+ * core (Chip8, or XoChip for SUPER-CHIP / XO-CHIP programs) at a configurable number of
+ * instructions per frame while the delay and sound timers tick at
+ * a fixed 60 Hz, so changing the emulation speed no longer changes the game timing.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <chrono>
+#include <thread>
+
+#include "Chip8.h"
+#include "InputQueue.h"
+
+class MovieRecorder;
+class XoChip;
+
+/** @brief Frequency (in Hz) of the delay and sound timers, one tick per frame. */
+const unsigned int TIMER_FREQUENCY = 60;
+
+/** @brief Default number of instructions executed per 60 Hz frame (about 600 Hz). */
+const unsigned int DEFAULT_INSTRUCTIONS_PER_FRAME = 10;
+
+/** @brief Maximum number of late frames executed by a single Pump() before dropping the backlog. */
+const unsigned int MAX_CATCHUP_FRAMES = 5;
+
+/** @brief Instructions run between two idle-loop checks (see Chip8::SkipIdleCycles()). */
+const unsigned int IDLE_CHECK_CYCLES = 64;
+
+/** @brief Interval at which an idle uncapped CPU checks the input queue while sleeping. */
+constexpr std::chrono::milliseconds IDLE_INPUT_POLL_PERIOD{1};
+
+/**
+ * @brief Pacing strategies of the Scheduler.
+ */
+enum class SchedulerMode
+{
+    Uncapped,   /**< Run one batch of instructions per Pump(), timers tick at 60 Hz of wall time. */
+    RealTime,   /**< Run the frames due by the wall clock, as on real hardware. */
+    FixedRatio  /**< Run one frame per Pump() regardless of the wall clock, timers tick every frame. */
+};
+
+/**
+ * @class BasicScheduler
+ * @brief Interleaves CPU instructions and 60 Hz timer ticks.
+ *
+ * A frame is `instructionsPerFrame` instructions followed by one timer tick. The position inside
+ * the current frame is kept between calls, so RunCycles() ticks the timers at exactly the same
+ * instructions whatever the batch sizes. Wall-clock modes count frames from a fixed epoch
+ * (epoch + n * period) so rounding errors never accumulate. Idle loops (waiting on the delay
+ * timer, on a key or jumping to themselves) are fast-forwarded to the end of the frame instead
+ * of being interpreted; the skipped instructions still count as executed.
+ *
+ * Key changes read from an InputQueue are applied between two instructions: the one the
+ * emulated timeline reaches at the host time of the change. A release is held back until its
+ * key was down for a whole frame, so a tap shorter than a frame is still seen by the ROM.
+ *
+ * @tparam Core CPU driven, providing Run(), TickTimers(), SetKey(), get_keypad(),
+ * SkipIdleCycles() and get_idle_state() as Chip8 and XoChip do. Both are instantiated in
+ * Scheduler.cpp, use the Scheduler and XoScheduler aliases.
+ */
+template<typename Core>
+class BasicScheduler
+{
+public:
+    /** @brief Clock used to pace the wall-clock modes. */
+    using Clock = std::chrono::steady_clock;
+
+    /** @brief Duration of one 60 Hz frame. */
+    static constexpr Clock::duration FRAME_PERIOD =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / TIMER_FREQUENCY));
+
+    /**
+     * @brief Constructs a scheduler driving a CPU.
+     * @param core CPU to drive, must outlive the scheduler.
+     * @param mode Pacing strategy used by Pump().
+     * @param instructionsPerFrame Instructions executed between two timer ticks (at least 1).
+     * @param epoch Wall-clock time of the first frame.
+     */
+    explicit BasicScheduler(Core& core, SchedulerMode mode = SchedulerMode::RealTime,
+                       unsigned int instructionsPerFrame = DEFAULT_INSTRUCTIONS_PER_FRAME,
+                       Clock::time_point epoch = Clock::now());
+
+    // ====== Getters of the class ======
+
+    /**
+     * @brief Get the pacing strategy.
+     * @return The mode used by Pump().
+     */
+    inline SchedulerMode get_mode() const { return this->mode; }
+
+    /**
+     * @brief Get the emulation speed.
+     * @return The number of instructions executed per frame.
+     */
+    inline unsigned int get_instructions_per_frame() const { return this->instructionsPerFrame; }
+
+    /**
+     * @brief Get the number of timer ticks since construction or the last Reset().
+     * @return The number of completed frames.
+     */
+    inline uint64_t get_frame_count() const { return this->frameCount; }
+
+    /**
+     * @brief Get the number of instructions executed through the scheduler.
+     * @details Not cleared by Reset(), it timestamps recorded input (see MovieRecorder).
+     * @return The instructions executed since construction.
+     */
+    inline uint64_t get_cycle_count() const { return this->cycleCount; }
+
+    /**
+     * @brief Get the wall-clock time at which the next frame is due.
+     * @return epoch + (frames + 1) * period.
+     */
+    inline Clock::time_point get_next_deadline() const { return epoch + FRAME_PERIOD * (frameCount + 1); }
+
+    // ====== Scheduling ======
+
+    /**
+     * @brief Changes the emulation speed without touching the timer rate.
+     * @param instructions Instructions executed per frame (at least 1).
+     */
+    void SetInstructionsPerFrame(unsigned int instructions);
+
+    /**
+     * @brief Takes the key changes from a queue instead of the caller writing the keypad.
+     * @param queue Key changes to apply, nullptr to stop reading them. Must outlive the scheduler.
+     * @param recorder Records every applied change at its exact instruction, may be nullptr.
+     */
+    void SetInput(InputQueue* queue, MovieRecorder* recorder = nullptr);
+
+    /**
+     * @brief Applies every queued key change at once, whatever its time.
+     * @details For the front end while no instruction runs (rewinding): the queue keeps draining
+     * and the keypad follows the keyboard.
+     */
+    void FlushInput();
+
+    /**
+     * @brief Restarts the frame count from a new epoch.
+     * @param epoch Wall-clock time of the next frame.
+     */
+    void Reset(Clock::time_point epoch = Clock::now());
+
+    /**
+     * @brief Executes instructions, ticking the timers at every frame boundary crossed.
+     * @param cycles Number of instructions to execute.
+     * @return The number of timer ticks.
+     */
+    uint64_t RunCycles(uint64_t cycles);
+
+    /**
+     * @brief Executes whole frames, ignoring the wall clock.
+     * @param frames Number of frames to execute.
+     */
+    void RunFrames(uint64_t frames);
+
+    /**
+     * @brief Advances the emulation according to the mode.
+     * @details RealTime runs every frame due by `now`, at most MAX_CATCHUP_FRAMES at once: the
+     * backlog beyond that is dropped instead of fast-forwarding the game. FixedRatio runs one frame.
+     * Uncapped runs one frame worth of instructions and ticks the timers for every 60 Hz period
+     * elapsed by `now`.
+     * @param now Current wall-clock time.
+     * @return The number of timer ticks.
+     */
+    uint64_t Pump(Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Sleeps until the next frame is due.
+     * @details RealTime always sleeps. Uncapped sleeps only while the CPU is idle (halted, or
+     * waiting for a key or the delay timer): nothing changes before the next timer tick or key
+     * change, so the host is not kept busy. The wait ends early when a key change is queued.
+     * FixedRatio returns immediately. Sleeping until an absolute deadline keeps the frame rate
+     * locked on the epoch even when a frame overruns or the thread wakes up late.
+     */
+    void WaitForNextFrame() const;
+
+private:
+    Core& core;                         /**< Driven CPU. */
+    SchedulerMode mode;                 /**< Pacing strategy. */
+    unsigned int instructionsPerFrame;  /**< Instructions between two timer ticks. */
+    unsigned int cycleInFrame = 0;      /**< Instructions already executed in the current frame. */
+    uint64_t frameCount = 0;            /**< Frames completed since `epoch`. */
+    uint64_t cycleCount = 0;            /**< Instructions executed since construction. */
+    Clock::time_point epoch;            /**< Start of frame 0. */
+    InputQueue* input = nullptr;        /**< Key changes to apply, if any. */
+    MovieRecorder* recorder = nullptr;  /**< Receives the applied key changes, if any. */
+    std::array<uint64_t, NUM_KEYS> pressCycles{}; /**< Instruction count of the last press of each key. */
+
+    /**
+     * @brief Counts the frames due by a wall-clock time but not executed yet.
+     * @details Drops the backlog beyond MAX_CATCHUP_FRAMES by moving the frame count forward.
+     * @param now Current wall-clock time.
+     * @return The number of frames to execute.
+     */
+    uint64_t FramesDue(Clock::time_point now);
+
+    /**
+     * @brief Applies the queued key changes that are due.
+     * @return The instructions to execute before the next queued change is due, the maximum
+     * value when the queue is empty or absent.
+     */
+    uint64_t ApplyInput();
+
+    /**
+     * @brief Writes a key change to the keypad and removes it from the queue.
+     * @param event Key change at the head of the queue.
+     */
+    void PopInput(const KeyEvent& event);
+
+    /**
+     * @brief Counts the instructions to execute before a key change is due.
+     * @param event Key change at the head of the queue.
+     * @return 0 when it must be applied now.
+     */
+    uint64_t CyclesUntilDue(const KeyEvent& event) const;
+
+    /**
+     * @brief Executes instructions inside a frame, skipping the idle loops.
+     * @details Neither the timers nor the keys change during the call, so a loop found idle
+     * stays idle up to the end of the batch.
+     * @param cycles Number of instructions to account for.
+     */
+    void Execute(uint64_t cycles);
+};
+
+/** @brief Scheduler of the CHIP-8 core. */
+using Scheduler = BasicScheduler<Chip8>;
+
+/** @brief Scheduler of the SUPER-CHIP / XO-CHIP core. */
+using XoScheduler = BasicScheduler<XoChip>;
@@ -0,0 +1,104 @@
+/**
+ * @file SpscRing.h
+ * @brief Lock-free single-producer single-consumer ring buffer
+ *
+ * This file contains the SpscRing class template, a fixed-capacity queue shared by exactly one
+ * producer thread and one consumer thread. Neither side locks nor allocates, so the consumer can
+ * be a real-time callback such as the SDL audio one.
+ */
+
+#pragma once
+
+#include "Chip8_common.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+/**
+ * @class SpscRing
+ * @brief Bounded FIFO between one producer thread and one consumer thread.
+ * @details The indices grow forever and are masked on access, the ring is full when they are
+ * `Capacity` apart. Each index is written by a single side only: the producer publishes a slot
+ * with a release store of the tail, the consumer frees it with a release store of the head.
+ *
+ * @tparam T Element type, copied in and out of the slots.
+ * @tparam Capacity Number of slots, a power of two.
+ */
+template<typename T, std::size_t Capacity>
+class SpscRing
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "The capacity must be a power of two");
+    static_assert(std::is_trivially_copyable_v<T>, "The elements are copied without constructors");
+
+public:
+    /**
+     * @brief Appends an element, producer side.
+     * @param value Element to copy into the ring.
+     * @return False, leaving the ring untouched, when it is full.
+     */
+    bool TryPush(const T& value)
+    {
+        const std::size_t tail = this->tail.load(std::memory_order_relaxed);
+        if (tail - this->head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        this->slots[tail & (Capacity - 1)] = value;
+        this->tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest element, consumer side.
+     * @param value Receives the element.
+     * @return False, leaving value untouched, when the ring is empty.
+     */
+    bool TryPop(T& value)
+    {
+        const T* front = this->Peek();
+        if (!front)
+            return false;
+
+        value = *front;
+        this->Pop();
+        return true;
+    }
+
+    /**
+     * @brief Get the oldest element without removing it, consumer side.
+     * @return The element, valid until Pop(), or nullptr when the ring is empty.
+     */
+    const T* Peek() const
+    {
+        const std::size_t head = this->head.load(std::memory_order_relaxed);
+        if (head == this->tail.load(std::memory_order_acquire))
+            return nullptr;
+        return &this->slots[head & (Capacity - 1)];
+    }
+
+    /** @brief Removes the element returned by Peek(), consumer side. */
+    void Pop()
+    {
+        this->head.store(this->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Get the number of queued elements.
+     * @return A snapshot, exact only when called from one of the two sides while the other is idle.
+     */
+    inline std::size_t get_size() const
+    {
+        return this->tail.load(std::memory_order_acquire) - this->head.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the number of slots.
+     * @return The Capacity template argument.
+     */
+    static constexpr std::size_t get_capacity() { return Capacity; }
+
+private:
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head{0};  /**< Next slot to read, written by the consumer. */
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail{0};  /**< Next slot to write, written by the producer. */
+    alignas(CACHE_LINE_SIZE) std::array<T, Capacity> slots{};   /**< Elements, indexed by the masked indices. */
+};
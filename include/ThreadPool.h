@@ -0,0 +1,94 @@
+/**
+ * @file ThreadPool.h
+ * @brief Work-stealing thread pool
+ *
+ * This file contains the declaration of the ThreadPool class, which runs independent tasks
+ * on a fixed set of worker threads. Each worker owns a task queue and steals from the others
+ * when its own queue runs dry, so uneven jobs still keep every core busy.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Fixed-size pool of workers with one queue per worker and work stealing.
+ *
+ * Workers pop their own queue from the back (most recent task, still hot in cache) and steal
+ * from the front of the other queues (oldest task). Tasks must not throw.
+ */
+class ThreadPool
+{
+public:
+    /** @brief Unit of work executed by the pool. */
+    using Task = std::function<void()>;
+
+    /**
+     * @brief Starts the workers.
+     * @param threads Number of workers, 0 uses one per hardware thread.
+     */
+    explicit ThreadPool(unsigned int threads = 0);
+
+    /** @brief Waits for the queued tasks, then joins the workers. */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Get the number of workers.
+     * @return The number of threads executing tasks.
+     */
+    inline std::size_t get_size() const { return this->workers.size(); }
+
+    /**
+     * @brief Queues a task, the queues are filled round-robin.
+     * @param task Task to execute on any worker.
+     */
+    void Submit(Task task);
+
+    /** @brief Blocks until every submitted task has completed. */
+    void Wait();
+
+private:
+    /** @brief Task queue owned by a worker. */
+    struct Queue
+    {
+        std::mutex mutex;           /**< Guards `tasks`. */
+        std::deque<Task> tasks;     /**< Pending tasks, the owner pops the back. */
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; /**< One queue per worker. */
+    std::vector<std::thread> workers;           /**< Worker threads. */
+
+    std::mutex stateMutex;                  /**< Guards the counters and `stopping`. */
+    std::condition_variable workAvailable;  /**< Signalled when a task is queued or on shutdown. */
+    std::condition_variable allDone;        /**< Signalled when the last pending task completes. */
+    std::size_t queued = 0;                 /**< Tasks submitted but not yet picked by a worker. */
+    std::size_t pending = 0;                /**< Tasks submitted but not yet completed. */
+    std::size_t nextQueue = 0;              /**< Queue receiving the next submitted task. */
+    bool stopping = false;                  /**< Set by the destructor to release the workers. */
+
+    /**
+     * @brief Takes a task from the worker's own queue, or steals one.
+     * @param self Index of the calling worker.
+     * @param task Receives the task.
+     * @return True if a task was taken.
+     */
+    bool TryPop(std::size_t self, Task& task);
+
+    /**
+     * @brief Main loop of a worker.
+     * @param self Index of the worker.
+     */
+    void WorkerLoop(std::size_t self);
+};
@@ -0,0 +1,79 @@
+/**
+ * @file TripleBuffer.h
+ * @brief Lock-free triple buffer
+ *
+ * This file contains the TripleBuffer class template, which hands the latest complete value
+ * (a video frame) from one producer thread to one consumer thread. Neither side ever waits for
+ * the other: the producer always has a slot to write, the consumer always has a slot to read.
+ */
+
+#pragma once
+
+#include "Chip8_common.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @class TripleBuffer
+ * @brief Latest-value channel between one producer thread and one consumer thread.
+ * @details Three slots rotate between the producer (back), the consumer (front) and the hand-over
+ * position (middle). Publish() swaps the back slot with the middle one and flags it fresh,
+ * Update() swaps the front slot with a fresh middle one. A single atomic byte holds the middle
+ * index and the fresh flag, so each swap is one exchange. Values the consumer did not take in time
+ * are overwritten: it always gets the newest one.
+ *
+ * @tparam T Slot type, written in place by the producer.
+ */
+template<typename T>
+class TripleBuffer
+{
+public:
+    /**
+     * @brief Get the slot to fill, producer side.
+     * @return The back slot, private to the producer until Publish().
+     */
+    inline T& get_write_buffer() { return this->slots[this->back].value; }
+
+    /** @brief Hands the back slot over to the consumer, producer side. */
+    void Publish()
+    {
+        const uint8_t previous = this->middle.exchange(this->back | FRESH, std::memory_order_acq_rel);
+        this->back = previous & INDEX_MASK;
+    }
+
+    /**
+     * @brief Takes the newest published slot, consumer side.
+     * @return True when a slot was published since the last call, get_read_buffer() then changed.
+     */
+    bool Update()
+    {
+        if (!(this->middle.load(std::memory_order_relaxed) & FRESH))
+            return false;
+
+        const uint8_t previous = this->middle.exchange(this->front, std::memory_order_acq_rel);
+        this->front = previous & INDEX_MASK;
+        return true;
+    }
+
+    /**
+     * @brief Get the slot taken by the last Update(), consumer side.
+     * @return The front slot, a value-initialised T before the first publication.
+     */
+    inline const T& get_read_buffer() const { return this->slots[this->front].value; }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;  /**< Slot index bits of `middle`. */
+    static constexpr uint8_t FRESH = 0x4;       /**< Set by Publish(), cleared by Update(). */
+
+    /** @brief A slot on its own cache lines, the two sides never write to a shared line. */
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        T value{};
+    };
+
+    std::array<Slot, 3> slots{};                                /**< Storage of the three values. */
+    alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> middle{1};    /**< Hand-over slot index and fresh flag. */
+    alignas(CACHE_LINE_SIZE) uint8_t back = 0;                  /**< Slot written by the producer. */
+    alignas(CACHE_LINE_SIZE) uint8_t front = 2;                 /**< Slot read by the consumer. */
+};
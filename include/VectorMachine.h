@@ -0,0 +1,175 @@
+/**
+ * @file VectorMachine.h
+ * @brief Lockstep execution of many CHIP-8 machines in structure-of-arrays layout
+ *
+ * This file contains the declaration of the VectorMachine class, which runs N copies of a ROM
+ * side by side. The hot CPU state (registers, PC, index, SP and timers) is stored one array per
+ * field with one entry per machine, so the machines sharing an instruction execute it together
+ * with SIMD byte operations.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "Chip8.h"
+
+/** @brief Lane count granularity, one AVX2 register of bytes. */
+const std::size_t VECTOR_LANE_ALIGNMENT = 32;
+
+/**
+ * @class VectorMachine
+ * @brief N CHIP-8 machines stepped in lockstep, one SIMD lane per machine.
+ *
+ * Every Step() executes exactly one instruction on every machine, so lane `l` always matches a
+ * scalar Chip8 seeded the same and driven the same. Machines are grouped by (PC, opcode): each
+ * group runs its instruction once over a lane mask. The arithmetic instructions (6xkk, 7xkk,
+ * 8xy*, Annn, Fx07, Fx15, Fx18, Fx1E), jumps and skips are vectorized. Everything else goes
+ * through the `OP_*` handlers of a per-lane Chip8, which also owns the lane memory, stack,
+ * display and keypad.
+ */
+class VectorMachine
+{
+public:
+    /**
+     * @brief Creates the machines.
+     * @details Lane `l` is seeded with `l`, see Seed().
+     * @param lanes Number of machines.
+     */
+    explicit VectorMachine(std::size_t lanes);
+
+    // ====== Getters of the class ======
+
+    /**
+     * @brief Get the number of machines.
+     * @return The number of lanes.
+     */
+    inline std::size_t get_lanes() const { return this->lanes; }
+
+    /**
+     * @brief Get the program counter of a machine.
+     * @param lane Machine number.
+     * @return The address of the next instruction of the lane.
+     */
+    inline uint16_t get_pc(std::size_t lane) const { return this->pc[lane]; }
+
+    /**
+     * @brief Get a register of a machine.
+     * @param lane Machine number.
+     * @param reg Register number (0x0 to 0xF).
+     * @return The value of V`reg` of the lane.
+     */
+    inline uint8_t get_register(std::size_t lane, uint8_t reg) const { return this->registers[reg][lane]; }
+
+    /**
+     * @brief Get the number of instruction groups of the last Step().
+     * @return 1 when every machine executed the same instruction, up to the lane count otherwise.
+     */
+    inline std::size_t get_group_count() const { return this->groupCount; }
+
+    // ====== Control ======
+
+    /**
+     * @brief Loads the same ROM image in every machine.
+     * @param rom ROM contents, copied at 0x200.
+     */
+    void LoadROM(std::span<const uint8_t> rom);
+
+    /**
+     * @brief Reseeds the random number generator of one machine.
+     * @param lane Machine number.
+     * @param seed Seed, see Chip8::Seed().
+     */
+    void Seed(std::size_t lane, uint64_t seed);
+
+    /**
+     * @brief Presses or releases a key of one machine.
+     * @param lane Machine number.
+     * @param key Key number (0x0 to 0xF).
+     * @param pressed True when the key is held down.
+     */
+    void SetKey(std::size_t lane, uint8_t key, bool pressed);
+
+    /** @brief Executes one instruction on every machine. */
+    void Step();
+
+    /**
+     * @brief Executes several instructions on every machine.
+     * @param cycles Number of Step() calls.
+     */
+    void Run(uint64_t cycles);
+
+    /** @brief Decrements the delay and sound timers of every machine, see Chip8::TickTimers(). */
+    void TickTimers();
+
+    /**
+     * @brief Hashes the state of one machine.
+     * @param lane Machine number.
+     * @return The same value as Chip8::StateHash() on an equivalent scalar machine.
+     */
+    uint64_t StateHash(std::size_t lane);
+
+private:
+    std::size_t lanes;          /**< Number of machines. */
+    std::size_t paddedLanes;    /**< `lanes` rounded up to VECTOR_LANE_ALIGNMENT. */
+    std::size_t groupCount = 0; /**< Instruction groups of the last Step(). */
+
+    // Structure-of-arrays CPU state, one entry per lane
+    std::array<std::vector<uint8_t>, NUM_REGISTERS> registers;  /**< V0 to VF of every lane. */
+    std::vector<uint16_t> pc;           /**< Program counters. */
+    std::vector<uint16_t> index;        /**< Index registers. */
+    std::vector<uint8_t> sp;            /**< Stack pointers. */
+    std::vector<uint8_t> delayTimer;    /**< Delay timers. */
+    std::vector<uint8_t> soundTimer;    /**< Sound timers. */
+
+    // Per-step scratch
+    std::vector<uint16_t> opcodes;      /**< Instruction fetched by every lane. */
+    std::vector<uint8_t> pending;       /**< 0xFF for the lanes not executed yet in this step. */
+    std::vector<uint8_t> mask;          /**< 0xFF for the lanes of the group being executed. */
+    std::vector<uint8_t> liveLanes;     /**< 0xFF for the real lanes, 0 for the padding. */
+
+    /** @brief Lane memory, stack, display and keypad, and the scalar handlers. */
+    std::vector<std::unique_ptr<Chip8>> machines;
+
+    /** @brief Opcode at every address of the loaded image, shared by all lanes. */
+    std::array<uint16_t, MEMORY_SIZE> sharedCode{};
+
+    /** @brief Non-zero for the addresses some lane wrote to, fetched from the lane memory. */
+    std::array<uint8_t, MEMORY_SIZE + 1> codeWritten{};
+
+    /**
+     * @brief Executes one instruction on a group of lanes.
+     * @param instruction Opcode shared by the group.
+     * @param address PC shared by the group.
+     * @param m 0xFF for the lanes of the group.
+     * @param allLanes True when the group is every lane, 16-bit fields are then written unmasked.
+     */
+    void ExecuteGroup(uint16_t instruction, uint16_t address, const uint8_t* m, bool allLanes);
+
+    /**
+     * @brief Writes a value into the lanes of a group.
+     * @param field Structure-of-arrays field.
+     * @param value Value to write.
+     * @param m 0xFF for the lanes of the group.
+     * @param allLanes True to write every lane without looking at `m`.
+     */
+    void SetLanes(std::vector<uint16_t>& field, uint16_t value, const uint8_t* m, bool allLanes);
+
+    /**
+     * @brief Executes one instruction on one lane through its Chip8 handlers.
+     * @param lane Machine number.
+     * @param instruction Opcode to execute.
+     */
+    void ExecuteScalar(std::size_t lane, uint16_t instruction);
+
+    /** @brief Copies the structure-of-arrays state of a lane into its Chip8. */
+    void SyncToMachine(std::size_t lane);
+
+    /** @brief Copies the state of a lane Chip8 back into the structure of arrays. */
+    void SyncFromMachine(std::size_t lane);
+};
@@ -0,0 +1,374 @@
+/**
+ * @file XoChip.h
+ * @brief SUPER-CHIP / XO-CHIP CPU
+ *
+ * This file contains the declaration of the XoChip class, a second CPU core running SUPER-CHIP
+ * and XO-CHIP programs: 128x64 hi-res mode, scrolling, 16x16 sprites, two bit-planes, 64KB of
+ * memory and the XO-CHIP long load. The Chip8 class keeps the plain CHIP-8 machine and its
+ * engines; this core dispatches through opcode tables only.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "Chip8_common.h"
+#include "Quirks.h"
+#include "Rng.h"
+
+/**
+ * @class XoChip
+ * @brief SUPER-CHIP / XO-CHIP emulator.
+ *
+ * Every plane is a packed framebuffer of XO_VIDEO_HEIGHT rows of XO_ROW_WORDS words, bit 63 of
+ * the first word being the leftmost pixel. The lo-res mode only uses the first word of the first
+ * VIDEO_HEIGHT rows, so it costs no more than the CHIP-8 display: draws and scrolls are shifts
+ * and masks on whole words in both modes, never loops over pixels.
+ *
+ * Skips step over the 4-byte F000 nnnn, and 00E0, scrolls and draws only touch the planes
+ * selected by Fn01. The shifts, Bnnn, Fx55/Fx65, the logic VF reset and the sprite wrapping
+ * follow the quirk profile: as for Chip8, those handlers are templates on a Chip8Quirks set and
+ * the constructor fills the tables with the specializations of the profile (XO-CHIP by default,
+ * SUPER-CHIP for the schip programs).
+ */
+class XoChip
+{
+public:
+    /** @brief Quirks of the handlers called without a profile, those of XO-CHIP. */
+    static constexpr Chip8Quirks DEFAULT_QUIRKS = QuirksOf(Chip8QuirkProfile::XoChip);
+
+    /**
+     * @brief Constructs a reset machine with the fonts loaded, in lo-res with plane 1 selected.
+     * @param profile Interpreter whose quirks are emulated, see DetectQuirkProfile().
+     */
+    explicit XoChip(Chip8QuirkProfile profile = Chip8QuirkProfile::XoChip);
+
+    // ====== Getters of the class ======
+
+    /**
+     * @brief Get the emulated interpreter.
+     * @return The quirk profile given at construction.
+     */
+    inline Chip8QuirkProfile get_quirk_profile() const { return this->quirkProfile; }
+
+    /**
+     * @brief Get a bit-plane.
+     * @param plane Plane number (0 or 1).
+     * @return The packed rows of the plane, XO_ROW_WORDS words per row.
+     */
+    inline std::span<const uint64_t, XO_VIDEO_HEIGHT * XO_ROW_WORDS> get_plane(unsigned int plane) const
+    {
+        return this->planes[plane];
+    }
+
+    /**
+     * @brief Get the visible display as pixels.
+     * @details Lo-res pixels are doubled, the result is always XO_VIDEO_WIDTH x XO_VIDEO_HEIGHT.
+     * @param palette Colours of the four plane combinations.
+     * @return The RGBA8888 pixels, row by row.
+     */
+    std::vector<uint32_t> get_video(const std::array<uint32_t, 4>& palette = XO_DEFAULT_PALETTE) const;
+
+    /**
+     * @brief Draws rows of the visible display as pixels, as in get_video().
+     * @param firstRow First row to draw, in XO_VIDEO_HEIGHT rows.
+     * @param rowCount Number of rows to draw.
+     * @param pixels Destination of the first pixel of the first row.
+     * @param pitch Distance in bytes between two destination rows.
+     * @param palette Colours of the four plane combinations.
+     */
+    void ExpandVideo(unsigned int firstRow, unsigned int rowCount, uint32_t* pixels, int pitch,
+                     const std::array<uint32_t, 4>& palette = XO_DEFAULT_PALETTE) const;
+
+    /**
+     * @brief Tells whether the hi-res mode is on.
+     * @return True in 128x64, false in 64x32.
+     */
+    inline bool is_hires() const { return this->hires; }
+
+    /**
+     * @brief Get the current display width.
+     * @return XO_VIDEO_WIDTH in hi-res, VIDEO_WIDTH in lo-res.
+     */
+    inline unsigned int get_width() const { return this->hires ? XO_VIDEO_WIDTH : VIDEO_WIDTH; }
+
+    /**
+     * @brief Get the current display height.
+     * @return XO_VIDEO_HEIGHT in hi-res, VIDEO_HEIGHT in lo-res.
+     */
+    inline unsigned int get_height() const { return this->hires ? XO_VIDEO_HEIGHT : VIDEO_HEIGHT; }
+
+    /**
+     * @brief Get the rows changed since the last ClearDirty().
+     * @return Bit `n` set if row `n` changed.
+     */
+    inline uint64_t get_dirty_rows() const { return this->dirtyRows; }
+
+    /**
+     * @brief Get the rows of get_video() changed since the last ClearDirty().
+     * @details In lo-res every dirty row covers two rows of the visible display.
+     * @return Bit `n` set if row `n` of the XO_VIDEO_WIDTH x XO_VIDEO_HEIGHT display changed.
+     */
+    uint64_t get_video_dirty_rows() const;
+
+    /** @brief Marks the display as presented. */
+    inline void ClearDirty() { this->dirtyRows = 0; }
+
+    /**
+     * @brief Get the CPU registers.
+     * @return The V0-VF registers.
+     */
+    inline std::span<const uint8_t, NUM_REGISTERS> get_registers() const { return this->registers; }
+
+    /**
+     * @brief Get the memory.
+     * @return The 64KB address space.
+     */
+    inline std::span<const uint8_t, XO_MEMORY_SIZE> get_memory() const { return this->memory; }
+
+    /**
+     * @brief Get the persistent flag registers.
+     * @return The registers saved by Fx75.
+     */
+    inline std::span<const uint8_t, XO_FLAG_COUNT> get_flags() const { return this->flags; }
+
+    /**
+     * @brief Get the index register.
+     * @return The 16-bit I register.
+     */
+    inline uint16_t get_index() const { return this->index; }
+
+    /**
+     * @brief Get the current program counter.
+     * @return The address of the next instruction to be fetched.
+     */
+    inline uint16_t get_pc() const { return this->pc; }
+
+    /**
+     * @brief Get the planes selected by Fn01.
+     * @return Bit 0 for plane 1, bit 1 for plane 2.
+     */
+    inline uint8_t get_plane_mask() const { return this->planeMask; }
+
+    /**
+     * @brief Get the audio pattern loaded by F002.
+     * @return The 128 one-bit samples.
+     */
+    inline std::span<const uint8_t, 16> get_audio_pattern() const { return this->audioPattern; }
+
+    /**
+     * @brief Get the audio pitch set by Fx3A.
+     * @return The pitch register, 64 being 4000 Hz playback.
+     */
+    inline uint8_t get_pitch() const { return this->pitch; }
+
+    /**
+     * @brief Get the sound timer.
+     * @return The remaining 60 Hz ticks of the pattern playback, it sounds while non-zero.
+     */
+    inline uint8_t get_sound_timer() const { return this->soundTimer; }
+
+    /**
+     * @brief Checks whether the CPU can no longer make progress.
+     * @details True after 00FD (exit), after a jump to itself, as for Chip8.
+     * @return True if running more cycles would not change the machine state.
+     */
+    inline bool is_halted() const
+    {
+        return this->exited
+            || ((opcode & 0xF000u) == 0x1000u && Fetch(pc) == opcode);
+    }
+
+    /**
+     * @brief Recognizes the idle loops that cannot change the machine state until a timer
+     * tick or a key change, the same loops as Chip8::get_idle_state().
+     * @return The kind of wait, Running when the CPU is not provably idle.
+     */
+    Chip8IdleState get_idle_state() const;
+
+    /**
+     * @brief Get the keypad.
+     * @return The state of the 16 keys, non-zero when down.
+     */
+    inline const std::array<uint8_t, NUM_KEYS>& get_keypad() const { return this->keypad; }
+
+    /**
+     * @brief Presses or releases a key of the keypad.
+     * @param key Key number (0x0 to 0xF).
+     * @param pressed True to press the key, false to release it.
+     */
+    inline void SetKey(uint8_t key, bool pressed) { this->keypad[key & 0x0F] = pressed ? 1 : 0; }
+
+    // ====== CPU Functions ======
+
+    /**
+     * @brief Loads a ROM image at START_ADDRESS.
+     * @param rom ROM contents, up to XO_MEMORY_SIZE - START_ADDRESS bytes.
+     */
+    void LoadROM(std::span<const uint8_t> rom);
+
+    /**
+     * @brief Reseeds the Cxkk generator.
+     * @param seed Any value, the same seed draws the same bytes.
+     */
+    void Seed(uint64_t seed);
+
+    /** @brief Executes one instruction. */
+    void Cycle();
+
+    /**
+     * @brief Executes several instructions back to back.
+     * @param cycles Number of instructions to execute.
+     */
+    void Run(uint64_t cycles);
+
+    /**
+     * @brief Fast-forwards through an idle loop instead of interpreting it.
+     * @details See Chip8::SkipIdleCycles(), the caller accounts the result as executed.
+     * @param cycles Maximum number of instructions to skip.
+     * @return The number of instructions skipped, 0 when running.
+     */
+    uint64_t SkipIdleCycles(uint64_t cycles) const;
+
+    /** @brief Decrements the delay and sound timers, to be called at 60 Hz. */
+    void TickTimers();
+
+    /**
+     * @brief Computes a hash of the architectural state.
+     * @return A 64-bit FNV-1a hash of registers, memory, timers, display and mode.
+     */
+    uint64_t StateHash() const;
+
+    // ====== Opcodes ======
+
+    void OP_NULL() {}   /**< Unknown instruction, ignored. */
+    void OP_00Cn();     /**< Scroll the selected planes down by n rows. */
+    void OP_00Dn();     /**< Scroll the selected planes up by n rows (XO-CHIP). */
+    void OP_00E0();     /**< Clear the selected planes. */
+    void OP_00EE();     /**< Return from a subroutine. */
+    void OP_00FB();     /**< Scroll the selected planes right by 4 pixels. */
+    void OP_00FC();     /**< Scroll the selected planes left by 4 pixels. */
+    void OP_00FD();     /**< Exit the interpreter. */
+    void OP_00FE();     /**< Switch to lo-res (64x32) and clear the display. */
+    void OP_00FF();     /**< Switch to hi-res (128x64) and clear the display. */
+    void OP_1nnn();     /**< Jump to nnn. */
+    void OP_2nnn();     /**< Call the subroutine at nnn. */
+    void OP_3xkk();     /**< Skip if Vx == kk. */
+    void OP_4xkk();     /**< Skip if Vx != kk. */
+    void OP_5xy0();     /**< Skip if Vx == Vy. */
+    void OP_5xy2();     /**< Save Vx to Vy (in either order) at I, I unchanged. */
+    void OP_5xy3();     /**< Load Vx to Vy (in either order) from I, I unchanged. */
+    void OP_6xkk();     /**< Vx = kk. */
+    void OP_7xkk();     /**< Vx += kk. */
+    void OP_8xy0();     /**< Vx = Vy. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_8xy1();     /**< Vx |= Vy, VF = 0 under logicResetsVF. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_8xy2();     /**< Vx &= Vy, VF = 0 under logicResetsVF. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_8xy3();     /**< Vx ^= Vy, VF = 0 under logicResetsVF. */
+    void OP_8xy4();     /**< Vx += Vy, VF = carry. */
+    void OP_8xy5();     /**< Vx -= Vy, VF = no borrow. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_8xy6();     /**< Vx = Vy (Vx without shiftReadsVy) >> 1, VF = shifted out bit. */
+    void OP_8xy7();     /**< Vx = Vy - Vx, VF = no borrow. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_8xyE();     /**< Vx = Vy (Vx without shiftReadsVy) << 1, VF = shifted out bit. */
+    void OP_9xy0();     /**< Skip if Vx != Vy. */
+    void OP_Annn();     /**< I = nnn. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_Bnnn();     /**< Jump to nnn + V0 (xnn + Vx under jumpAddsVx). */
+    void OP_Cxkk();     /**< Vx = random byte & kk. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_Dxyn();     /**< Draw an 8xn sprite, or 16x16 when n is 0, on the selected planes, clipped (wrapped under spritesWrap). */
+    void OP_Ex9E();     /**< Skip if key Vx is down. */
+    void OP_ExA1();     /**< Skip if key Vx is up. */
+    void OP_F000();     /**< I = the next 16-bit word (XO-CHIP long load). */
+    void OP_Fn01();     /**< Select the planes in n. */
+    void OP_F002();     /**< Load the 16-byte audio pattern at I. */
+    void OP_Fx07();     /**< Vx = delay timer. */
+    void OP_Fx0A();     /**< Wait for a key, store it in Vx. */
+    void OP_Fx15();     /**< Delay timer = Vx. */
+    void OP_Fx18();     /**< Sound timer = Vx. */
+    void OP_Fx1E();     /**< I += Vx. */
+    void OP_Fx29();     /**< I = small font character of Vx. */
+    void OP_Fx30();     /**< I = big font character of Vx. */
+    void OP_Fx33();     /**< Store the BCD of Vx at I. */
+    void OP_Fx3A();     /**< Audio pitch = Vx. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_Fx55();     /**< Store V0 to Vx at I, then I += x + 1 under memoryAdvancesIndex. */
+    template<Chip8Quirks Quirks = DEFAULT_QUIRKS>
+    void OP_Fx65();     /**< Load V0 to Vx from I, then I += x + 1 under memoryAdvancesIndex. */
+    void OP_Fx75();     /**< Save V0 to Vx in the flag registers. */
+    void OP_Fx85();     /**< Load V0 to Vx from the flag registers. */
+
+private:
+    /** @brief Typedef for opcode function pointers. */
+    using XoChipFunc = void (XoChip::*)();
+
+    std::array<uint8_t, NUM_REGISTERS> registers{};                         /**< V0-VF. */
+    std::array<uint8_t, XO_MEMORY_SIZE> memory{};                           /**< 64KB address space. */
+    std::array<uint16_t, STACK_SIZE> stack{};                               /**< Return addresses. */
+    std::array<std::array<uint64_t, XO_VIDEO_HEIGHT * XO_ROW_WORDS>, XO_PLANE_COUNT> planes{}; /**< Packed bit-planes. */
+    std::array<uint8_t, NUM_KEYS> keypad{};                                 /**< Key states. */
+    std::array<uint8_t, XO_FLAG_COUNT> flags{};                             /**< Persistent flag registers. */
+    std::array<uint8_t, 16> audioPattern{};                                 /**< F002 sample bits. */
+    Chip8Rng rng{DEFAULT_RNG_SEED};                                         /**< Cxkk generator. */
+    uint64_t dirtyRows = ~0ULL;                                             /**< Rows changed since ClearDirty(). */
+    uint16_t index = 0;                                                     /**< I register. */
+    uint16_t pc = START_ADDRESS;                                            /**< Program counter. */
+    uint16_t opcode = 0;                                                    /**< Instruction being executed. */
+    uint8_t sp = 0;                                                         /**< Stack pointer. */
+    uint8_t delayTimer = 0;                                                 /**< Delay timer. */
+    uint8_t soundTimer = 0;                                                 /**< Sound timer. */
+    uint8_t planeMask = 1;                                                  /**< Planes selected by Fn01. */
+    uint8_t pitch = 64;                                                     /**< Fx3A audio pitch. */
+    bool hires = false;                                                     /**< 128x64 mode. */
+    bool exited = false;                                                    /**< 00FD executed. */
+    Chip8QuirkProfile quirkProfile;                                         /**< Interpreter emulated, selected at construction. */
+
+    std::array<XoChipFunc, 0x10> table;         /**< Dispatch on the first nibble. */
+    std::array<XoChipFunc, 0x100> table0;       /**< 0-group, on the low byte. */
+    std::array<XoChipFunc, 0x10> table5;        /**< 5-group, on the last nibble. */
+    std::array<XoChipFunc, 0x10> table8;        /**< 8-group, on the last nibble. */
+    std::array<XoChipFunc, 0x10> tableE;        /**< E-group, on the last nibble. */
+    std::array<XoChipFunc, 0x100> tableF;       /**< F-group, on the low byte. */
+
+    /** @brief Fills the dispatch tables. */
+    void InitializeTables();
+
+    /** @brief Points the quirk-dependent table entries to their specialization for `Quirks`. */
+    template<Chip8Quirks Quirks>
+    void InitializeQuirkTables();
+
+    void Table0();  /**< Dispatches through table0. */
+    void Table5();  /**< Dispatches through table5. */
+    void Table8();  /**< Dispatches through table8. */
+    void TableE();  /**< Dispatches through tableE. */
+    void TableF();  /**< Dispatches through tableF. */
+
+    /**
+     * @brief Reads the big-endian word at an address, wrapping at 64KB.
+     * @param address Address of the high byte.
+     * @return The instruction word.
+     */
+    inline uint16_t Fetch(uint16_t address) const
+    {
+        return static_cast<uint16_t>((memory[address] << 8u) | memory[static_cast<uint16_t>(address + 1)]);
+    }
+
+    /** @brief Skips the next instruction, both words of an F000 nnnn. */
+    inline void SkipNext() { this->pc += Fetch(this->pc) == 0xF000u ? 4 : 2; }
+
+    /** @brief Clears the selected planes and marks the display dirty. */
+    void ClearPlanes(uint8_t mask);
+
+    /**
+     * @brief Moves the rows of the selected planes vertically.
+     * @param rows Rows to move, positive down, negative up.
+     */
+    void ScrollRows(int rows);
+};
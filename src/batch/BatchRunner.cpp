@@ -0,0 +1,120 @@
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+#include "XoChip.h"
+
+#include <fstream>
+#include <sstream>
+
+BatchRunner::BatchRunner(unsigned int threads)
+	: threads(threads ? threads : std::max(std::thread::hardware_concurrency(), 1u))
+{
+}
+
+std::vector<BatchResult> BatchRunner::Run(const std::vector<BatchJob>& jobs) const
+{
+	std::vector<BatchResult> results(jobs.size());
+
+	{
+		ThreadPool pool(threads);
+
+		// Every job writes its own slot, no synchronisation needed on the results
+		for (std::size_t i = 0; i < jobs.size(); ++i)
+			pool.Submit([&jobs, &results, i] { results[i] = RunJob(jobs[i]); });
+
+		pool.Wait();
+	}
+
+	return results;
+}
+
+// Runs a job on a loaded core, the same loop for both cores
+template<typename Core>
+static void runCore(Core& core, const BatchJob& job, BatchResult& result)
+{
+	BasicScheduler<Core> scheduler(core, SchedulerMode::FixedRatio, job.instructionsPerFrame);
+	MoviePlayer input(job.inputs);
+
+	while (result.cycles < job.cycles && !core.is_halted())
+	{
+		// Apply the events due, then run up to the next one (or the halt check batch)
+		input.Apply(core, result.cycles);
+
+		uint64_t batch = std::min<uint64_t>(job.cycles - result.cycles, scheduler.get_instructions_per_frame());
+		batch = std::min(batch, input.get_next_cycle() - result.cycles);
+
+		scheduler.RunCycles(batch);
+		result.cycles += batch;
+	}
+
+	result.frames = scheduler.get_frame_count();
+	result.halted = core.is_halted();
+	result.stateHash = core.StateHash();
+}
+
+BatchResult BatchRunner::RunJob(const BatchJob& job)
+{
+	BatchResult result;
+	result.name = job.name;
+
+	try
+	{
+		if (!job.rom)
+			throw std::runtime_error("No ROM given.\n");
+
+		// SUPER-CHIP and XO-CHIP programs need the extended core, the engine does not apply to it
+		if (job.quirks == Chip8QuirkProfile::SuperChip || job.quirks == Chip8QuirkProfile::XoChip)
+		{
+			auto xochip = std::make_unique<XoChip>(job.quirks);
+			xochip->Seed(job.seed);
+			xochip->LoadROM(job.rom->get_data());
+			runCore(*xochip, job, result);
+			return result;
+		}
+
+		// The CPU and its caches are too large to live on a worker stack
+		auto chip8 = std::make_unique<Chip8>(job.engine, job.quirks);
+		chip8->Seed(job.seed);
+		chip8->LoadROM(job.rom->get_data());
+		runCore(*chip8, job, result);
+	}
+	catch (const std::exception& e)
+	{
+		result.error = e.what();
+	}
+
+	return result;
+}
+
+std::vector<InputEvent> BatchRunner::LoadInputScript(const std::string& filename)
+{
+	std::ifstream file(filename);
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open the input script " + filename + "\n");
+
+	std::vector<InputEvent> events;
+	std::string line;
+	unsigned int lineNumber = 0;
+
+	while (std::getline(file, line))
+	{
+		++lineNumber;
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		uint64_t cycle;
+		unsigned int key;
+		std::string action;
+
+		if (!(fields >> cycle >> std::hex >> key >> action) || key >= NUM_KEYS || (action != "down" && action != "up"))
+			throw std::runtime_error("Invalid input event at " + filename + ":" + std::to_string(lineNumber) + "\n");
+
+		events.push_back(InputEvent{cycle, static_cast<uint8_t>(key), action == "down"});
+	}
+
+	// Stable, so events of the same cycle keep the script order
+	std::stable_sort(events.begin(), events.end(),
+		[](const InputEvent& a, const InputEvent& b) { return a.cycle < b.cycle; });
+
+	return events;
+}
@@ -0,0 +1,111 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threads)
+{
+	if (threads == 0)
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (unsigned int i = 0; i < threads; ++i)
+		queues.push_back(std::make_unique<Queue>());
+
+	for (unsigned int i = 0; i < threads; ++i)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void ThreadPool::Submit(Task task)
+{
+	std::size_t target;
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		target = nextQueue;
+		nextQueue = (nextQueue + 1) % queues.size();
+		++pending;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(queues[target]->mutex);
+		queues[target]->tasks.push_back(std::move(task));
+	}
+
+	// Only count the task once it can actually be popped, so an idle worker never spins on it
+	{
+		std::lock_guard<std::mutex> lock(stateMutex);
+		++queued;
+	}
+	workAvailable.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	std::unique_lock<std::mutex> lock(stateMutex);
+	allDone.wait(lock, [this] { return pending == 0; });
+}
+
+bool ThreadPool::TryPop(std::size_t self, Task& task)
+{
+	// Own queue first, newest task
+	{
+		Queue& own = *queues[self];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.tasks.empty())
+		{
+			task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+
+	// Then steal the oldest task of the next busy worker
+	for (std::size_t i = 1; i < queues.size(); ++i)
+	{
+		Queue& victim = *queues[(self + i) % queues.size()];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::WorkerLoop(std::size_t self)
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(stateMutex);
+			workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+			if (queued == 0)
+				return;
+			// Claim one task, the pop below is then guaranteed to find it in some queue
+			--queued;
+		}
+
+		Task task;
+		while (!TryPop(self, task))
+			std::this_thread::yield();
+
+		task();
+
+		std::lock_guard<std::mutex> lock(stateMutex);
+		if (--pending == 0)
+			allDone.notify_all();
+	}
+}
@@ -0,0 +1,154 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include "BatchRunner.h"
+
+/** @brief Default cycle budget of every job. */
+const unsigned long long DEFAULT_BATCH_CYCLES = 10'000'000ULL;
+
+static void usage(const char* program)
+{
+	std::cerr << "Usage: " << program << " [-j Threads] [-c Cycles] [-e table|predecoded|block|jit] [-q default|cosmac|schip|xochip]"
+	          << " [-r Repeat]"
+	          << " <ROM>[:<Inputs>]...\n";
+	std::exit(EXIT_FAILURE);
+}
+
+int main(int argc, char** argv)
+{
+	// Declare variables by default in main scope
+	unsigned int threads = 0;
+	unsigned long long maxCycles = DEFAULT_BATCH_CYCLES;
+	unsigned long long repeat = 1;
+	Chip8Engine engine = Chip8Engine::Table;
+	const char* quirks = nullptr;
+	std::vector<std::string> specs;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		bool hasValue = i + 1 < argc;
+
+		if (arg == "-j" && hasValue)
+			threads = std::stoul(argv[++i]);
+		else if (arg == "-c" && hasValue)
+			maxCycles = std::stoull(argv[++i]);
+		else if (arg == "-r" && hasValue)
+			repeat = std::stoull(argv[++i]);
+		else if (arg == "-e" && hasValue)
+		{
+			std::string engineName = argv[++i];
+			if (engineName == "table")
+				engine = Chip8Engine::Table;
+			else if (engineName == "predecoded")
+				engine = Chip8Engine::Predecoded;
+			else if (engineName == "block")
+				engine = Chip8Engine::Block;
+			else if (engineName == "jit")
+				engine = Chip8Engine::Jit;
+			else
+				usage(argv[0]);
+		}
+		else if (arg == "-q" && hasValue)
+			quirks = argv[++i];
+		else if (!arg.empty() && arg[0] == '-')
+			usage(argv[0]);
+		else
+			specs.push_back(arg);
+	}
+
+	if (specs.empty())
+		usage(argv[0]);
+
+	// Build the jobs, a ROM is mapped once and shared by all its repetitions and duplicates
+	std::vector<BatchJob> jobs;
+	RomStore roms;
+	try
+	{
+		for (const std::string& spec : specs)
+		{
+			std::size_t separator = spec.find(':');
+			std::string romFilename = spec.substr(0, separator);
+
+			BatchJob job;
+			job.name = spec;
+			job.cycles = maxCycles;
+			job.engine = engine;
+			job.rom = roms.Open(romFilename);
+
+			// Every ROM gets the quirks it was written for, unless -q forces a profile
+			job.quirks = quirks ? ParseQuirkProfile(quirks) : DetectQuirkProfile(job.rom->get_data());
+			uint64_t seed = 0;
+
+			// Inputs are either a text script or a recorded movie, which also sets the seed, speed and quirks
+			std::string inputs = separator != std::string::npos ? spec.substr(separator + 1) : "";
+			if (inputs.ends_with(".c8m"))
+			{
+				Movie movie = Movie::Load(inputs);
+				if (movie.romHash != job.rom->get_hash())
+					throw std::runtime_error("The movie " + inputs + " was recorded with another ROM\n");
+				job.inputs = std::move(movie.events);
+				job.instructionsPerFrame = movie.instructionsPerFrame;
+				job.quirks = movie.quirks;
+				seed = movie.seed;
+			}
+			else if (!inputs.empty())
+				job.inputs = BatchRunner::LoadInputScript(inputs);
+
+			for (unsigned long long r = 0; r < repeat; ++r)
+			{
+				job.seed = seed + r;
+				jobs.push_back(job);
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: " << e.what();
+		std::exit(EXIT_FAILURE);
+	}
+
+	BatchRunner runner(threads);
+
+	auto startTime = std::chrono::steady_clock::now();
+	std::vector<BatchResult> results = runner.Run(jobs);
+	auto endTime = std::chrono::steady_clock::now();
+
+	unsigned long long totalCycles = 0;
+	unsigned long long totalFrames = 0;
+	int failures = 0;
+
+	for (std::size_t i = 0; i < results.size(); ++i)
+	{
+		const BatchResult& result = results[i];
+		std::cout << result.name << " #" << jobs[i].seed << "  ";
+
+		if (!result.error.empty())
+		{
+			std::cout << "error: " << result.error;
+			++failures;
+			continue;
+		}
+
+		std::cout << "hash=" << std::hex << std::setw(16) << std::setfill('0') << result.stateHash
+		          << std::dec << std::setfill(' ')
+		          << " cycles=" << result.cycles
+		          << " frames=" << result.frames
+		          << (result.halted ? " halted" : "") << "\n";
+
+		totalCycles += result.cycles;
+		totalFrames += result.frames;
+	}
+
+	double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	double ips = seconds > 0.0 ? totalCycles / seconds : 0.0;
+
+	std::cout << "Jobs:         " << results.size() << " (" << failures << " failed)\n"
+	          << "Threads:      " << runner.get_threads() << "\n"
+	          << "Cycles:       " << totalCycles << "\n"
+	          << "Frames:       " << totalFrames << "\n"
+	          << "Elapsed (s):  " << seconds << "\n"
+	          << "Instr/second: " << static_cast<unsigned long long>(ips) << "\n";
+
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,12 +1,13 @@
 #include "Chip8.h"
+#include "Framebuffer.h"
 
-Chip8::Chip8()
-    :randGen(std::chrono::system_clock::now().time_since_epoch().count())
+Chip8::Chip8(Chip8Engine engine, Chip8QuirkProfile profile)
+    :engine(engine), quirkProfile(profile), quirks(QuirksOf(profile))
 {
-    InitChip8();
+	if (engine == Chip8Engine::Jit)
+		jit = std::make_unique<Chip8Jit>();
 
-    // Initialize RNG with uniform distribution for bytes
-    randByte = std::uniform_int_distribution<unsigned int>(0, 255U);
+    InitChip8();
 
 	// Set up function pointer table
 	InitializeTables();
@@ -14,33 +15,337 @@ Chip8::Chip8()
 
 void Chip8::LoadROM(const std::string& filename)
 {
-    auto buffer = filenameHandling(filename);
+    auto buffer = ReadROM(filename);
+	LoadROM(buffer);
+}
+
+void Chip8::LoadROM(std::span<const uint8_t> rom)
+{
+	if (rom.size() > MEMORY_SIZE - START_ADDRESS)
+		throw std::runtime_error("The size of the loaded ROM is bigger than actual memory size\n");
 
     // Load ROM contents into memory starting at 0x200
-	std::copy(buffer.begin(), buffer.end(), memory.data() + START_ADDRESS);
+	std::copy(rom.begin(), rom.end(), memory.data() + START_ADDRESS);
+	InvalidateCode(START_ADDRESS, rom.size());
+}
+
+void Chip8::SaveState(Chip8State& state) const
+{
+	static_assert(Chip8RandomGenerator<Chip8Rng>, "The random generator state must fit the snapshot");
+
+	state = Chip8State{};
+	state.size = sizeof(Chip8State);
+	state.memory = memory;
+	state.video = video;
+	state.stack = stack;
+	state.registers = registers;
+	state.keypad = keypad;
+	std::memcpy(state.rng.data(), &rng, sizeof(rng));
+	state.index = index;
+	state.pc = pc;
+	state.opcode = opcode;
+	state.sp = sp;
+	state.delayTimer = delayTimer;
+	state.soundTimer = soundTimer;
+}
+
+void Chip8::LoadState(const Chip8State& state)
+{
+	if (state.magic != CHIP8_STATE_MAGIC || state.version != CHIP8_STATE_VERSION || state.size != sizeof(Chip8State))
+		throw std::runtime_error("The save state is not compatible with this version of the emulator\n");
+
+	// Only drop the cached code the snapshot changes, restoring every frame keeps the caches warm
+	if (engine != Chip8Engine::Table)
+	{
+		const unsigned int chunk = 64;
+		for (unsigned int address = 0; address < MEMORY_SIZE; address += chunk)
+		{
+			if (std::memcmp(&memory[address], &state.memory[address], chunk) != 0)
+				InvalidateCode(address, chunk);
+		}
+	}
+
+	memory = state.memory;
+	video = state.video;
+	stack = state.stack;
+	registers = state.registers;
+	keypad = state.keypad;
+	std::memcpy(&rng, state.rng.data(), sizeof(rng));
+	index = state.index;
+	pc = state.pc;
+	opcode = state.opcode;
+	sp = state.sp;
+	delayTimer = state.delayTimer;
+	soundTimer = state.soundTimer;
+
+	// The display has to be redrawn
+	dirtyRows = ALL_ROWS_DIRTY;
+	draw_flag = true;
+}
+
+void Chip8::SaveState(const std::string& filename) const
+{
+	Chip8State state;
+	SaveState(state);
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open() || !file.write(reinterpret_cast<const char*>(&state), sizeof(state)))
+		throw std::runtime_error("Failed to write the save state " + filename + "\n");
+}
+
+void Chip8::LoadState(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open the save state " + filename + "\n");
+
+	Chip8State state;
+	if (!file.read(reinterpret_cast<char*>(&state), sizeof(state)))
+		throw std::runtime_error("The save state " + filename + " is truncated\n");
+
+	LoadState(state);
+}
+
+void Chip8::Seed(uint64_t seed)
+{
+	rng.Seed(seed);
+}
+
+uint64_t Chip8::StateHash() const
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;  // FNV-1a 64-bit offset basis
+
+	auto mix = [&hash](const void* data, std::size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;       // FNV-1a 64-bit prime
+		}
+	};
+
+	mix(registers.data(), registers.size());
+	mix(memory.data(), memory.size());
+	mix(&index, sizeof(index));
+	mix(&pc, sizeof(pc));
+	mix(&sp, sizeof(sp));
+	mix(stack.data(), stack.size() * sizeof(uint16_t));
+	mix(&delayTimer, sizeof(delayTimer));
+	mix(&soundTimer, sizeof(soundTimer));
+	mix(video.data(), video.size() * sizeof(uint64_t));
+
+	return hash;
+}
+
+std::array<uint32_t, VIDEO_HEIGHT * VIDEO_WIDTH> Chip8::get_video() const
+{
+	std::array<uint32_t, VIDEO_HEIGHT * VIDEO_WIDTH> pixels;
+	ExpandFramebuffer(video.data(), VIDEO_HEIGHT, pixels.data(), VIDEO_WIDTH * sizeof(uint32_t));
+	return pixels;
 }
 
 void Chip8::Cycle()
 {
-	// Fetch
-	// memory[pc] << 8u : turn this into a 16-bit value
-	opcode = (memory[pc] << 8u) | memory[pc + 1];
+	// The block engine single-steps through the decoded cache
+	if (engine != Chip8Engine::Table)
+	{
+		// Fetch the cached decode, memory is only read again on a cache miss
+		const DecodedOp op = decoded[pc];
+		opcode = op.opcode;
+		pc += 2;
+		Execute(handlers[op.handler]);
+	}
+	else
+	{
+		// Fetch
+		// memory[pc] << 8u : turn this into a 16-bit value
+		opcode = (memory[pc] << 8u) | memory[pc + 1];
 
-	// Increment the PC before we execute anything
-	pc += 2;
+		// Increment the PC before we execute anything
+		pc += 2;
 
-	// Decode and Execute based on the opcode
-	((*this).*(table[(opcode & 0xF000u) >> 12u]))();
+		// Decode and Execute based on the opcode
+		Execute(table[(opcode & 0xF000u) >> 12u]);
+	}
+}
 
-	// Decrement the delay timer if it's been set
+void Chip8::TickTimers()
+{
 	if (delayTimer > 0)
 		--delayTimer;
-
-	// Decrement the sound timer if it's been set
 	if (soundTimer > 0)
 		--soundTimer;
 }
 
+Chip8IdleState Chip8::get_idle_state() const
+{
+	if (is_halted())
+		return Chip8IdleState::Halted;
+
+	auto fetch = [this](unsigned int address) { return static_cast<uint16_t>((memory[address] << 8u) | memory[address + 1]); };
+	const uint16_t current = fetch(pc);
+
+	// Fx0A rewinds the PC onto itself as long as no key is down
+	if ((opcode & 0xF0FFu) == 0xF00Au && current == opcode
+		&& std::none_of(keypad.begin(), keypad.end(), [](uint8_t key) { return key != 0; }))
+		return Chip8IdleState::WaitingForKey;
+
+	// LD Vx, DT ; SE/SNE Vx, kk ; JP back to the LD, with Vx already holding the timer.
+	// The PC may be on any of the three, the previous instruction of the loop must have just run.
+	for (unsigned int offset = 0; offset <= 4; offset += 2)
+	{
+		if (pc < offset || pc - offset > MEMORY_SIZE - 6)
+			continue;
+
+		const uint16_t start = pc - offset;
+		const uint16_t load = fetch(start);
+		const uint16_t test = fetch(start + 2);
+		const uint16_t jump = fetch(start + 4);
+		const uint16_t previous = offset == 0 ? jump : fetch(pc - 2);
+		const uint8_t Vx = (load & 0x0F00u) >> 8u;
+		const uint8_t byte = test & 0x00FFu;
+
+		if ((load & 0xF0FFu) != 0xF007u || jump != (0x1000u | start) || ((test & 0x0F00u) >> 8u) != Vx
+			|| opcode != previous || registers[Vx] != delayTimer)
+			continue;
+
+		// The loop goes on as long as the test does not skip the jump
+		if ((test & 0xF000u) == 0x3000u && delayTimer != byte)
+			return Chip8IdleState::WaitingForTimer;
+		if ((test & 0xF000u) == 0x4000u && delayTimer == byte)
+			return Chip8IdleState::WaitingForTimer;
+	}
+
+	return Chip8IdleState::Running;
+}
+
+uint64_t Chip8::SkipIdleCycles(uint64_t cycles) const
+{
+	switch (get_idle_state())
+	{
+	case Chip8IdleState::Halted:
+		// Off the end of memory the next fetch is not a no-op, let the engine deal with it
+		return pc <= MEMORY_SIZE - 2 ? cycles : 0;
+	case Chip8IdleState::WaitingForKey:
+		return cycles;
+	case Chip8IdleState::WaitingForTimer:
+		// Whole iterations only, the CPU must end at the same point of the loop
+		return cycles - cycles % 3;
+	case Chip8IdleState::Running:
+	default:
+		return 0;
+	}
+}
+
+void Chip8::EnableProfiling(bool timing)
+{
+	if (!CHIP8_PROFILING)
+		throw std::runtime_error("Profiling support was not compiled in, build with ENABLE_PROFILING\n");
+
+	profiler = std::make_unique<Profiler>(timing);
+}
+
+void Chip8::ExecuteProfiled(Chip8Func handler)
+{
+	// The PC already moved past the instruction, and OP_Decode only sets the opcode while running
+	const uint16_t address = pc - 2;
+
+	if (profiler->is_timing())
+	{
+		auto start = std::chrono::steady_clock::now();
+		((*this).*handler)();
+		auto elapsed = std::chrono::steady_clock::now() - start;
+		profiler->Record(opcode, address, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	}
+	else
+	{
+		((*this).*handler)();
+		profiler->Record(opcode, address);
+	}
+}
+
+void Chip8::Run(uint64_t cycles)
+{
+	// Same steps as Cycle(), with the engine selected once for the whole batch
+	if (engine == Chip8Engine::Predecoded)
+	{
+		for (uint64_t i = 0; i < cycles; ++i)
+		{
+			const DecodedOp op = decoded[pc];
+			opcode = op.opcode;
+			pc += 2;
+			Execute(handlers[op.handler]);
+		}
+	}
+	else if (engine == Chip8Engine::Jit && jit->available() && !profiler)
+	{
+		while (cycles > 0)
+		{
+			if (pc > MEMORY_SIZE - 2)
+			{
+				Cycle();
+				--cycles;
+				continue;
+			}
+
+			// Copy the entry, a self-modifying block flushes the cache while it runs
+			Chip8Jit::Entry entry = jit->Lookup(pc);
+			if (!entry.code)
+				entry = jit->Compile(*this, pc);
+
+			// Blocks are all or nothing, interpret when the budget ends inside one
+			if (entry.length > cycles)
+			{
+				Cycle();
+				--cycles;
+				continue;
+			}
+
+			entry.code(this);
+			cycles -= entry.length;
+		}
+	}
+	else if (engine == Chip8Engine::Block || engine == Chip8Engine::Jit)
+	{
+		while (cycles > 0)
+		{
+			if (pc > MEMORY_SIZE - 2)
+			{
+				// Out of memory, no block to build: behave like a single Cycle()
+				Cycle();
+				--cycles;
+				continue;
+			}
+
+			BlockRef block = blocks[pc];
+			if (block.length == 0)
+				block = BuildBlock(pc);
+
+			// Only run a prefix of the block when the budget ends inside it
+			unsigned int length = std::min<uint64_t>(block.length, cycles);
+			const DecodedOp* ops = &blockOps[block.first];
+
+			for (unsigned int i = 0; i < length; ++i)
+			{
+				opcode = ops[i].opcode;
+				pc += 2;
+				Execute(handlers[ops[i].handler]);
+			}
+
+			cycles -= length;
+		}
+	}
+	else
+	{
+		for (uint64_t i = 0; i < cycles; ++i)
+		{
+			opcode = (memory[pc] << 8u) | memory[pc + 1];
+			pc += 2;
+			Execute(table[(opcode & 0xF000u) >> 12u]);
+		}
+	}
+}
+
 void Chip8::InitChip8() {
 	// Initialize the emulator
 	pc = START_ADDRESS; // Program counter starts at 0x200
@@ -54,6 +359,10 @@ void Chip8::InitChip8() {
 	memory.fill(0);
 	registers.fill(0);
 
+	// Drop every cached decode, memory content changed
+	decoded.fill(DecodedOp{});
+	FlushBlocks();
+
 	// Load fonts into memory
 	for (unsigned int i = 0; i < FONTSET_SIZE; ++i)
 		memory[FONTSET_START_ADDRESS + i] = fontset[i];
@@ -65,8 +374,9 @@ void Chip8::InitChip8() {
 	// Reset keypad state
 	keypad.fill(0);
 
-	// Reset draw flag
-	draw_flag = false;
+	// The cleared display still has to be presented once
+	draw_flag = true;
+	dirtyRows = ALL_ROWS_DIRTY;
 }
 
 
@@ -91,9 +401,7 @@ void Chip8::InitializeTables()
 	table[0x8] = &Chip8::Table8;
 	table[0x9] = &Chip8::OP_9xy0;
 	table[0xA] = &Chip8::OP_Annn;
-	table[0xB] = &Chip8::OP_Bnnn;
 	table[0xC] = &Chip8::OP_Cxkk;
-	table[0xD] = &Chip8::OP_Dxyn;
 	table[0xE] = &Chip8::TableE;
 	table[0xF] = &Chip8::TableF;
 
@@ -103,14 +411,9 @@ void Chip8::InitializeTables()
 
 	// Table 8 (Arithmetic)
 	table8[0x0] = &Chip8::OP_8xy0;
-	table8[0x1] = &Chip8::OP_8xy1;
-	table8[0x2] = &Chip8::OP_8xy2;
-	table8[0x3] = &Chip8::OP_8xy3;
 	table8[0x4] = &Chip8::OP_8xy4;
 	table8[0x5] = &Chip8::OP_8xy5;
-	table8[0x6] = &Chip8::OP_8xy6;
 	table8[0x7] = &Chip8::OP_8xy7;
-	table8[0xE] = &Chip8::OP_8xyE;
 
 	// Table E (Key handling)
 	tableE[0x1] = &Chip8::OP_ExA1;
@@ -124,11 +427,157 @@ void Chip8::InitializeTables()
 	tableF[0x1E] = &Chip8::OP_Fx1E;
 	tableF[0x29] = &Chip8::OP_Fx29;
 	tableF[0x33] = &Chip8::OP_Fx33;
-	tableF[0x55] = &Chip8::OP_Fx55;
-	tableF[0x65] = &Chip8::OP_Fx65;
+
+	// Quirk-dependent handlers (Bnnn, Dxyn, 8xy1-3, 8xy6, 8xyE, Fx55, Fx65), specialized per
+	// profile: the choice is made once here, never while executing
+	switch (quirkProfile)
+	{
+		case Chip8QuirkProfile::Cosmac:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Cosmac)>();
+			break;
+		case Chip8QuirkProfile::SuperChip:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::SuperChip)>();
+			break;
+		case Chip8QuirkProfile::XoChip:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::XoChip)>();
+			break;
+		case Chip8QuirkProfile::Default:
+		default:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Default)>();
+			break;
+	}
+
+	// Leaf handlers of the decoded cache, index 0 decodes on first use
+	handlers.fill(&Chip8::OP_NULL);
+	handlers[0] = &Chip8::OP_Decode;
+	handlerCount = 1;
+}
+
+Chip8::Chip8Func Chip8::Decode(uint16_t instruction) const
+{
+	// Resolve the second level tables here so the cache stores the leaf handler
+	switch ((instruction & 0xF000u) >> 12u)
+	{
+		case 0x0:
+			return table0[instruction & 0x000Fu];
+		case 0x8:
+			return table8[instruction & 0x000Fu];
+		case 0xE:
+			return tableE[instruction & 0x000Fu];
+		case 0xF:
+			if ((instruction & 0x00FFu) < tableF.size())
+				return tableF[instruction & 0x00FFu];
+			return &Chip8::OP_NULL;
+		default:
+			return table[(instruction & 0xF000u) >> 12u];
+	}
+}
+
+uint8_t Chip8::HandlerIndex(Chip8Func func)
+{
+	for (uint8_t i = 0; i < handlerCount; ++i)
+		if (handlers[i] == func)
+			return i;
+
+	if (handlerCount == handlers.size())
+		throw std::runtime_error("Too many distinct opcode handlers for the decoded cache.\n");
+
+	handlers[handlerCount] = func;
+	return handlerCount++;
+}
+
+void Chip8::OP_Decode()
+{
+	// PC was already incremented by the fetch
+	uint16_t address = pc - 2;
+	opcode = (memory[address] << 8u) | memory[address + 1];
+
+	Chip8Func func = Decode(opcode);
+	decoded[address] = DecodedOp{opcode, HandlerIndex(func)};
+
+	((*this).*func)();
+}
+
+bool Chip8::EndsBlock(Chip8Func func) const
+{
+	return func == &Chip8::OP_00EE
+		|| func == &Chip8::OP_1nnn
+		|| func == &Chip8::OP_2nnn
+		|| func == &Chip8::OP_3xkk
+		|| func == &Chip8::OP_4xkk
+		|| func == &Chip8::OP_5xy0
+		|| func == &Chip8::OP_9xy0
+		|| func == table[0xB]
+		|| func == &Chip8::OP_Ex9E
+		|| func == &Chip8::OP_ExA1
+		|| func == &Chip8::OP_Fx0A
+		|| func == &Chip8::OP_Fx33
+		|| func == tableF[0x55];
+}
+
+Chip8::BlockRef Chip8::BuildBlock(uint16_t address)
+{
+	if (blockOpsUsed + MAX_BLOCK_LENGTH > blockOps.size())
+		FlushBlocks();
+
+	BlockRef block{blockOpsUsed, 0};
+
+	for (unsigned int a = address; a <= MEMORY_SIZE - 2 && block.length < MAX_BLOCK_LENGTH; a += 2)
+	{
+		uint16_t instruction = (memory[a] << 8u) | memory[a + 1];
+		Chip8Func func = Decode(instruction);
+
+		blockOps[blockOpsUsed++] = DecodedOp{instruction, HandlerIndex(func)};
+		++block.length;
+
+		// Remember which bytes the block depends on for invalidation
+		blockCode.set(a);
+		blockCode.set(a + 1);
+
+		if (EndsBlock(func))
+			break;
+	}
+
+	blocks[address] = block;
+	return block;
+}
+
+void Chip8::FlushBlocks()
+{
+	blocks.fill(BlockRef{});
+	blockOpsUsed = 0;
+	blockCode.reset();
+
+	if (jit)
+		jit->Flush();
+}
+
+void Chip8::InvalidateCode(uint16_t address, uint16_t length)
+{
+	// The table engine decodes every fetch, it never reads the caches
+	if (engine == Chip8Engine::Table)
+		return;
+
+	// The word starting one byte before the write also contains a written byte
+	unsigned int first = address > 0 ? address - 1u : 0u;
+	unsigned int last = std::min<unsigned int>(address + length, MEMORY_SIZE);
+
+	for (unsigned int a = first; a < last; ++a)
+		decoded[a].handler = 0;
+
+	// Blocks are not tracked individually, any write over cached code flushes them all.
+	// Writers end their block, so the block being executed is never read after the flush.
+	for (unsigned int a = address; a < last; ++a)
+	{
+		if (blockCode.test(a))
+		{
+			FlushBlocks();
+			break;
+		}
+	}
 }
 
-std::vector<uint8_t> Chip8::filenameHandling(const std::string& filename)
+std::vector<uint8_t> Chip8::ReadROM(const std::string& filename)
 {
     if (std::filesystem::path(filename).extension() != ".ch8")
         throw std::runtime_error("The file does not have a .ch8 extension or doesn't exist.\n");
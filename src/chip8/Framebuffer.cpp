@@ -0,0 +1,146 @@
+#include "Framebuffer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHIP8_FRAMEBUFFER_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	/** @brief Destination row `row` of a pitched pixel buffer. */
+	inline uint32_t* PixelRow(uint32_t* pixels, int pitch, unsigned int row)
+	{
+		return reinterpret_cast<uint32_t*>(reinterpret_cast<uint8_t*>(pixels) + static_cast<std::ptrdiff_t>(pitch) * row);
+	}
+
+	using ExpandFunc = void (*)(const uint64_t*, unsigned int, uint32_t*, int, uint32_t, uint32_t);
+
+#ifdef CHIP8_FRAMEBUFFER_SIMD
+	// 4 pixels per step: each lane tests its own bit of the nibble
+	__attribute__((target("sse2")))
+	void ExpandFramebufferSSE2(const uint64_t* rows, unsigned int rowCount, uint32_t* pixels, int pitch,
+	                           uint32_t onColor, uint32_t offColor)
+	{
+		const __m128i on = _mm_set1_epi32(static_cast<int>(onColor));
+		const __m128i off = _mm_set1_epi32(static_cast<int>(offColor));
+		const __m128i bits = _mm_set_epi32(1, 2, 4, 8);
+
+		for (unsigned int row = 0; row < rowCount; ++row)
+		{
+			uint32_t* out = PixelRow(pixels, pitch, row);
+			uint64_t word = rows[row];
+
+			for (unsigned int col = 0; col < VIDEO_WIDTH; col += 4)
+			{
+				__m128i nibble = _mm_set1_epi32(static_cast<int>((word >> (60u - col)) & 0xFu));
+				__m128i lit = _mm_cmpeq_epi32(_mm_and_si128(nibble, bits), bits);
+				__m128i color = _mm_or_si128(_mm_and_si128(lit, on), _mm_andnot_si128(lit, off));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + col), color);
+			}
+		}
+	}
+
+	// 8 pixels per step: one sprite-sized byte per 256-bit store
+	__attribute__((target("avx2")))
+	void ExpandFramebufferAVX2(const uint64_t* rows, unsigned int rowCount, uint32_t* pixels, int pitch,
+	                           uint32_t onColor, uint32_t offColor)
+	{
+		const __m256i on = _mm256_set1_epi32(static_cast<int>(onColor));
+		const __m256i off = _mm256_set1_epi32(static_cast<int>(offColor));
+		const __m256i bits = _mm256_setr_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+
+		for (unsigned int row = 0; row < rowCount; ++row)
+		{
+			uint32_t* out = PixelRow(pixels, pitch, row);
+			uint64_t word = rows[row];
+
+			for (unsigned int col = 0; col < VIDEO_WIDTH; col += 8)
+			{
+				__m256i byte = _mm256_set1_epi32(static_cast<int>((word >> (56u - col)) & 0xFFu));
+				__m256i lit = _mm256_cmpeq_epi32(_mm256_and_si256(byte, bits), bits);
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + col), _mm256_blendv_epi8(off, on, lit));
+			}
+		}
+	}
+#endif
+
+	/** @brief Picks the widest implementation supported by the host, once. */
+	ExpandFunc SelectExpand()
+	{
+#ifdef CHIP8_FRAMEBUFFER_SIMD
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return &ExpandFramebufferAVX2;
+		if (__builtin_cpu_supports("sse2"))
+			return &ExpandFramebufferSSE2;
+#endif
+		return &ExpandFramebufferScalar;
+	}
+}
+
+void ExpandFramebufferScalar(const uint64_t* rows, unsigned int rowCount, uint32_t* pixels, int pitch,
+                             uint32_t onColor, uint32_t offColor)
+{
+	for (unsigned int row = 0; row < rowCount; ++row)
+	{
+		uint32_t* out = PixelRow(pixels, pitch, row);
+		for (unsigned int col = 0; col < VIDEO_WIDTH; ++col)
+			out[col] = (rows[row] >> (63u - col)) & 1u ? onColor : offColor;
+	}
+}
+
+void ExpandFramebuffer(const uint64_t* rows, unsigned int rowCount, uint32_t* pixels, int pitch,
+                       uint32_t onColor, uint32_t offColor)
+{
+	static const ExpandFunc expand = SelectExpand();
+	expand(rows, rowCount, pixels, pitch, onColor, offColor);
+}
+
+void ExpandPlanes(const uint64_t* plane0, const uint64_t* plane1, bool hires, unsigned int firstRow,
+                  unsigned int rowCount, uint32_t* pixels, int pitch, const std::array<uint32_t, 4>& palette)
+{
+	for (unsigned int row = 0; row < rowCount; ++row)
+	{
+		const unsigned int y = firstRow + row;
+		uint32_t* out = PixelRow(pixels, pitch, row);
+
+		// The second output row of a lo-res row is a copy of the first one
+		if (!hires && (y & 1u) && row > 0)
+		{
+			std::memcpy(out, PixelRow(pixels, pitch, row - 1), XO_VIDEO_WIDTH * sizeof(uint32_t));
+			continue;
+		}
+
+		const unsigned int source = (hires ? y : y >> 1u) * XO_ROW_WORDS;
+		const unsigned int words = hires ? XO_ROW_WORDS : 1;
+		const unsigned int scale = hires ? 1 : 2;
+
+		for (unsigned int word = 0; word < words; ++word)
+		{
+			uint64_t low = plane0[source + word];
+			uint64_t high = plane1[source + word];
+			uint32_t* span = out + word * 64 * scale;
+
+			if (!(low | high))
+			{
+				std::fill(span, span + 64 * scale, palette[0]);
+				continue;
+			}
+
+			// The leftmost pixel is bit 63 of both words, shifted out one pixel at a time
+			for (unsigned int col = 0; col < 64 * scale; col += scale)
+			{
+				const uint32_t color = palette[(low >> 63u) | ((high >> 63u) << 1u)];
+				low <<= 1u;
+				high <<= 1u;
+				span[col] = color;
+				if (!hires)
+					span[col + 1] = color;
+			}
+		}
+	}
+}
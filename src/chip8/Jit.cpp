@@ -0,0 +1,266 @@
+#include "Jit.h"
+#include "Chip8.h"
+
+#if defined(__x86_64__) && defined(__unix__)
+#define CHIP8_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+/** @brief Upper bound of the native code emitted for one block (prologue, epilogue and instructions). */
+const std::size_t JIT_MAX_BLOCK_BYTES = 128 * MAX_BLOCK_LENGTH + 128;
+
+Chip8Jit::Chip8Jit(std::size_t capacity)
+{
+#ifdef CHIP8_JIT_X86_64
+	void* buffer = mmap(nullptr, capacity, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buffer != MAP_FAILED)
+	{
+		code = static_cast<uint8_t*>(buffer);
+		this->capacity = capacity;
+	}
+#endif
+}
+
+Chip8Jit::~Chip8Jit()
+{
+#ifdef CHIP8_JIT_X86_64
+	if (code)
+		munmap(code, capacity);
+#endif
+}
+
+void Chip8Jit::Flush()
+{
+	// The buffer stays mapped: a block flushed from its own helper call can still return safely
+	entries.fill(Entry{});
+	used = 0;
+}
+
+void Chip8Jit::Interpret(Chip8* chip8, uint32_t instruction, uint32_t handler)
+{
+	chip8->opcode = static_cast<uint16_t>(instruction);
+	((*chip8).*(chip8->handlers[handler]))();
+}
+
+void Chip8Jit::Emit8(uint8_t value)
+{
+	code[cursor++] = value;
+}
+
+void Chip8Jit::Emit16(uint16_t value)
+{
+	Emit8(value & 0xFFu);
+	Emit8(value >> 8u);
+}
+
+void Chip8Jit::Emit32(uint32_t value)
+{
+	Emit16(value & 0xFFFFu);
+	Emit16(value >> 16u);
+}
+
+void Chip8Jit::Emit64(uint64_t value)
+{
+	Emit32(value & 0xFFFFFFFFu);
+	Emit32(value >> 32u);
+}
+
+void Chip8Jit::EmitMem(std::initializer_list<uint8_t> op, uint8_t reg, int32_t displacement)
+{
+	for (uint8_t byte : op)
+		Emit8(byte);
+
+	// ModRM: mod = 10 (disp32), rm = 011 (rbx)
+	Emit8(0x80u | (reg << 3u) | 0x03u);
+	Emit32(static_cast<uint32_t>(displacement));
+}
+
+const Chip8Jit::Entry& Chip8Jit::Compile(Chip8& chip8, uint16_t address)
+{
+	if (!available())
+		return entries[address];
+
+	// Block discovery is shared with the block interpreter, it may flush the caches
+	Chip8::BlockRef block = chip8.blocks[address];
+	if (block.length == 0)
+		block = chip8.BuildBlock(address);
+
+	if (capacity - used < JIT_MAX_BLOCK_BYTES)
+		Flush();
+
+	auto offsetOf = [&chip8](const void* member) {
+		return static_cast<int32_t>(static_cast<const uint8_t*>(member) - reinterpret_cast<const uint8_t*>(&chip8));
+	};
+	const int32_t regs = offsetOf(chip8.registers.data());
+	const int32_t vf = regs + 0xF;
+	const int32_t indexOffset = offsetOf(&chip8.index);
+	const int32_t pcOffset = offsetOf(&chip8.pc);
+	const int32_t opcodeOffset = offsetOf(&chip8.opcode);
+
+	// Quirk-dependent handlers are the profile's specializations, found in the CPU's tables
+	const Chip8Quirks& quirks = chip8.quirks;
+	const Chip8::Chip8Func logicOr = chip8.table8[0x1];
+	const Chip8::Chip8Func logicAnd = chip8.table8[0x2];
+	const Chip8::Chip8Func logicXor = chip8.table8[0x3];
+	const Chip8::Chip8Func shiftRight = chip8.table8[0x6];
+	const Chip8::Chip8Func shiftLeft = chip8.table8[0xE];
+
+	cursor = used;
+	uint8_t* start = code + cursor;
+
+	Emit8(0x53);                            // push rbx (also aligns the stack for helper calls)
+	Emit8(0x48); Emit8(0x89); Emit8(0xFB);  // mov rbx, rdi
+
+	bool lastNative = false;
+	Chip8::Chip8Func lastFunc = nullptr;
+	uint16_t lastOpcode = 0;
+
+	for (unsigned int i = 0; i < block.length; ++i)
+	{
+		const Chip8::DecodedOp op = chip8.blockOps[block.first + i];
+		const Chip8::Chip8Func func = chip8.handlers[op.handler];
+		const uint16_t next = address + 2 * (i + 1);
+
+		const uint8_t x = (op.opcode & 0x0F00u) >> 8u;
+		const uint8_t y = (op.opcode & 0x00F0u) >> 4u;
+		const uint8_t kk = op.opcode & 0x00FFu;
+		const uint16_t nnn = op.opcode & 0x0FFFu;
+
+		// VF as an operand of the flag-setting ops is left to the interpreter (write order matters)
+		const bool flagOperand = (x == 0xF || y == 0xF);
+		bool native = true;
+
+		if (func == &Chip8::OP_6xkk)
+		{
+			EmitMem({0xC6}, 0, regs + x); Emit8(kk);    // mov byte [Vx], kk
+		}
+		else if (func == &Chip8::OP_7xkk)
+		{
+			EmitMem({0x80}, 0, regs + x); Emit8(kk);    // add byte [Vx], kk
+		}
+		else if (func == &Chip8::OP_8xy0 || func == logicOr
+			|| func == logicAnd || func == logicXor)
+		{
+			uint8_t aluOp = func == &Chip8::OP_8xy0 ? 0x88     // mov
+				: func == logicOr ? 0x08                        // or
+				: func == logicAnd ? 0x20                       // and
+				: 0x30;                                         // xor
+			EmitMem({0x8A}, 0, regs + y);                       // mov al, [Vy]
+			EmitMem({aluOp}, 0, regs + x);                      // op [Vx], al
+			if (quirks.logicResetsVF && func != &Chip8::OP_8xy0)
+			{
+				EmitMem({0xC6}, 0, vf); Emit8(0);               // mov byte [VF], 0
+			}
+		}
+		else if (func == &Chip8::OP_8xy4)
+		{
+			// Both operands are read before VF and Vx are written, aliasing is safe
+			EmitMem({0x8A}, 0, regs + x);                       // mov al, [Vx]
+			EmitMem({0x02}, 0, regs + y);                       // add al, [Vy]
+			Emit8(0x0F); Emit8(0x92); Emit8(0xC1);              // setc cl
+			EmitMem({0x88}, 1, vf);                             // mov [VF], cl
+			EmitMem({0x88}, 0, regs + x);                       // mov [Vx], al
+		}
+		else if ((func == &Chip8::OP_8xy5 || func == &Chip8::OP_8xy7) && !flagOperand)
+		{
+			// 8xy5: Vx = Vx - Vy, 8xy7: Vx = Vy - Vx, VF = minuend > subtrahend
+			uint8_t minuend = func == &Chip8::OP_8xy5 ? x : y;
+			uint8_t subtrahend = func == &Chip8::OP_8xy5 ? y : x;
+			EmitMem({0x8A}, 0, regs + minuend);                 // mov al, [minuend]
+			EmitMem({0x3A}, 0, regs + subtrahend);              // cmp al, [subtrahend]
+			Emit8(0x0F); Emit8(0x97); Emit8(0xC1);              // seta cl
+			EmitMem({0x2A}, 0, regs + subtrahend);              // sub al, [subtrahend]
+			EmitMem({0x88}, 1, vf);                             // mov [VF], cl
+			EmitMem({0x88}, 0, regs + x);                       // mov [Vx], al
+		}
+		else if ((func == shiftRight || func == shiftLeft) && x != 0xF)
+		{
+			// The source is read before VF is written, as both variants of the handler do
+			EmitMem({0x8A}, 0, regs + (quirks.shiftReadsVy ? y : x)); // mov al, [Vx or Vy]
+			Emit8(0x88); Emit8(0xC1);                           // mov cl, al
+			if (func == shiftRight)
+			{
+				Emit8(0x80); Emit8(0xE1); Emit8(0x01);          // and cl, 1
+				Emit8(0xD0); Emit8(0xE8);                       // shr al, 1
+			}
+			else
+			{
+				Emit8(0xC0); Emit8(0xE9); Emit8(0x07);          // shr cl, 7
+				Emit8(0xD0); Emit8(0xE0);                       // shl al, 1
+			}
+			EmitMem({0x88}, 1, vf);                             // mov [VF], cl
+			EmitMem({0x88}, 0, regs + x);                       // mov [Vx], al
+		}
+		else if (func == &Chip8::OP_Annn)
+		{
+			EmitMem({0x66, 0xC7}, 0, indexOffset); Emit16(nnn); // mov word [I], nnn
+		}
+		else if (func == &Chip8::OP_Fx1E)
+		{
+			EmitMem({0x0F, 0xB6}, 0, regs + x);                 // movzx eax, byte [Vx]
+			EmitMem({0x66, 0x01}, 0, indexOffset);              // add [I], ax
+		}
+		else if (func == &Chip8::OP_1nnn)
+		{
+			EmitMem({0x66, 0xC7}, 0, pcOffset); Emit16(nnn);    // mov word [pc], nnn
+		}
+		else if (func == &Chip8::OP_3xkk || func == &Chip8::OP_4xkk
+			|| func == &Chip8::OP_5xy0 || func == &Chip8::OP_9xy0)
+		{
+			// pc = condition ? next + 2 : next
+			Emit8(0xB8); Emit32(next);                          // mov eax, next
+			Emit8(0xB9); Emit32(next + 2);                      // mov ecx, next + 2
+			if (func == &Chip8::OP_3xkk || func == &Chip8::OP_4xkk)
+			{
+				EmitMem({0x80}, 7, regs + x); Emit8(kk);        // cmp byte [Vx], kk
+			}
+			else
+			{
+				EmitMem({0x8A}, 2, regs + x);                   // mov dl, [Vx]
+				EmitMem({0x3A}, 2, regs + y);                   // cmp dl, [Vy]
+			}
+			bool skipIfEqual = (func == &Chip8::OP_3xkk || func == &Chip8::OP_5xy0);
+			Emit8(0x0F); Emit8(skipIfEqual ? 0x44 : 0x45); Emit8(0xC1); // cmove/cmovne eax, ecx
+			EmitMem({0x66, 0x89}, 0, pcOffset);                 // mov [pc], ax
+		}
+		else
+		{
+			native = false;
+
+			// The handler may observe the PC, bring it up to date
+			EmitMem({0x66, 0xC7}, 0, pcOffset); Emit16(next);   // mov word [pc], next
+
+			Emit8(0xBE); Emit32(op.opcode);                     // mov esi, opcode
+			Emit8(0xBA); Emit32(op.handler);                    // mov edx, handler
+			Emit8(0x48); Emit8(0x89); Emit8(0xDF);              // mov rdi, rbx
+			Emit8(0x48); Emit8(0xB8);                           // mov rax, Interpret
+			Emit64(reinterpret_cast<uint64_t>(&Chip8Jit::Interpret));
+			Emit8(0xFF); Emit8(0xD0);                           // call rax
+		}
+
+		lastNative = native;
+		lastFunc = func;
+		lastOpcode = op.opcode;
+	}
+
+	// Control flow instructions already stored their target
+	if (!chip8.EndsBlock(lastFunc))
+	{
+		EmitMem({0x66, 0xC7}, 0, pcOffset);
+		Emit16(address + 2 * block.length);
+	}
+
+	// Keep `opcode` as the interpreter leaves it (is_halted() relies on it)
+	if (lastNative)
+	{
+		EmitMem({0x66, 0xC7}, 0, opcodeOffset);
+		Emit16(lastOpcode);
+	}
+
+	Emit8(0x5B);                            // pop rbx
+	Emit8(0xC3);                            // ret
+
+	used = cursor;
+	entries[address] = Entry{reinterpret_cast<BlockFunc>(start), block.length};
+	return entries[address];
+}
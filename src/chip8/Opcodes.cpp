@@ -1,9 +1,14 @@
 #include "Chip8.h"
+
+#include <bit>
 //TODO: adapt this file to C++ standards with std::arrays instead of raw arrays
 
 void Chip8::OP_00E0()
 {
 	video.fill(0);
+
+	dirtyRows = ALL_ROWS_DIRTY;
+	draw_flag = true;
 }
 
 void Chip8::OP_00EE()
@@ -79,28 +84,40 @@ void Chip8::OP_8xy0()
 	registers[Vx] = registers[Vy];
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_8xy1()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
 	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
 
 	registers[Vx] |= registers[Vy];
+
+	if constexpr (Quirks.logicResetsVF)
+		registers[0xF] = 0;
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_8xy2()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
 	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
 
 	registers[Vx] &= registers[Vy];
+
+	if constexpr (Quirks.logicResetsVF)
+		registers[0xF] = 0;
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_8xy3()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
 	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
 
 	registers[Vx] ^= registers[Vy];
+
+	if constexpr (Quirks.logicResetsVF)
+		registers[0xF] = 0;
 }
 
 void Chip8::OP_8xy4()
@@ -132,12 +149,25 @@ void Chip8::OP_8xy5()
 }
 
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_8xy6()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
-	// save the least significant bit in VF
-	registers[0xF] = (registers[Vx] & 0x1u);
-	registers[Vx] >>= 1;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+
+	if constexpr (Quirks.shiftReadsVy)
+	{
+		// Vy is read before VF is written, the flag wins when Vx is VF
+		uint8_t flag = registers[Vy] & 0x1u;
+		registers[Vx] = registers[Vy] >> 1u;
+		registers[0xF] = flag;
+	}
+	else
+	{
+		// save the least significant bit in VF
+		registers[0xF] = (registers[Vx] & 0x1u);
+		registers[Vx] >>= 1;
+	}
 }
 
 void Chip8::OP_8xy7()
@@ -153,13 +183,26 @@ void Chip8::OP_8xy7()
 	registers[Vx] = registers[Vy] - registers[Vx];
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_8xyE()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
-	// save the most significant bit in VF
-	registers[0xF] = (registers[Vx] & 0x80u) >> 7u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+
+	if constexpr (Quirks.shiftReadsVy)
+	{
+		// Vy is read before VF is written, the flag wins when Vx is VF
+		uint8_t flag = (registers[Vy] & 0x80u) >> 7u;
+		registers[Vx] = registers[Vy] << 1u;
+		registers[0xF] = flag;
+	}
+	else
+	{
+		// save the most significant bit in VF
+		registers[0xF] = (registers[Vx] & 0x80u) >> 7u;
 
-	registers[Vx] <<= 1;
+		registers[Vx] <<= 1;
+	}
 }
 
 void Chip8::OP_9xy0()
@@ -177,10 +220,16 @@ void Chip8::OP_Annn()
 	index = opcode & 0x0FFFu;
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_Bnnn()
 {
 	uint16_t address = opcode & 0x0FFFu;
-	pc = registers[0] + address;
+
+	// Bxnn: the high nibble of the address also selects the offset register
+	if constexpr (Quirks.jumpAddsVx)
+		pc = registers[(opcode & 0x0F00u) >> 8u] + address;
+	else
+		pc = registers[0] + address;
 }
 
 void Chip8::OP_Cxkk()
@@ -188,9 +237,10 @@ void Chip8::OP_Cxkk()
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
 	uint8_t byte = opcode & 0x00FFu;
 
-	registers[Vx] = randByte(randGen) & byte;
+	registers[Vx] = rng.NextByte() & byte;
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_Dxyn()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
@@ -201,32 +251,31 @@ void Chip8::OP_Dxyn()
 	uint8_t xPos = registers[Vx] % VIDEO_WIDTH;
 	uint8_t yPos = registers[Vy] % VIDEO_HEIGHT;
 
-	registers[0xF] = 0;
+	uint64_t collision = 0;
 
-	for (unsigned int row = 0; row < height; ++row)
+	for (unsigned int row = 0; row < height && (Quirks.spritesWrap || yPos + row < VIDEO_HEIGHT); ++row)
 	{
 		// Fetch the current sprite row
 		// index supposed to be already set to the address in memory
-		uint8_t spriteByte = memory[index + row];
-
-		for (unsigned int col = 0; col < 8; ++col)
-		{
-			// Check if sprite pixel is active
-			uint8_t spritePixel = spriteByte & (0x80u >> col);
-			uint32_t* screenPixel = &video[(yPos + row) * VIDEO_WIDTH + (xPos + col)];
-
-			// Sprite pixel is on
-			if (spritePixel)
-			{
-				// Screen pixel also on -> collision
-				if (*screenPixel == 0xFFFFFFFF)
-					registers[0xF] = 1; // Collision detected flag
-
-				// Effectively XOR with the sprite pixel
-				*screenPixel ^= 0xFFFFFFFF; // Toggle the screen pixel on/off
-			}
-		}
+		// Align it on the display word, pixels past the right edge are shifted out (or rotated
+		// back in on the left, the display being exactly one word wide)
+		uint64_t spriteRow = static_cast<uint64_t>(memory[index + row]) << 56u;
+		if constexpr (Quirks.spritesWrap)
+			spriteRow = std::rotr(spriteRow, xPos);
+		else
+			spriteRow >>= xPos;
+
+		// Pixels on in both the sprite and the screen collide, then XOR toggles them
+		const unsigned int y = (yPos + row) % VIDEO_HEIGHT;
+		collision |= video[y] & spriteRow;
+		video[y] ^= spriteRow;
+
+		if (spriteRow)
+			dirtyRows |= 1ULL << y;
 	}
+
+	registers[0xF] = collision ? 1 : 0; // Collision detected flag
+	draw_flag = dirtyRows != 0;
 }
 
 void Chip8::OP_Ex9E()
@@ -335,22 +384,34 @@ void Chip8::OP_Fx33()
     value /= 10;                      		// Remove the tens digit
 
     memory[index] = value % 10;       		// Store the hundreds digit in I
+
+	InvalidateCode(index, 3);
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_Fx55()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
 
 	for (uint8_t i = 0; i <= Vx; ++i)
 		memory[index + i] = registers[i];
+
+	InvalidateCode(index, Vx + 1);
+
+	if constexpr (Quirks.memoryAdvancesIndex)
+		index += Vx + 1;
 }
 
+template<Chip8Quirks Quirks>
 void Chip8::OP_Fx65()
 {
 	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
 
 	for (uint8_t i = 0; i <= Vx; ++i)
 		registers[i] = memory[index + i];
+
+	if constexpr (Quirks.memoryAdvancesIndex)
+		index += Vx + 1;
 }
 
 void Chip8::Table0()
@@ -372,3 +433,36 @@ void Chip8::TableF()
 {
 	((*this).*(tableF[opcode & 0x00FFu]))();
 };
+
+template<Chip8Quirks Quirks>
+void Chip8::InitializeQuirkTables()
+{
+	table[0xB] = &Chip8::OP_Bnnn<Quirks>;
+	table[0xD] = &Chip8::OP_Dxyn<Quirks>;
+
+	table8[0x1] = &Chip8::OP_8xy1<Quirks>;
+	table8[0x2] = &Chip8::OP_8xy2<Quirks>;
+	table8[0x3] = &Chip8::OP_8xy3<Quirks>;
+	table8[0x6] = &Chip8::OP_8xy6<Quirks>;
+	table8[0xE] = &Chip8::OP_8xyE<Quirks>;
+
+	tableF[0x55] = &Chip8::OP_Fx55<Quirks>;
+	tableF[0x65] = &Chip8::OP_Fx65<Quirks>;
+}
+
+// One specialization of the quirk-dependent handlers per profile
+template void Chip8::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Default)>();
+template void Chip8::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Cosmac)>();
+template void Chip8::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::SuperChip)>();
+template void Chip8::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::XoChip)>();
+
+// The default specializations are also called directly by the tests and benchmarks
+template void Chip8::OP_8xy1<Chip8Quirks{}>();
+template void Chip8::OP_8xy2<Chip8Quirks{}>();
+template void Chip8::OP_8xy3<Chip8Quirks{}>();
+template void Chip8::OP_8xy6<Chip8Quirks{}>();
+template void Chip8::OP_8xyE<Chip8Quirks{}>();
+template void Chip8::OP_Bnnn<Chip8Quirks{}>();
+template void Chip8::OP_Dxyn<Chip8Quirks{}>();
+template void Chip8::OP_Fx55<Chip8Quirks{}>();
+template void Chip8::OP_Fx65<Chip8Quirks{}>();
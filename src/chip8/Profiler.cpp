@@ -0,0 +1,143 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+// Handler names, indexed by Classify()
+static const std::array<const char*, PROFILER_HANDLER_COUNT> handlerNames = {
+	"OP_NULL", "OP_00E0", "OP_00EE", "OP_1nnn", "OP_2nnn", "OP_3xkk", "OP_4xkk", "OP_5xy0",
+	"OP_6xkk", "OP_7xkk", "OP_8xy0", "OP_8xy1", "OP_8xy2", "OP_8xy3", "OP_8xy4", "OP_8xy5",
+	"OP_8xy6", "OP_8xy7", "OP_8xyE", "OP_9xy0", "OP_Annn", "OP_Bnnn", "OP_Cxkk", "OP_Dxyn",
+	"OP_Ex9E", "OP_ExA1", "OP_Fx07", "OP_Fx0A", "OP_Fx15", "OP_Fx18", "OP_Fx1E", "OP_Fx29",
+	"OP_Fx33", "OP_Fx55", "OP_Fx65"
+};
+
+unsigned int Profiler::Classify(uint16_t opcode)
+{
+	// Same decoding as the Chip8 dispatch tables, invalid instructions land on OP_NULL (0)
+	switch (opcode >> 12u)
+	{
+	case 0x0:
+		switch (opcode & 0x000Fu)
+		{
+		case 0x0: return 1;
+		case 0xE: return 2;
+		default:  return 0;
+		}
+	case 0x8:
+		switch (opcode & 0x000Fu)
+		{
+		case 0x0: case 0x1: case 0x2: case 0x3: case 0x4: case 0x5: case 0x6: case 0x7:
+			return 10 + (opcode & 0x000Fu);
+		case 0xE: return 18;
+		default:  return 0;
+		}
+	case 0xE:
+		switch (opcode & 0x000Fu)
+		{
+		case 0xE: return 24;
+		case 0x1: return 25;
+		default:  return 0;
+		}
+	case 0xF:
+		switch (opcode & 0x00FFu)
+		{
+		case 0x07: return 26;
+		case 0x0A: return 27;
+		case 0x15: return 28;
+		case 0x18: return 29;
+		case 0x1E: return 30;
+		case 0x29: return 31;
+		case 0x33: return 32;
+		case 0x55: return 33;
+		case 0x65: return 34;
+		default:   return 0;
+		}
+	case 0x9:
+		return 19;
+	default:
+		// 1nnn to 7xkk are 3 to 9, Annn to Dxyn are 20 to 23
+		return (opcode >> 12u) < 0x8 ? 2 + (opcode >> 12u) : 10 + (opcode >> 12u);
+	}
+}
+
+const char* Profiler::HandlerName(uint16_t opcode)
+{
+	return handlerNames[Classify(opcode)];
+}
+
+uint64_t Profiler::get_total() const
+{
+	return std::accumulate(counts.begin(), counts.end(), uint64_t{0});
+}
+
+void Profiler::Reset()
+{
+	counts.fill(0);
+	times.fill(0);
+	pcCounts.fill(0);
+	pcTimes.fill(0);
+	pcOpcodes.fill(0);
+}
+
+void Profiler::WriteReport(std::ostream& out) const
+{
+	const uint64_t total = std::max<uint64_t>(get_total(), 1);
+	const uint64_t totalTime = std::max<uint64_t>(std::accumulate(times.begin(), times.end(), uint64_t{0}), 1);
+	char line[128];
+
+	// Handlers, the most expensive first
+	std::vector<unsigned int> handlers(PROFILER_HANDLER_COUNT);
+	std::iota(handlers.begin(), handlers.end(), 0u);
+	const auto& weights = timing ? times : counts;
+	std::stable_sort(handlers.begin(), handlers.end(),
+		[&weights](unsigned int a, unsigned int b) { return weights[a] > weights[b]; });
+
+	out << "Handler        Executions       %     Time (ms)       %   ns/op\n";
+	for (unsigned int handler : handlers)
+	{
+		if (counts[handler] == 0)
+			continue;
+
+		std::snprintf(line, sizeof(line), "%-10s %14llu %7.2f %13.3f %7.2f %7.1f\n", handlerNames[handler],
+			static_cast<unsigned long long>(counts[handler]), 100.0 * counts[handler] / total,
+			times[handler] / 1e6, 100.0 * times[handler] / totalTime,
+			static_cast<double>(times[handler]) / counts[handler]);
+		out << line;
+	}
+
+	// Hot addresses, a pathological loop shows up as a handful of PCs holding most executions
+	std::vector<uint16_t> addresses(MEMORY_SIZE);
+	std::iota(addresses.begin(), addresses.end(), uint16_t{0});
+	const auto& pcWeights = timing ? pcTimes : pcCounts;
+	std::size_t shown = std::min<std::size_t>(PROFILER_HOT_PC_COUNT, MEMORY_SIZE);
+	std::partial_sort(addresses.begin(), addresses.begin() + shown, addresses.end(),
+		[&pcWeights](uint16_t a, uint16_t b) { return pcWeights[a] > pcWeights[b] || (pcWeights[a] == pcWeights[b] && a < b); });
+
+	out << "\nPC      Opcode  Handler        Executions       %\n";
+	for (std::size_t i = 0; i < shown && pcCounts[addresses[i]] > 0; ++i)
+	{
+		uint16_t pc = addresses[i];
+		std::snprintf(line, sizeof(line), "0x%03X   %04X    %-10s %14llu %7.2f\n", pc, pcOpcodes[pc],
+			HandlerName(pcOpcodes[pc]), static_cast<unsigned long long>(pcCounts[pc]), 100.0 * pcCounts[pc] / total);
+		out << line;
+	}
+}
+
+void Profiler::WriteFolded(std::ostream& out) const
+{
+	const auto& pcWeights = timing ? pcTimes : pcCounts;
+	char line[64];
+
+	for (unsigned int pc = 0; pc < MEMORY_SIZE; ++pc)
+	{
+		if (pcWeights[pc] == 0)
+			continue;
+
+		std::snprintf(line, sizeof(line), "%s;0x%03X %llu\n", HandlerName(pcOpcodes[pc]), pc,
+			static_cast<unsigned long long>(pcWeights[pc]));
+		out << line;
+	}
+}
@@ -0,0 +1,89 @@
+#include "Quirks.h"
+#include "Chip8_common.h"
+
+#include <array>
+#include <stdexcept>
+#include <vector>
+
+/** @brief Names of the profiles, indexed by Chip8QuirkProfile. */
+static const std::array<const char*, 4> profileNames = {"default", "cosmac", "schip", "xochip"};
+
+Chip8QuirkProfile ParseQuirkProfile(const std::string& name)
+{
+	for (std::size_t i = 0; i < profileNames.size(); ++i)
+	{
+		if (name == profileNames[i])
+			return static_cast<Chip8QuirkProfile>(i);
+	}
+
+	throw std::runtime_error("Unknown quirk profile " + name + ", expected default, cosmac, schip or xochip\n");
+}
+
+const char* QuirkProfileName(Chip8QuirkProfile profile)
+{
+	return profileNames[static_cast<std::size_t>(profile)];
+}
+
+Chip8QuirkProfile DetectQuirkProfile(std::span<const uint8_t> rom)
+{
+	bool superChip = false;
+	std::vector<bool> visited(rom.size());
+	std::vector<std::size_t> pending = {0};
+
+	// Targets below the ROM (the font or the interpreter) end the path
+	auto target = [&rom](uint16_t address) -> std::size_t {
+		return address >= START_ADDRESS ? address - START_ADDRESS : rom.size();
+	};
+
+	// Walk every path from the entry point, each instruction once
+	while (!pending.empty())
+	{
+		std::size_t offset = pending.back();
+		pending.pop_back();
+
+		while (offset + 1 < rom.size() && !visited[offset])
+		{
+			visited[offset] = true;
+			const uint16_t instruction = (rom[offset] << 8u) | rom[offset + 1];
+			const uint16_t nnn = instruction & 0x0FFFu;
+			const uint8_t low = instruction & 0x00FFu;
+			offset += 2;
+
+			// Instructions only XO-CHIP knows: long load, plane select, audio, register ranges, scroll up
+			if (instruction == 0xF000u || (instruction & 0xF0FFu) == 0xF001u || instruction == 0xF002u
+				|| (instruction & 0xF00Eu) == 0x5002u || (instruction & 0xFFF0u) == 0x00D0u)
+				return Chip8QuirkProfile::XoChip;
+
+			// Instructions only SUPER-CHIP knows: scrolls, exit, resolution, big font, flag registers
+			if ((instruction & 0xFFF0u) == 0x00C0u || (instruction >= 0x00FBu && instruction <= 0x00FFu)
+				|| ((instruction & 0xF000u) == 0xF000u && (low == 0x30u || low == 0x75u || low == 0x85u)))
+				superChip = true;
+
+			switch (instruction >> 12u)
+			{
+			case 0x0:
+				// Returns and exits end the path, other system calls fall through
+				if (instruction == 0x00EEu || instruction == 0x00FDu)
+					offset = rom.size();
+				break;
+			case 0x1:
+				offset = target(nnn);
+				break;
+			case 0x2:
+				pending.push_back(target(nnn));
+				break;
+			case 0x3: case 0x4: case 0x5: case 0x9: case 0xE:
+				pending.push_back(offset + 2);
+				break;
+			case 0xB:
+				// Computed jump, the targets are unknown
+				offset = rom.size();
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	return superChip ? Chip8QuirkProfile::SuperChip : Chip8QuirkProfile::Default;
+}
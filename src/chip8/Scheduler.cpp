@@ -0,0 +1,219 @@
+#include "Scheduler.h"
+#include "Movie.h"
+#include "XoChip.h"
+
+#include <cmath>
+#include <limits>
+
+template<typename Core>
+BasicScheduler<Core>::BasicScheduler(Core& core, SchedulerMode mode, unsigned int instructionsPerFrame, Clock::time_point epoch)
+	: core(core), mode(mode), instructionsPerFrame(std::max(instructionsPerFrame, 1u)), epoch(epoch)
+{
+}
+
+template<typename Core>
+void BasicScheduler<Core>::SetInstructionsPerFrame(unsigned int instructions)
+{
+	instructionsPerFrame = std::max(instructions, 1u);
+
+	// A shorter frame may already be over, close it at the next instruction
+	cycleInFrame = std::min(cycleInFrame, instructionsPerFrame - 1);
+}
+
+template<typename Core>
+void BasicScheduler<Core>::Reset(Clock::time_point newEpoch)
+{
+	epoch = newEpoch;
+	frameCount = 0;
+	cycleInFrame = 0;
+}
+
+template<typename Core>
+void BasicScheduler<Core>::SetInput(InputQueue* queue, MovieRecorder* movieRecorder)
+{
+	input = queue;
+	recorder = movieRecorder;
+}
+
+template<typename Core>
+uint64_t BasicScheduler<Core>::RunCycles(uint64_t cycles)
+{
+	uint64_t ticks = 0;
+
+	while (cycles > 0)
+	{
+		// Run up to the end of the current frame or the next key change at most
+		uint64_t step = std::min<uint64_t>({cycles, instructionsPerFrame - cycleInFrame, ApplyInput()});
+		Execute(step);
+		cycles -= step;
+		cycleCount += step;
+		cycleInFrame += step;
+
+		if (cycleInFrame == instructionsPerFrame)
+		{
+			core.TickTimers();
+			cycleInFrame = 0;
+			++frameCount;
+			++ticks;
+		}
+	}
+
+	return ticks;
+}
+
+template<typename Core>
+uint64_t BasicScheduler<Core>::ApplyInput()
+{
+	if (!input)
+		return std::numeric_limits<uint64_t>::max();
+
+	while (const KeyEvent* event = input->Peek())
+	{
+		if (uint64_t wait = CyclesUntilDue(*event))
+			return wait;
+
+		PopInput(*event);
+	}
+
+	return std::numeric_limits<uint64_t>::max();
+}
+
+template<typename Core>
+void BasicScheduler<Core>::FlushInput()
+{
+	if (!input)
+		return;
+
+	while (const KeyEvent* event = input->Peek())
+		PopInput(*event);
+}
+
+template<typename Core>
+void BasicScheduler<Core>::PopInput(const KeyEvent& event)
+{
+	core.SetKey(event.key, event.pressed);
+	if (event.pressed && event.key < NUM_KEYS)
+		pressCycles[event.key] = cycleCount;
+	if (recorder)
+		recorder->Record(cycleCount, core.get_keypad());
+	input->Pop();
+}
+
+template<typename Core>
+uint64_t BasicScheduler<Core>::CyclesUntilDue(const KeyEvent& event) const
+{
+	if (event.key >= NUM_KEYS)
+		return 0;
+
+	// A release waits until its key was down for a whole frame, so a brief tap still registers
+	uint64_t wait = 0;
+	const uint64_t release = pressCycles[event.key] + instructionsPerFrame;
+	if (!event.pressed && cycleCount < release)
+		wait = release - cycleCount;
+
+	// Only RealTime maps instructions to the wall clock, the other modes apply at the next boundary
+	if (mode != SchedulerMode::RealTime || event.time <= epoch)
+		return wait;
+
+	// Position of the change on the emulated timeline, in instructions since the epoch
+	const double position = std::chrono::duration<double>(event.time - epoch) / FRAME_PERIOD * instructionsPerFrame;
+	const double current = static_cast<double>(frameCount * instructionsPerFrame + cycleInFrame);
+	if (position > current)
+		wait = std::max(wait, static_cast<uint64_t>(std::ceil(position - current)));
+
+	return wait;
+}
+
+template<typename Core>
+void BasicScheduler<Core>::Execute(uint64_t cycles)
+{
+	while (cycles > 0)
+	{
+		// Skipping is exact, the rest of the batch is interpreted in short runs to spot a loop entered midway
+		cycles -= core.SkipIdleCycles(cycles);
+		uint64_t step = std::min<uint64_t>(cycles, IDLE_CHECK_CYCLES);
+		core.Run(step);
+		cycles -= step;
+	}
+}
+
+template<typename Core>
+void BasicScheduler<Core>::RunFrames(uint64_t frames)
+{
+	for (uint64_t i = 0; i < frames; ++i)
+		RunCycles(instructionsPerFrame - cycleInFrame);
+}
+
+template<typename Core>
+uint64_t BasicScheduler<Core>::FramesDue(Clock::time_point now)
+{
+	if (now < epoch)
+		return 0;
+
+	// Frames are counted from the epoch, a late wake-up does not shift the following deadlines
+	uint64_t due = static_cast<uint64_t>((now - epoch) / FRAME_PERIOD);
+	if (due <= frameCount)
+		return 0;
+
+	if (due - frameCount > MAX_CATCHUP_FRAMES)
+		frameCount = due - MAX_CATCHUP_FRAMES;
+
+	return due - frameCount;
+}
+
+template<typename Core>
+uint64_t BasicScheduler<Core>::Pump(Clock::time_point now)
+{
+	switch (mode)
+	{
+	case SchedulerMode::RealTime:
+	{
+		uint64_t frames = FramesDue(now);
+		RunFrames(frames);
+		return frames;
+	}
+	case SchedulerMode::Uncapped:
+	{
+		// The CPU runs flat out, only the timers follow the wall clock
+		for (uint64_t cycles = instructionsPerFrame; cycles > 0;)
+		{
+			uint64_t step = std::min(cycles, ApplyInput());
+			Execute(step);
+			cycleCount += step;
+			cycles -= step;
+		}
+
+		uint64_t ticks = FramesDue(now);
+		for (uint64_t i = 0; i < ticks; ++i)
+			core.TickTimers();
+		frameCount += ticks;
+		return ticks;
+	}
+	case SchedulerMode::FixedRatio:
+	default:
+		RunFrames(1);
+		return 1;
+	}
+}
+
+template<typename Core>
+void BasicScheduler<Core>::WaitForNextFrame() const
+{
+	if (mode == SchedulerMode::RealTime)
+	{
+		std::this_thread::sleep_until(get_next_deadline());
+		return;
+	}
+
+	// An idle uncapped CPU would only skip its loop again, sleep up to the next tick or key change
+	if (mode != SchedulerMode::Uncapped || core.get_idle_state() == Chip8IdleState::Running)
+		return;
+
+	const Clock::time_point deadline = get_next_deadline();
+	for (Clock::time_point now = Clock::now(); now < deadline && !(input && input->get_size() > 0); now = Clock::now())
+		std::this_thread::sleep_for(std::min<Clock::duration>(IDLE_INPUT_POLL_PERIOD, deadline - now));
+}
+
+// The two cores share the scheduling code
+template class BasicScheduler<Chip8>;
+template class BasicScheduler<XoChip>;
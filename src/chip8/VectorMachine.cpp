@@ -0,0 +1,450 @@
+#include "VectorMachine.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CHIP8_VECTOR_SIMD
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	/** @brief Byte operations applied over a lane mask, named after the instruction they implement. */
+	enum class LaneOp : uint8_t
+	{
+		Set,        /**< 6xkk: Vx = kk */
+		AddImm,     /**< 7xkk: Vx += kk */
+		Mov,        /**< 8xy0: Vx = Vy */
+		Or,         /**< 8xy1: Vx |= Vy */
+		And,        /**< 8xy2: Vx &= Vy */
+		Xor,        /**< 8xy3: Vx ^= Vy */
+		Add,        /**< 8xy4: Vx += Vy, VF = carry */
+		Sub,        /**< 8xy5: Vx -= Vy, VF = Vx > Vy */
+		SubReverse, /**< 8xy7: Vx = Vy - Vx, VF = Vy > Vx */
+		Shr,        /**< 8xy6: Vx >>= 1, VF = old bit 0 */
+		Shl         /**< 8xyE: Vx <<= 1, VF = old bit 7 */
+	};
+
+	using LaneAluFunc = void (*)(LaneOp, uint8_t*, const uint8_t*, uint8_t, uint8_t*, const uint8_t*, std::size_t);
+
+	/** @brief Portable lane kernel, same results as the handlers of Opcodes.cpp. */
+	void LaneAluScalar(LaneOp op, uint8_t* vx, const uint8_t* vy, uint8_t imm, uint8_t* vf,
+	                   const uint8_t* mask, std::size_t count)
+	{
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			if (!mask[i])
+				continue;
+
+			uint8_t a = vx[i];
+			uint8_t b = vy ? vy[i] : 0;
+			uint8_t result = 0;
+			uint8_t flag = 0;
+
+			switch (op)
+			{
+			case LaneOp::Set:        result = imm; break;
+			case LaneOp::AddImm:     result = a + imm; break;
+			case LaneOp::Mov:        result = b; break;
+			case LaneOp::Or:         result = a | b; break;
+			case LaneOp::And:        result = a & b; break;
+			case LaneOp::Xor:        result = a ^ b; break;
+			case LaneOp::Add:        result = a + b; flag = (a + b) > 255u; break;
+			case LaneOp::Sub:        result = a - b; flag = a > b; break;
+			case LaneOp::SubReverse: result = b - a; flag = b > a; break;
+			case LaneOp::Shr:        result = a >> 1u; flag = a & 0x1u; break;
+			case LaneOp::Shl:        result = a << 1u; flag = a >> 7u; break;
+			}
+
+			vx[i] = result;
+			if (vf)
+				vf[i] = flag;
+		}
+	}
+
+#ifdef CHIP8_VECTOR_SIMD
+	// 32 lanes per step, results blended in under the lane mask
+	__attribute__((target("avx2")))
+	void LaneAluAVX2(LaneOp op, uint8_t* vx, const uint8_t* vy, uint8_t imm, uint8_t* vf,
+	                 const uint8_t* mask, std::size_t count)
+	{
+		const __m256i one = _mm256_set1_epi8(1);
+		const __m256i ones = _mm256_set1_epi8(-1);
+		const __m256i immediate = _mm256_set1_epi8(static_cast<char>(imm));
+
+		for (std::size_t i = 0; i < count; i += VECTOR_LANE_ALIGNMENT)
+		{
+			__m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mask + i));
+			if (_mm256_testz_si256(m, m))
+				continue;
+
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vx + i));
+			__m256i b = vy ? _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vy + i)) : _mm256_setzero_si256();
+			__m256i result;
+			__m256i flag = _mm256_setzero_si256();
+
+			switch (op)
+			{
+			case LaneOp::Set:    result = immediate; break;
+			case LaneOp::AddImm: result = _mm256_add_epi8(a, immediate); break;
+			case LaneOp::Mov:    result = b; break;
+			case LaneOp::Or:     result = _mm256_or_si256(a, b); break;
+			case LaneOp::And:    result = _mm256_and_si256(a, b); break;
+			case LaneOp::Xor:    result = _mm256_xor_si256(a, b); break;
+			case LaneOp::Add:
+				// Carry out of a + b <=> a > ~b <=> min(a, ~b) != a
+				result = _mm256_add_epi8(a, b);
+				flag = _mm256_andnot_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(a, _mm256_xor_si256(b, ones)), a), one);
+				break;
+			case LaneOp::Sub:
+				// a > b <=> max(a, b) == a and a != b
+				result = _mm256_sub_epi8(a, b);
+				flag = _mm256_and_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(a, b),
+				                                            _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), a)), one);
+				break;
+			case LaneOp::SubReverse:
+				result = _mm256_sub_epi8(b, a);
+				flag = _mm256_and_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(a, b),
+				                                            _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b)), one);
+				break;
+			case LaneOp::Shr:
+				// No byte shifts: shift 16-bit words and drop the bit coming from the neighbour byte
+				result = _mm256_and_si256(_mm256_srli_epi16(a, 1), _mm256_set1_epi8(0x7F));
+				flag = _mm256_and_si256(a, one);
+				break;
+			case LaneOp::Shl:
+			default:
+				result = _mm256_add_epi8(a, a);
+				flag = _mm256_and_si256(_mm256_srli_epi16(a, 7), one);
+				break;
+			}
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(vx + i), _mm256_blendv_epi8(a, result, m));
+			if (vf)
+			{
+				__m256i oldFlag = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(vf + i));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(vf + i), _mm256_blendv_epi8(oldFlag, flag, m));
+			}
+		}
+	}
+#endif
+
+	/** @brief Picks the widest implementation supported by the host, once. */
+	LaneAluFunc SelectLaneAlu()
+	{
+#ifdef CHIP8_VECTOR_SIMD
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+			return &LaneAluAVX2;
+#endif
+		return &LaneAluScalar;
+	}
+
+	const LaneAluFunc LaneAlu = SelectLaneAlu();
+
+	/** @brief Maps an 8xyN instruction to its lane operation, Set for the undefined ones. */
+	LaneOp ArithmeticOp(uint8_t n)
+	{
+		switch (n)
+		{
+		case 0x0: return LaneOp::Mov;
+		case 0x1: return LaneOp::Or;
+		case 0x2: return LaneOp::And;
+		case 0x3: return LaneOp::Xor;
+		case 0x4: return LaneOp::Add;
+		case 0x5: return LaneOp::Sub;
+		case 0x6: return LaneOp::Shr;
+		case 0x7: return LaneOp::SubReverse;
+		case 0xE: return LaneOp::Shl;
+		default:  return LaneOp::Set;
+		}
+	}
+}
+
+VectorMachine::VectorMachine(std::size_t lanes)
+	: lanes(lanes),
+	paddedLanes((lanes + VECTOR_LANE_ALIGNMENT - 1) / VECTOR_LANE_ALIGNMENT * VECTOR_LANE_ALIGNMENT)
+{
+	for (auto& reg : registers)
+		reg.assign(paddedLanes, 0);
+	pc.assign(paddedLanes, 0);
+	index.assign(paddedLanes, 0);
+	sp.assign(paddedLanes, 0);
+	delayTimer.assign(paddedLanes, 0);
+	soundTimer.assign(paddedLanes, 0);
+	opcodes.assign(paddedLanes, 0);
+	pending.assign(paddedLanes, 0);
+	mask.assign(paddedLanes, 0);
+	liveLanes.assign(paddedLanes, 0);
+	std::fill(liveLanes.begin(), liveLanes.begin() + lanes, 0xFF);
+
+	machines.reserve(lanes);
+	for (std::size_t lane = 0; lane < lanes; ++lane)
+	{
+		machines.push_back(std::make_unique<Chip8>(Chip8Engine::Table));
+		machines[lane]->Seed(lane);
+		SyncFromMachine(lane);
+	}
+
+	LoadROM({});
+}
+
+void VectorMachine::LoadROM(std::span<const uint8_t> rom)
+{
+	for (auto& machine : machines)
+		machine->LoadROM(rom);
+
+	// Every lane holds the same image again over the ROM, the rest is untouched
+	std::fill(codeWritten.begin() + START_ADDRESS, codeWritten.begin() + START_ADDRESS + rom.size(), 0);
+
+	if (!machines.empty())
+	{
+		const auto& memory = machines[0]->memory;
+		for (unsigned int address = 0; address + 1 < MEMORY_SIZE; ++address)
+			sharedCode[address] = (memory[address] << 8u) | memory[address + 1];
+	}
+}
+
+void VectorMachine::Seed(std::size_t lane, uint64_t seed)
+{
+	machines[lane]->Seed(seed);
+}
+
+void VectorMachine::SetKey(std::size_t lane, uint8_t key, bool pressed)
+{
+	machines[lane]->SetKey(key, pressed);
+}
+
+void VectorMachine::Step()
+{
+	// Fast path: every lane on the same PC, over an instruction no lane rewrote
+	const uint16_t leader = pc[0];
+	uint16_t divergence = 0;
+	for (std::size_t lane = 0; lane < lanes; ++lane)
+		divergence |= pc[lane] ^ leader;
+
+	if (divergence == 0 && leader <= MEMORY_SIZE - 2 && !(codeWritten[leader] | codeWritten[leader + 1]))
+	{
+		groupCount = 1;
+		ExecuteGroup(sharedCode[leader], leader, liveLanes.data(), true);
+		return;
+	}
+
+	// Fetch, from the shared image unless some lane wrote over the instruction
+	for (std::size_t lane = 0; lane < lanes; ++lane)
+	{
+		uint16_t address = pc[lane];
+		if (address > MEMORY_SIZE - 2)
+		{
+			// Ran off memory, the lane is frozen
+			pending[lane] = 0;
+			continue;
+		}
+
+		uint16_t instruction = sharedCode[address];
+		if (codeWritten[address] | codeWritten[address + 1])
+		{
+			const auto& memory = machines[lane]->memory;
+			instruction = (memory[address] << 8u) | memory[address + 1];
+		}
+
+		opcodes[lane] = instruction;
+		pending[lane] = 0xFF;
+	}
+
+	// Execute one group of lanes sharing (PC, opcode) at a time
+	groupCount = 0;
+	for (std::size_t first = 0; first < lanes; ++first)
+	{
+		if (!pending[first])
+			continue;
+
+		const uint16_t address = pc[first];
+		const uint16_t instruction = opcodes[first];
+
+		for (std::size_t lane = 0; lane < paddedLanes; ++lane)
+		{
+			uint8_t hit = pending[lane] & -static_cast<uint8_t>(pc[lane] == address && opcodes[lane] == instruction);
+			mask[lane] = hit;
+			pending[lane] &= ~hit;
+		}
+
+		ExecuteGroup(instruction, address, mask.data(), false);
+		++groupCount;
+	}
+}
+
+void VectorMachine::Run(uint64_t cycles)
+{
+	for (uint64_t i = 0; i < cycles; ++i)
+		Step();
+}
+
+void VectorMachine::TickTimers()
+{
+	for (std::size_t lane = 0; lane < paddedLanes; ++lane)
+	{
+		delayTimer[lane] -= delayTimer[lane] > 0;
+		soundTimer[lane] -= soundTimer[lane] > 0;
+	}
+}
+
+uint64_t VectorMachine::StateHash(std::size_t lane)
+{
+	SyncToMachine(lane);
+	return machines[lane]->StateHash();
+}
+
+void VectorMachine::ExecuteGroup(uint16_t instruction, uint16_t address, const uint8_t* m, bool allLanes)
+{
+	const uint8_t x = (instruction & 0x0F00u) >> 8u;
+	const uint8_t y = (instruction & 0x00F0u) >> 4u;
+	const uint8_t n = instruction & 0x000Fu;
+	const uint8_t kk = instruction & 0x00FFu;
+	const uint16_t nnn = instruction & 0x0FFFu;
+	const uint16_t next = address + 2;
+	uint8_t* vx = registers[x].data();
+	const uint8_t* vy = registers[y].data();
+
+	// Lanes run their own copy of the instruction when it needs memory, the stack or flags aliasing VF
+	bool vectorized = true;
+
+	switch (instruction >> 12u)
+	{
+	case 0x1:
+		SetLanes(pc, nnn, m, allLanes);
+		return;
+
+	case 0x3:
+	case 0x4:
+	case 0x5:
+	case 0x9:
+	{
+		const bool skipIfEqual = (instruction >> 12u) == 0x3 || (instruction >> 12u) == 0x5;
+		const bool immediate = (instruction >> 12u) == 0x3 || (instruction >> 12u) == 0x4;
+		for (std::size_t lane = 0; lane < paddedLanes; ++lane)
+		{
+			bool equal = vx[lane] == (immediate ? kk : vy[lane]);
+			uint16_t target = next + ((equal == skipIfEqual) ? 2 : 0);
+			pc[lane] = m[lane] ? target : pc[lane];
+		}
+		return;
+	}
+
+	case 0x6:
+		LaneAlu(LaneOp::Set, vx, nullptr, kk, nullptr, m, paddedLanes);
+		break;
+
+	case 0x7:
+		LaneAlu(LaneOp::AddImm, vx, nullptr, kk, nullptr, m, paddedLanes);
+		break;
+
+	case 0x8:
+	{
+		LaneOp op = ArithmeticOp(n);
+		bool setsFlag = op == LaneOp::Add || op == LaneOp::Sub || op == LaneOp::SubReverse
+			|| op == LaneOp::Shr || op == LaneOp::Shl;
+
+		if (op == LaneOp::Set || (setsFlag && (x == 0xF || y == 0xF)))
+			vectorized = false;
+		else
+			LaneAlu(op, vx, vy, 0, setsFlag ? registers[0xF].data() : nullptr, m, paddedLanes);
+		break;
+	}
+
+	case 0xA:
+		SetLanes(index, nnn, m, allLanes);
+		break;
+
+	case 0xF:
+		if (kk == 0x07)
+			LaneAlu(LaneOp::Mov, vx, delayTimer.data(), 0, nullptr, m, paddedLanes);
+		else if (kk == 0x15)
+			LaneAlu(LaneOp::Mov, delayTimer.data(), vx, 0, nullptr, m, paddedLanes);
+		else if (kk == 0x18)
+			LaneAlu(LaneOp::Mov, soundTimer.data(), vx, 0, nullptr, m, paddedLanes);
+		else if (kk == 0x1E)
+		{
+			for (std::size_t lane = 0; lane < paddedLanes; ++lane)
+				index[lane] += m[lane] ? vx[lane] : 0;
+		}
+		else
+			vectorized = false;
+		break;
+
+	default:
+		vectorized = false;
+		break;
+	}
+
+	if (!vectorized)
+	{
+		for (std::size_t lane = 0; lane < lanes; ++lane)
+		{
+			if (m[lane])
+				ExecuteScalar(lane, instruction);
+		}
+		return;
+	}
+
+	SetLanes(pc, next, m, allLanes);
+}
+
+void VectorMachine::SetLanes(std::vector<uint16_t>& field, uint16_t value, const uint8_t* m, bool allLanes)
+{
+	if (allLanes)
+	{
+		std::fill(field.begin(), field.end(), value);
+		return;
+	}
+
+	for (std::size_t lane = 0; lane < paddedLanes; ++lane)
+		field[lane] = m[lane] ? value : field[lane];
+}
+
+void VectorMachine::ExecuteScalar(std::size_t lane, uint16_t instruction)
+{
+	SyncToMachine(lane);
+
+	Chip8& machine = *machines[lane];
+	const uint16_t writeAddress = machine.index;
+
+	// Same steps as Chip8::Cycle() with the fetch already done
+	machine.opcode = instruction;
+	machine.pc += 2;
+	(machine.*(machine.table[(instruction & 0xF000u) >> 12u]))();
+
+	// Lanes writing memory stop fetching the written addresses from the shared image
+	unsigned int written = 0;
+	if ((instruction & 0xF0FFu) == 0xF033u)
+		written = 3;
+	else if ((instruction & 0xF0FFu) == 0xF055u)
+		written = ((instruction & 0x0F00u) >> 8u) + 1;
+
+	for (unsigned int i = 0; i < written && writeAddress + i < MEMORY_SIZE; ++i)
+		codeWritten[writeAddress + i] = 1;
+
+	SyncFromMachine(lane);
+}
+
+void VectorMachine::SyncToMachine(std::size_t lane)
+{
+	Chip8& machine = *machines[lane];
+	for (unsigned int reg = 0; reg < NUM_REGISTERS; ++reg)
+		machine.registers[reg] = registers[reg][lane];
+	machine.pc = pc[lane];
+	machine.index = index[lane];
+	machine.sp = sp[lane];
+	machine.delayTimer = delayTimer[lane];
+	machine.soundTimer = soundTimer[lane];
+}
+
+void VectorMachine::SyncFromMachine(std::size_t lane)
+{
+	const Chip8& machine = *machines[lane];
+	for (unsigned int reg = 0; reg < NUM_REGISTERS; ++reg)
+		registers[reg][lane] = machine.registers[reg];
+	pc[lane] = machine.pc;
+	index[lane] = machine.index;
+	sp[lane] = machine.sp;
+	delayTimer[lane] = machine.delayTimer;
+	soundTimer[lane] = machine.soundTimer;
+}
@@ -0,0 +1,183 @@
+#include <iostream>
+#include <chrono>
+#include "Chip8.h"
+#include "Movie.h"
+#include "RomStore.h"
+#include "Scheduler.h"
+#include "XoChip.h"
+
+/** @brief Default number of cycles executed by the headless runner. */
+const unsigned long long DEFAULT_HEADLESS_CYCLES = 10'000'000ULL;
+
+/** @brief Cycles executed between two halt checks. */
+const unsigned long long HEADLESS_BATCH_CYCLES = 1024ULL;
+
+/**
+ * @brief Runs a loaded core flat out and prints the report.
+ * @details No window, no input polling and no frame pacing: the timers still tick once every
+ * `instructionsPerFrame` instructions and the movie events land on their recorded instruction.
+ * @tparam Core Chip8 or XoChip.
+ * @param core CPU with the ROM loaded.
+ * @param romFilename Path of the ROM, for the report.
+ * @param profile Quirks emulated, for the report.
+ * @param maxCycles Number of instructions to execute at most.
+ * @param movie Speed and key changes to replay.
+ */
+template<typename Core>
+static void RunHeadless(Core& core, const char* romFilename, Chip8QuirkProfile profile,
+                        unsigned long long maxCycles, const Movie& movie)
+{
+	BasicScheduler<Core> scheduler(core, SchedulerMode::FixedRatio, movie.instructionsPerFrame);
+	MoviePlayer input(movie.events);
+	unsigned long long cycles = 0;
+	auto startTime = std::chrono::steady_clock::now();
+
+	// Halt is only checked between batches, a halted ROM spins harmlessly meanwhile
+	while (cycles < maxCycles && !core.is_halted())
+	{
+		// Recorded key changes land on the instruction they were recorded at
+		input.Apply(core, cycles);
+
+		unsigned long long batch = std::min(HEADLESS_BATCH_CYCLES, maxCycles - cycles);
+		batch = std::min<unsigned long long>(batch, input.get_next_cycle() - cycles);
+		scheduler.RunCycles(batch);
+		cycles += batch;
+	}
+
+	auto endTime = std::chrono::steady_clock::now();
+	double seconds = std::chrono::duration<double>(endTime - startTime).count();
+	double ips = seconds > 0.0 ? cycles / seconds : 0.0;
+
+	std::cout << "ROM:          " << romFilename << "\n"
+	          << "Quirks:       " << QuirkProfileName(profile) << "\n"
+	          << "Cycles:       " << cycles << "\n"
+	          << "Frames:       " << scheduler.get_frame_count() << "\n"
+	          << "Halted:       " << (core.is_halted() ? "yes" : "no") << "\n"
+	          << "State hash:   " << std::hex << core.StateHash() << std::dec << "\n"
+	          << "Elapsed (s):  " << seconds << "\n"
+	          << "Instr/second: " << static_cast<unsigned long long>(ips) << "\n";
+}
+
+int main(int argc, char** argv)
+{
+	// Declare variables by default in main scope
+	const char* romFilename = nullptr;
+	unsigned long long maxCycles = DEFAULT_HEADLESS_CYCLES;
+	Chip8Engine engine = Chip8Engine::Table;
+	const char* movieFilename = nullptr;
+	bool xochipEngine = false;
+
+	if (argc < 2 || argc > 5)
+	{
+		std::cerr << "Usage: " << argv[0] << " <ROM> [Cycles] [table|predecoded|block|jit|xochip] [Movie]\n";
+		std::exit(EXIT_FAILURE);
+	}
+
+	romFilename = argv[1];
+	if (argc >= 3)
+		maxCycles = std::stoull(argv[2]);
+	if (argc >= 4)
+	{
+		std::string engineName = argv[3];
+		if (engineName == "predecoded")
+			engine = Chip8Engine::Predecoded;
+		else if (engineName == "block")
+			engine = Chip8Engine::Block;
+		else if (engineName == "jit")
+			engine = Chip8Engine::Jit;
+		else if (engineName == "xochip")
+		{
+			if (argc >= 5)
+			{
+				std::cerr << "Error: movies are not supported by the xochip engine\n";
+				std::exit(EXIT_FAILURE);
+			}
+			xochipEngine = true;
+		}
+		else if (engineName != "table")
+		{
+			std::cerr << "Error: unknown engine " << engineName << "\n";
+			std::exit(EXIT_FAILURE);
+		}
+	}
+	if (argc >= 5)
+		movieFilename = argv[4];
+
+	std::shared_ptr<const RomImage> rom;
+	Chip8QuirkProfile profile = Chip8QuirkProfile::Default;
+	Movie movie;
+	movie.instructionsPerFrame = DEFAULT_INSTRUCTIONS_PER_FRAME;
+	try
+	{
+		rom = RomImage::Map(romFilename);
+
+		// The quirks follow the ROM unless CHIP8_QUIRKS names a profile
+		const char* quirks = std::getenv("CHIP8_QUIRKS");
+		profile = quirks ? ParseQuirkProfile(quirks) : DetectQuirkProfile(rom->get_data());
+
+		// A replay reproduces the recorded seed, speed and quirks on the recorded ROM
+		if (movieFilename)
+		{
+			movie = Movie::Load(movieFilename);
+			if (movie.romHash != rom->get_hash())
+				throw std::runtime_error("The movie was recorded with another ROM\n");
+			profile = movie.quirks;
+		}
+
+		// The xochip engine runs any ROM on the extended core, with its SUPER-CHIP quirks if detected
+		if (xochipEngine && profile != Chip8QuirkProfile::SuperChip)
+			profile = Chip8QuirkProfile::XoChip;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: " << e.what();
+		std::exit(EXIT_FAILURE);
+	}
+
+	// SUPER-CHIP and XO-CHIP programs need the extended core, the engine does not apply to it
+	if (profile == Chip8QuirkProfile::SuperChip || profile == Chip8QuirkProfile::XoChip)
+	{
+		XoChip xochip(profile);
+		try
+		{
+			xochip.LoadROM(rom->get_data());
+			if (movieFilename)
+				xochip.Seed(movie.seed);
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << "Error: " << e.what();
+			std::exit(EXIT_FAILURE);
+		}
+
+		RunHeadless(xochip, romFilename, profile, maxCycles, movie);
+		return 0;
+	}
+
+	Chip8 chip8(engine, profile);
+	if (CHIP8_PROFILING)
+		chip8.EnableProfiling(std::getenv("CHIP8_PROFILE_TIMING") != nullptr);
+	try
+	{
+		chip8.LoadROM(rom->get_data());
+		if (movieFilename)
+			chip8.Seed(movie.seed);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "Error: " << e.what();
+		std::exit(EXIT_FAILURE);
+	}
+
+	RunHeadless(chip8, romFilename, profile, maxCycles, movie);
+
+	// Handler table and hot PCs on stderr, folded stacks for flamegraph.pl or speedscope
+	if (const Profiler* profiler = chip8.get_profiler())
+	{
+		profiler->WriteReport(std::cerr);
+		std::ofstream folded(PROFILER_FOLDED_FILENAME);
+		profiler->WriteFolded(folded);
+	}
+
+	return 0;
+}
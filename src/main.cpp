@@ -1,6 +1,221 @@
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <functional>
 #include <iostream>
+#include <thread>
+#include "Audio.h"
 #include "Chip8.h"
+#include "Framebuffer.h"
+#include "Movie.h"
 #include "Platform.h"
+#include "RewindBuffer.h"
+#include "RomStore.h"
+#include "Scheduler.h"
+#include "TripleBuffer.h"
+#include "XoChip.h"
+
+/** @brief Instructions per frame of the XO-CHIP core when no delay is given, as in Octo. */
+const unsigned int XO_DEFAULT_INSTRUCTIONS_PER_FRAME = 1000;
+
+/** @brief Display of the CHIP-8 core handed to the SDL thread: the packed rows. */
+using Chip8Frame = std::array<uint64_t, VIDEO_HEIGHT>;
+
+/** @brief Display of the XO-CHIP core handed to the SDL thread: both planes and the mode. */
+struct XoFrame
+{
+	std::array<std::array<uint64_t, XO_VIDEO_HEIGHT * XO_ROW_WORDS>, XO_PLANE_COUNT> planes{}; /**< Packed bit-planes. */
+	bool hires = false;                                                                         /**< 128x64 mode. */
+};
+
+// ====== Presentation of each core ======
+
+// Uploads the rows drawn since the last present, straight from the CPU
+static void Present(Platform& platform, Chip8& chip8)
+{
+	// Only CLS and DRW touch the display, skip the upload and present otherwise
+	if (chip8.is_dirty())
+	{
+		platform.UpdatePacked(chip8.get_framebuffer().data(), chip8.get_dirty_rows());
+		chip8.ClearDirty();
+	}
+}
+
+static void Present(Platform& platform, XoChip& xo)
+{
+	if (uint64_t dirtyRows = xo.get_video_dirty_rows())
+	{
+		platform.UpdateRows(dirtyRows, [&xo](unsigned int firstRow, unsigned int rowCount, uint32_t* pixels, int pitch) {
+			xo.ExpandVideo(firstRow, rowCount, pixels, pitch);
+		});
+		xo.ClearDirty();
+	}
+}
+
+// Copies the display into a frame for the SDL thread, false when nothing was drawn
+static bool Capture(Chip8& chip8, Chip8Frame& frame)
+{
+	if (!chip8.is_dirty())
+		return false;
+
+	frame = chip8.get_framebuffer();
+	chip8.ClearDirty();
+	return true;
+}
+
+static bool Capture(XoChip& xo, XoFrame& frame)
+{
+	if (!xo.get_dirty_rows())
+		return false;
+
+	for (unsigned int plane = 0; plane < XO_PLANE_COUNT; ++plane)
+		std::ranges::copy(xo.get_plane(plane), frame.planes[plane].begin());
+	frame.hires = xo.is_hires();
+	xo.ClearDirty();
+	return true;
+}
+
+// Uploads the rows of a captured frame that differ from the ones on screen
+static void Present(Platform& platform, const Chip8Frame& frame, const Chip8Frame& presented, bool shown)
+{
+	uint64_t dirtyRows = shown ? 0 : ALL_ROWS_DIRTY;
+	for (unsigned int row = 0; row < VIDEO_HEIGHT; ++row)
+		dirtyRows |= frame[row] != presented[row] ? 1ULL << row : 0;
+	platform.UpdatePacked(frame.data(), dirtyRows);
+}
+
+static void Present(Platform& platform, const XoFrame& frame, const XoFrame& presented, bool shown)
+{
+	// A mode switch changes the scale of every row, a lo-res row covers two texture rows
+	uint64_t dirtyRows = shown && frame.hires == presented.hires ? 0 : ~0ULL;
+	const unsigned int scale = frame.hires ? 1 : 2;
+	for (unsigned int row = 0; row < XO_VIDEO_HEIGHT / scale; ++row)
+	{
+		for (unsigned int word = row * XO_ROW_WORDS; word < (row + 1) * XO_ROW_WORDS; ++word)
+		{
+			if (frame.planes[0][word] != presented.planes[0][word] || frame.planes[1][word] != presented.planes[1][word])
+				dirtyRows |= (frame.hires ? 1ULL : 3ULL) << (row * scale);
+		}
+	}
+
+	platform.UpdateRows(dirtyRows, [&frame](unsigned int firstRow, unsigned int rowCount, uint32_t* pixels, int pitch) {
+		ExpandPlanes(frame.planes[0].data(), frame.planes[1].data(), frame.hires, firstRow, rowCount, pixels, pitch);
+	});
+}
+
+/**
+ * @brief Runs the window until the user quits, the same way for both cores.
+ * @details Without CHIP8_THREADED, each iteration polls the input, runs one frame, presents and
+ * sleeps until the next deadline. With it, the CPU runs on its own thread and publishes the
+ * frames it draws through a triple buffer, this thread only handles SDL.
+ * @tparam Core Chip8 or XoChip.
+ * @tparam Frame Display snapshot of the core, filled by Capture().
+ * @param platform Window, with a texture of the size of the core's display.
+ * @param core CPU presented.
+ * @param scheduler Scheduler of the core, reading `input`.
+ * @param input Key changes queued by the platform.
+ * @param emulateFrame Runs one 60 Hz frame, steps back in time instead when its argument (rewinding) is true.
+ */
+template<typename Core, typename Frame>
+static void RunWindow(Platform& platform, Core& core, BasicScheduler<Core>& scheduler, InputQueue& input,
+                      const std::function<void(bool)>& emulateFrame)
+{
+	using Clock = typename BasicScheduler<Core>::Clock;
+	bool quit = false;
+
+	if (!std::getenv("CHIP8_THREADED"))
+	{
+		// One iteration per 60 Hz frame: poll input once, run the frames due, present, then
+		// sleep until the next deadline instead of spinning on the clock
+		while (!quit)
+		{
+			quit = platform.ProcessInput(input);
+			emulateFrame(platform.is_rewinding());
+			Present(platform, core);
+			scheduler.WaitForNextFrame();
+		}
+		return;
+	}
+
+	// The CPU runs on its own thread and publishes the frames it draws, this thread only
+	// handles SDL: a slow present or a vsync wait no longer holds the emulation back
+	TripleBuffer<Frame> frames;
+	std::atomic<bool> running = true;
+	std::atomic<bool> rewinding = false;
+
+	std::thread emulation([&] {
+		while (running.load(std::memory_order_relaxed))
+		{
+			emulateFrame(rewinding.load(std::memory_order_relaxed));
+			if (Capture(core, frames.get_write_buffer()))
+				frames.Publish();
+			scheduler.WaitForNextFrame();
+		}
+	});
+
+	Frame presented{};
+	bool shown = false;
+	typename Clock::time_point deadline = Clock::now();
+	while (!quit)
+	{
+		quit = platform.ProcessInput(input);
+		rewinding.store(platform.is_rewinding(), std::memory_order_relaxed);
+
+		// Frames the display was too slow for are skipped, the rows that changed since the
+		// last present are uploaded
+		if (frames.Update())
+		{
+			Present(platform, frames.get_read_buffer(), presented, shown);
+			presented = frames.get_read_buffer();
+			shown = true;
+		}
+
+		// Polled at 60 Hz on its own clock, a late present restarts it instead of catching up
+		deadline = std::max(deadline + BasicScheduler<Core>::FRAME_PERIOD, Clock::now());
+		std::this_thread::sleep_until(deadline);
+	}
+
+	running.store(false, std::memory_order_relaxed);
+	emulation.join();
+}
+
+/**
+ * @brief Plays a SUPER-CHIP / XO-CHIP ROM on the XoChip core.
+ * @details Same scheduler, input queue and window loop as the CHIP-8 core, plus the audio
+ * pattern and pitch of the ROM. Rewind and movies follow the Chip8 state, they are not
+ * available here: the rewind key is ignored.
+ * @param platform Window with a XO_VIDEO_WIDTH x XO_VIDEO_HEIGHT texture.
+ * @param rom ROM contents.
+ * @param cycleDelay Milliseconds per instruction, 0 for XO_DEFAULT_INSTRUCTIONS_PER_FRAME.
+ * @param profile Quirks of the ROM, SuperChip or XoChip.
+ * @return The exit code of the emulator.
+ */
+static int RunXoChip(Platform& platform, std::span<const uint8_t> rom, int cycleDelay, Chip8QuirkProfile profile)
+{
+	XoChip xo(profile);
+	xo.LoadROM(rom);
+	xo.Seed(std::chrono::system_clock::now().time_since_epoch().count());
+
+	// XO-CHIP programs are written for a fixed speed, a zero delay selects Octo's default
+	const unsigned int instructionsPerFrame = cycleDelay > 0
+		? std::max(1000u / (static_cast<unsigned int>(cycleDelay) * TIMER_FREQUENCY), 1u)
+		: XO_DEFAULT_INSTRUCTIONS_PER_FRAME;
+	XoScheduler scheduler(xo, SchedulerMode::RealTime, instructionsPerFrame);
+
+	AudioOutput audio;
+	InputQueue input;
+	scheduler.SetInput(&input);
+
+	RunWindow<XoChip, XoFrame>(platform, xo, scheduler, input, [&](bool) {
+		scheduler.Pump();
+
+		// The pattern plays while the sound timer runs, a ROM without F002 gets the plain beeper
+		audio.SetPattern(xo.get_audio_pattern(), xo.get_pitch());
+		audio.SetTone(xo.get_sound_timer() > 0);
+	});
+
+	return 0;
+}
 
 int main(int argc, char** argv)
 {
@@ -8,15 +223,16 @@ int main(int argc, char** argv)
 	const char* romFilename = nullptr;
 	int videoScale = DEFAULT_VIDEO_SCALE;
 	int cycleDelay = DEFAULT_CYCLE_DELAY;
+	const char* movieFilename = nullptr;
 
 	// Default values with only RomFile
 	if (argc == 2)
 	{
 		romFilename = argv[1];
 	}
-	else if (argc != 4)
+	else if (argc != 4 && argc != 5)
 	{
-		std::cerr << "Usage: " << argv[0] << " <ROM> [Scale] [Delay]\n";
+		std::cerr << "Usage: " << argv[0] << " <ROM> [Scale] [Delay] [Movie]\n";
 		std::exit(EXIT_FAILURE);
 	}
 	else
@@ -24,6 +240,8 @@ int main(int argc, char** argv)
 		romFilename = argv[1];
 		videoScale = std::stoi(argv[2]);
 		cycleDelay = std::stoi(argv[3]);
+		if (argc == 5)
+			movieFilename = argv[4];
 	}
 
 	// Make sure that romFilename is not null
@@ -33,32 +251,106 @@ int main(int argc, char** argv)
 		std::exit(EXIT_FAILURE);
 	}
 
+	// Uncapped timers tick by the wall clock, a replay could not reproduce them
+	if (movieFilename && cycleDelay <= 0)
+	{
+		std::cerr << "Error: movies are recorded with a delay above 0 only.\n";
+		std::exit(EXIT_FAILURE);
+	}
+
 
-	Platform platform("CHIP-8 Emulator", VIDEO_WIDTH * videoScale, VIDEO_HEIGHT * videoScale, VIDEO_WIDTH, VIDEO_HEIGHT);
+	// The quirks follow the ROM unless CHIP8_QUIRKS names a profile
+	std::shared_ptr<const RomImage> rom = RomImage::Map(romFilename);
+	const char* quirks = std::getenv("CHIP8_QUIRKS");
+	const Chip8QuirkProfile profile = quirks ? ParseQuirkProfile(quirks) : DetectQuirkProfile(rom->get_data());
+
+	// SUPER-CHIP and XO-CHIP programs need the extended core and its 128x64 display
+	if (profile == Chip8QuirkProfile::SuperChip || profile == Chip8QuirkProfile::XoChip)
+	{
+		if (movieFilename)
+		{
+			std::cerr << "Error: movies are recorded with the CHIP-8 core only.\n";
+			std::exit(EXIT_FAILURE);
+		}
 
-	Chip8 chip8;
-	chip8.LoadROM(romFilename);
+		Platform platform("CHIP-8 Emulator", VIDEO_WIDTH * videoScale, VIDEO_HEIGHT * videoScale, XO_VIDEO_WIDTH, XO_VIDEO_HEIGHT);
+		return RunXoChip(platform, rom->get_data(), cycleDelay, profile);
+	}
 
-	int videoPitch = sizeof(chip8.get_keypad()[0]) * VIDEO_WIDTH;
+	Platform platform("CHIP-8 Emulator", VIDEO_WIDTH * videoScale, VIDEO_HEIGHT * videoScale, VIDEO_WIDTH, VIDEO_HEIGHT);
+	Chip8 chip8(Chip8Engine::Table, profile);
+	if (CHIP8_PROFILING)
+		chip8.EnableProfiling(std::getenv("CHIP8_PROFILE_TIMING") != nullptr);
+	chip8.LoadROM(rom->get_data());
 
-	auto lastCycleTime = std::chrono::high_resolution_clock::now();
+	// The core is deterministic, a game session still gets fresh random numbers
+	uint64_t seed = std::chrono::system_clock::now().time_since_epoch().count();
+	chip8.Seed(seed);
+
+	// The delay keeps its meaning (milliseconds per instruction) but only sets the CPU speed,
+	// the timers always tick at 60 Hz. A zero delay runs the CPU uncapped.
+	SchedulerMode mode = cycleDelay > 0 ? SchedulerMode::RealTime : SchedulerMode::Uncapped;
+	unsigned int instructionsPerFrame = cycleDelay > 0
+		? std::max(1000u / (static_cast<unsigned int>(cycleDelay) * TIMER_FREQUENCY), 1u)
+		: DEFAULT_INSTRUCTIONS_PER_FRAME;
+	Scheduler scheduler(chip8, mode, instructionsPerFrame);
 	bool quit = false;
 
-	while (!quit)
-	{
-		quit = platform.ProcessInput(chip8.get_keypad().data());
+	// The beeper edges go through a lock-free ring, the SDL audio thread synthesises the samples
+	AudioOutput audio;
 
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastCycleTime).count();
+	// Key changes are timestamped in instructions, so chip8_headless replays them exactly
+	std::unique_ptr<MovieRecorder> recorder;
+	if (movieFilename)
+		recorder = std::make_unique<MovieRecorder>(seed, instructionsPerFrame, rom->get_data(), profile);
 
-		if (dt > cycleDelay)
-		{
-			lastCycleTime = currentTime;
+	// Key changes reach the CPU through a queue, applied at the instruction matching their time
+	InputQueue input;
+	scheduler.SetInput(&input, recorder.get());
 
-			chip8.Cycle();
+	// One snapshot per completed 60 Hz frame, delta-compressed into a fixed arena
+	RewindBuffer rewind;
+	Chip8State frameState;
 
-			platform.Update(chip8.get_video().data(), videoPitch);
+	// One 60 Hz frame of emulation, or one frame back in time while rewinding
+	auto emulateFrame = [&](bool rewinding) {
+		// A movie is a single timeline, rewinding is disabled while recording
+		if (rewinding && !recorder)
+		{
+			// One snapshot back per 60 Hz frame whatever the mode, the emulation resumes from there.
+			// The keypad stays the live one: a key released since that frame must not come back down.
+			scheduler.FlushInput();
+			if (rewind.StepBack(frameState))
+			{
+				const std::array<uint8_t, NUM_KEYS> keys = chip8.get_keypad();
+				chip8.LoadState(frameState);
+				for (uint8_t key = 0; key < NUM_KEYS; ++key)
+					chip8.SetKey(key, keys[key] != 0);
+			}
+			scheduler.Reset();
+			std::this_thread::sleep_until(scheduler.get_next_deadline());
+		}
+		else if (scheduler.Pump() > 0)
+		{
+			// Uncapped passes run a few instructions each, only those ending a frame are saved
+			chip8.SaveState(frameState);
+			rewind.Push(frameState);
 		}
+
+		// Only the edges are queued, a rewound state beeps as it did
+		audio.SetTone(chip8.get_sound_timer() > 0);
+	};
+
+	RunWindow<Chip8, Chip8Frame>(platform, chip8, scheduler, input, emulateFrame);
+
+	if (recorder)
+		recorder->get_movie().Save(movieFilename);
+
+	if (const Profiler* profiler = chip8.get_profiler())
+	{
+		profiler->WriteReport(std::cerr);
+		std::ofstream folded(PROFILER_FOLDED_FILENAME);
+		profiler->WriteFolded(folded);
 	}
 
 	return 0;
@@ -0,0 +1,165 @@
+#include "Movie.h"
+#include "Chip8.h"
+#include "XoChip.h"
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+// Bytes of the file header
+static constexpr std::size_t MOVIE_HEADER_SIZE = 32;
+
+// Bit of the event byte set for a press
+static constexpr uint8_t MOVIE_PRESSED_BIT = 0x80;
+
+// Appends `size` bytes of `value`, least significant first
+static void putLittleEndian(std::vector<uint8_t>& out, uint64_t value, std::size_t size)
+{
+	for (std::size_t i = 0; i < size; ++i)
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+}
+
+// Reads `size` bytes written by putLittleEndian()
+static uint64_t getLittleEndian(const uint8_t* in, std::size_t size)
+{
+	uint64_t value = 0;
+	for (std::size_t i = 0; i < size; ++i)
+		value |= static_cast<uint64_t>(in[i]) << (8 * i);
+	return value;
+}
+
+void Movie::Save(const std::string& filename) const
+{
+	std::vector<uint8_t> bytes;
+	bytes.reserve(MOVIE_HEADER_SIZE + 3 * events.size());
+
+	putLittleEndian(bytes, CHIP8_MOVIE_MAGIC, 4);
+	putLittleEndian(bytes, CHIP8_MOVIE_VERSION, 2);
+	putLittleEndian(bytes, static_cast<uint8_t>(quirks), 1);
+	putLittleEndian(bytes, 0, 1);
+	putLittleEndian(bytes, seed, 8);
+	putLittleEndian(bytes, romHash, 8);
+	putLittleEndian(bytes, instructionsPerFrame, 4);
+	putLittleEndian(bytes, events.size(), 4);
+
+	uint64_t previous = 0;
+	for (const InputEvent& event : events)
+	{
+		// Cycles since the previous event, 7 bits per byte
+		uint64_t delta = event.cycle - previous;
+		previous = event.cycle;
+		do
+		{
+			uint8_t byte = delta & 0x7F;
+			delta >>= 7;
+			bytes.push_back(delta ? byte | 0x80 : byte);
+		} while (delta);
+
+		bytes.push_back((event.key & 0x0F) | (event.pressed ? MOVIE_PRESSED_BIT : 0));
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open() || !file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size()))
+		throw std::runtime_error("Failed to write the movie " + filename + "\n");
+}
+
+Movie Movie::Load(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open the movie " + filename + "\n");
+
+	std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	if (bytes.size() < MOVIE_HEADER_SIZE || getLittleEndian(&bytes[0], 4) != CHIP8_MOVIE_MAGIC
+		|| getLittleEndian(&bytes[4], 2) != CHIP8_MOVIE_VERSION)
+		throw std::runtime_error("The movie " + filename + " is not compatible with this version of the emulator\n");
+
+	// A profile this version does not know cannot be replayed faithfully
+	if (bytes[6] > static_cast<uint8_t>(Chip8QuirkProfile::XoChip))
+		throw std::runtime_error("The movie " + filename + " uses unknown quirks\n");
+
+	Movie movie;
+	movie.quirks = static_cast<Chip8QuirkProfile>(bytes[6]);
+	movie.seed = getLittleEndian(&bytes[8], 8);
+	movie.romHash = getLittleEndian(&bytes[16], 8);
+	movie.instructionsPerFrame = static_cast<uint32_t>(getLittleEndian(&bytes[24], 4));
+	uint32_t count = static_cast<uint32_t>(getLittleEndian(&bytes[28], 4));
+
+	// Each event takes two bytes at least, do not trust the count beyond that
+	movie.events.reserve(std::min<std::size_t>(count, (bytes.size() - MOVIE_HEADER_SIZE) / 2));
+
+	std::size_t position = MOVIE_HEADER_SIZE;
+	uint64_t cycle = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		uint64_t delta = 0;
+		unsigned int shift = 0;
+		uint8_t byte;
+		do
+		{
+			if (position >= bytes.size() || shift >= 64)
+				throw std::runtime_error("The movie " + filename + " is truncated\n");
+			byte = bytes[position++];
+			delta |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			shift += 7;
+		} while (byte & 0x80);
+
+		if (position >= bytes.size())
+			throw std::runtime_error("The movie " + filename + " is truncated\n");
+		uint8_t key = bytes[position++];
+
+		cycle += delta;
+		movie.events.push_back(InputEvent{cycle, static_cast<uint8_t>(key & 0x0F), (key & MOVIE_PRESSED_BIT) != 0});
+	}
+
+	return movie;
+}
+
+uint64_t Movie::HashRom(std::span<const uint8_t> rom)
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;  // FNV-1a 64-bit offset basis
+	for (uint8_t byte : rom)
+	{
+		hash ^= byte;
+		hash *= 0x100000001B3ULL;           // FNV-1a 64-bit prime
+	}
+	return hash;
+}
+
+MovieRecorder::MovieRecorder(uint64_t seed, unsigned int instructionsPerFrame, std::span<const uint8_t> rom,
+                             Chip8QuirkProfile quirks)
+{
+	movie.seed = seed;
+	movie.romHash = Movie::HashRom(rom);
+	movie.instructionsPerFrame = instructionsPerFrame;
+	movie.quirks = quirks;
+}
+
+void MovieRecorder::Record(uint64_t cycle, std::span<const uint8_t, NUM_KEYS> keypad)
+{
+	for (uint8_t key = 0; key < NUM_KEYS; ++key)
+	{
+		bool pressed = keypad[key] != 0;
+		if (pressed == (keys[key] != 0))
+			continue;
+
+		movie.events.push_back(InputEvent{cycle, key, pressed});
+		keys[key] = pressed;
+	}
+}
+
+MoviePlayer::MoviePlayer(std::span<const InputEvent> events)
+	: events(events)
+{
+}
+
+template<typename Core>
+void MoviePlayer::Apply(Core& core, uint64_t cycle)
+{
+	for (; next < events.size() && events[next].cycle <= cycle; ++next)
+		core.SetKey(events[next].key, events[next].pressed);
+}
+
+template void MoviePlayer::Apply<Chip8>(Chip8&, uint64_t);
+template void MoviePlayer::Apply<XoChip>(XoChip&, uint64_t);
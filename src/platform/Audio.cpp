@@ -0,0 +1,190 @@
+#include "Audio.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+/** @brief Phase increment per sample of a frequency, a full period being 2^32. */
+static uint32_t phaseStep(double frequency, unsigned int sampleRate)
+{
+	return static_cast<uint32_t>(std::llround(frequency / sampleRate * 4294967296.0));
+}
+
+AudioSynth::AudioSynth(unsigned int sampleRate, unsigned int bufferSamples)
+	: sampleRate(sampleRate), bufferSamples(bufferSamples), step(phaseStep(AUDIO_TONE_FREQUENCY, sampleRate))
+{
+}
+
+bool AudioSynth::SetTone(bool on, uint64_t sample)
+{
+	if (on == this->queuedOn)
+		return true;
+
+	AudioEvent event;
+	event.sample = sample;
+	event.type = AudioEventType::Tone;
+	event.on = on;
+	if (!this->events.TryPush(event))
+		return false;
+
+	this->queuedOn = on;
+	return true;
+}
+
+bool AudioSynth::SetPattern(std::span<const uint8_t, AUDIO_PATTERN_SIZE> pattern, uint8_t pitch, uint64_t sample)
+{
+	if (pitch == this->queuedPattern.pitch && std::equal(pattern.begin(), pattern.end(), this->queuedPattern.pattern.begin()))
+		return true;
+
+	AudioEvent event = this->queuedPattern;
+	event.sample = sample;
+	event.pitch = pitch;
+	std::copy(pattern.begin(), pattern.end(), event.pattern.begin());
+	if (!this->events.TryPush(event))
+		return false;
+
+	this->queuedPattern = event;
+	return true;
+}
+
+void AudioSynth::Render(int16_t* out, std::size_t count)
+{
+	const int64_t buffer = this->bufferSamples;
+	std::size_t done = 0;
+
+	while (done < count)
+	{
+		std::size_t run = count - done;
+
+		// Apply the events due, stop the run at the first one still ahead
+		while (const AudioEvent* event = this->events.Peek())
+		{
+			int64_t lead = static_cast<int64_t>(event->sample - this->playhead);
+			if (!this->anchored || lead > 2 * buffer || lead < -buffer)
+			{
+				this->playhead = event->sample - buffer;
+				this->anchored = true;
+				lead = buffer;
+			}
+
+			if (lead > 0)
+			{
+				run = std::min(run, static_cast<std::size_t>(lead));
+				break;
+			}
+
+			this->Apply(*event);
+			this->events.Pop();
+		}
+
+		this->Synthesize(out + done, run);
+		done += run;
+		this->playhead += run;
+	}
+}
+
+void AudioSynth::Apply(const AudioEvent& event)
+{
+	if (event.type == AudioEventType::Tone)
+	{
+		// Every beep starts on the same edge of the wave
+		if (event.on && !this->on)
+			this->phase = 0;
+		this->on = event.on;
+		return;
+	}
+
+	// 4000 bits per second at pitch 64, an octave every 48 steps; 128 bits span the full phase
+	double rate = AUDIO_PATTERN_BASE_RATE * std::exp2((event.pitch - 64) / 48.0);
+	this->step = phaseStep(rate / 128.0, this->sampleRate);
+	this->pattern = event.pattern;
+	this->patterned = true;
+}
+
+void AudioSynth::Synthesize(int16_t* out, std::size_t count)
+{
+	if (!this->on)
+	{
+		std::memset(out, 0, count * sizeof(int16_t));
+		return;
+	}
+
+	uint32_t phase = this->phase;
+	if (this->patterned)
+	{
+		for (std::size_t i = 0; i < count; ++i, phase += this->step)
+		{
+			const unsigned int bit = phase >> 25u;
+			out[i] = (this->pattern[bit >> 3u] >> (7u - (bit & 7u))) & 1u ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+		}
+	}
+	else
+	{
+		for (std::size_t i = 0; i < count; ++i, phase += this->step)
+			out[i] = phase < 0x80000000u ? AUDIO_AMPLITUDE : -AUDIO_AMPLITUDE;
+	}
+	this->phase = phase;
+}
+
+AudioOutput::AudioOutput(unsigned int sampleRate, unsigned int bufferSamples)
+	: synth(std::make_unique<AudioSynth>(sampleRate, bufferSamples)), start(std::chrono::steady_clock::now())
+{
+	if (SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
+		return;
+
+	SDL_AudioSpec desired{};
+	desired.freq = static_cast<int>(sampleRate);
+	desired.format = AUDIO_S16SYS;
+	desired.channels = 1;
+	desired.samples = static_cast<Uint16>(bufferSamples);
+	desired.callback = &AudioOutput::Callback;
+	desired.userdata = this->synth.get();
+
+	// No allowed change: SDL converts to the device format and the synthesiser keeps its rate
+	this->device = SDL_OpenAudioDevice(nullptr, 0, &desired, &this->spec, 0);
+	if (this->device == 0)
+	{
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+		return;
+	}
+
+	SDL_PauseAudioDevice(this->device, 0);
+}
+
+AudioOutput::~AudioOutput()
+{
+	if (this->device == 0)
+		return;
+
+	SDL_CloseAudioDevice(this->device);
+	SDL_QuitSubSystem(SDL_INIT_AUDIO);
+}
+
+double AudioOutput::get_latency() const
+{
+	// One buffer of scheduling delay, one being filled and one being played
+	return this->is_open() ? 3.0 * this->spec.samples / this->spec.freq : 0.0;
+}
+
+void AudioOutput::SetTone(bool on)
+{
+	if (this->is_open())
+		this->synth->SetTone(on, this->Now());
+}
+
+void AudioOutput::SetPattern(std::span<const uint8_t, AUDIO_PATTERN_SIZE> pattern, uint8_t pitch)
+{
+	if (this->is_open())
+		this->synth->SetPattern(pattern, pitch, this->Now());
+}
+
+void AudioOutput::Callback(void* userdata, Uint8* stream, int length)
+{
+	static_cast<AudioSynth*>(userdata)->Render(reinterpret_cast<int16_t*>(stream), static_cast<std::size_t>(length) / sizeof(int16_t));
+}
+
+uint64_t AudioOutput::Now() const
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->start;
+	return static_cast<uint64_t>(elapsed.count() * this->synth->get_sample_rate());
+}
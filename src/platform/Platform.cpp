@@ -1,6 +1,17 @@
 #include "Platform.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include "Framebuffer.h"
+
+/** @brief Keyboard key of each CHIP-8 key, indexed by key number. */
+static const std::array<SDL_Keycode, NUM_KEYS> keymap = {
+    SDLK_x, SDLK_1, SDLK_2, SDLK_3, SDLK_q, SDLK_w, SDLK_e, SDLK_a,
+    SDLK_s, SDLK_d, SDLK_z, SDLK_c, SDLK_4, SDLK_r, SDLK_f, SDLK_v
+};
 
 Platform::Platform(char const* title, int windowWidth, int windowHeight, int textureWidth, int textureHeight)
+    : textureWidth(textureWidth), textureHeight(textureHeight)
 {
     SDL_Init(SDL_INIT_VIDEO);
 
@@ -28,12 +39,86 @@ void Platform::Update(const void* buffer, int pitch)
     SDL_RenderPresent(renderer);
 }
 
+void Platform::UpdatePacked(const uint64_t* rows, uint64_t dirtyRows)
+{
+    // Expand directly into the texture memory, no intermediate RGBA copy
+    UpdateRows(dirtyRows, [this, rows](unsigned int firstRow, unsigned int rowCount, uint32_t* pixels, int pitch) {
+        ExpandFramebuffer(rows + firstRow, rowCount, pixels, pitch, onColor, offColor);
+    });
+}
+
+void Platform::UpdateRows(uint64_t dirtyRows, const RowWriter& write)
+{
+    // Nothing changed on screen: no upload and no present
+    dirtyRows &= (textureHeight >= 64) ? ~0ULL : (1ULL << textureHeight) - 1;
+    if (!dirtyRows)
+        return;
+
+    // Upload the span from the first to the last dirty row
+    int firstRow = std::countr_zero(dirtyRows);
+    int lastRow = 63 - std::countl_zero(dirtyRows);
+    SDL_Rect span{0, firstRow, textureWidth, lastRow - firstRow + 1};
+
+    void* pixels = nullptr;
+    int pitch = 0;
+
+    if (SDL_LockTexture(texture, &span, &pixels, &pitch) == 0)
+    {
+        write(firstRow, span.h, static_cast<uint32_t*>(pixels), pitch);
+        SDL_UnlockTexture(texture);
+    }
+
+    SDL_RenderClear(renderer);
+    SDL_RenderCopy(renderer, texture, nullptr, nullptr);
+    SDL_RenderPresent(renderer);
+}
+
+void Platform::SetColors(uint32_t on, uint32_t off)
+{
+    onColor = on;
+    offColor = off;
+}
+
 bool Platform::ProcessInput(uint8_t* keys)
+{
+    return PollEvents([keys](uint8_t key, bool pressed, std::chrono::steady_clock::time_point) {
+        keys[key] = pressed ? 1 : 0;
+    });
+}
+
+bool Platform::ProcessInput(InputQueue& input)
+{
+    // The queue holds several frames of changes, it is only full when the CPU stopped reading it.
+    // What did not fit is retried first, a key keeps only its latest state meanwhile.
+    for (uint16_t pending = unsentKeys; pending; pending &= pending - 1)
+    {
+        const unsigned int key = std::countr_zero(pending);
+        if (!input.TryPush(unsent[key]))
+            break;
+        unsentKeys &= ~(1u << key);
+    }
+
+    return PollEvents([this, &input](uint8_t key, bool pressed, std::chrono::steady_clock::time_point time) {
+        // A change queued behind an unsent one of the same key would reach the CPU first
+        const KeyEvent event{time, key, pressed};
+        if ((unsentKeys & (1u << key)) || !input.TryPush(event))
+        {
+            unsent[key] = event;
+            unsentKeys |= 1u << key;
+        }
+    });
+}
+
+bool Platform::PollEvents(const KeyHandler& onKey)
 {
     bool quit = false;
 
     SDL_Event event;
 
+    // SDL stamps the events in milliseconds since its initialisation, moved here onto the host clock
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const Uint32 ticks = SDL_GetTicks();
+
     while (SDL_PollEvent(&event))
     {
         switch (event.type)
@@ -45,183 +130,31 @@ bool Platform::ProcessInput(uint8_t* keys)
 
             // no handling of undesired keys, considered out of scope
             case SDL_KEYDOWN:
+            case SDL_KEYUP:
             {
-                switch (event.key.keysym.sym)
+                // A held key repeats its press, the keypad only sees the first one
+                if (event.key.repeat != 0)
+                    break;
+
+                const bool pressed = event.type == SDL_KEYDOWN;
+                const SDL_Keycode sym = event.key.keysym.sym;
+
+                if (sym == SDLK_ESCAPE)
                 {
-                    case SDLK_ESCAPE:
-                    {
-                        quit = true;
-                    } break;
-
-                    case SDLK_x:
-                    {
-                        keys[0] = 1;
-                    } break;
-
-                    case SDLK_1:
-                    {
-                        keys[1] = 1;
-                    } break;
-
-                    case SDLK_2:
-                    {
-                        keys[2] = 1;
-                    } break;
-
-                    case SDLK_3:
-                    {
-                        keys[3] = 1;
-                    } break;
-
-                    case SDLK_q:
-                    {
-                        keys[4] = 1;
-                    } break;
-
-                    case SDLK_w:
-                    {
-                        keys[5] = 1;
-                    } break;
-
-                    case SDLK_e:
-                    {
-                        keys[6] = 1;
-                    } break;
-
-                    case SDLK_a:
-                    {
-                        keys[7] = 1;
-                    } break;
-
-                    case SDLK_s:
-                    {
-                        keys[8] = 1;
-                    } break;
-
-                    case SDLK_d:
-                    {
-                        keys[9] = 1;
-                    } break;
-
-                    case SDLK_z:
-                    {
-                        keys[0xA] = 1;
-                    } break;
-
-                    case SDLK_c:
-                    {
-                        keys[0xB] = 1;
-                    } break;
-
-                    case SDLK_4:
-                    {
-                        keys[0xC] = 1;
-                    } break;
-
-                    case SDLK_r:
-                    {
-                        keys[0xD] = 1;
-                    } break;
-
-                    case SDLK_f:
-                    {
-                        keys[0xE] = 1;
-                    } break;
-
-                    case SDLK_v:
-                    {
-                        keys[0xF] = 1;
-                    } break;
+                    quit = quit || pressed;
                 }
-            } break;
-
-            case SDL_KEYUP:
-            {
-                switch (event.key.keysym.sym)
+                else if (sym == SDLK_BACKSPACE)
                 {
-                    case SDLK_x:
-                    {
-                        keys[0] = 0;
-                    } break;
-
-                    case SDLK_1:
-                    {
-                        keys[1] = 0;
-                    } break;
-
-                    case SDLK_2:
-                    {
-                        keys[2] = 0;
-                    } break;
-
-                    case SDLK_3:
-                    {
-                        keys[3] = 0;
-                    } break;
-
-                    case SDLK_q:
-                    {
-                        keys[4] = 0;
-                    } break;
-
-                    case SDLK_w:
-                    {
-                        keys[5] = 0;
-                    } break;
-
-                    case SDLK_e:
-                    {
-                        keys[6] = 0;
-                    } break;
-
-                    case SDLK_a:
-                    {
-                        keys[7] = 0;
-                    } break;
-
-                    case SDLK_s:
-                    {
-                        keys[8] = 0;
-                    } break;
-
-                    case SDLK_d:
-                    {
-                        keys[9] = 0;
-                    } break;
-
-                    case SDLK_z:
-                    {
-                        keys[0xA] = 0;
-                    } break;
-
-                    case SDLK_c:
-                    {
-                        keys[0xB] = 0;
-                    } break;
-
-                    case SDLK_4:
-                    {
-                        keys[0xC] = 0;
-                    } break;
-
-                    case SDLK_r:
-                    {
-                        keys[0xD] = 0;
-                    } break;
-
-                    case SDLK_f:
-                    {
-                        keys[0xE] = 0;
-                    } break;
-
-                    case SDLK_v:
-                    {
-                        keys[0xF] = 0;
-                    } break;
+                    rewinding = pressed;
+                }
+                else if (auto mapped = std::find(keymap.begin(), keymap.end(), sym); mapped != keymap.end())
+                {
+                    const Uint32 age = event.key.timestamp <= ticks ? ticks - event.key.timestamp : 0;
+                    onKey(static_cast<uint8_t>(mapped - keymap.begin()), pressed, now - std::chrono::milliseconds(age));
                 }
             } break;
         }
     }
 
     return quit;
-}
\ No newline at end of file
+}
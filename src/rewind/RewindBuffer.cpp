@@ -0,0 +1,240 @@
+#include "RewindBuffer.h"
+
+#include <array>
+#include <cstring>
+#include <stdexcept>
+
+// Bytes of an encoded frame, raw at worst
+static constexpr std::size_t FRAME_SIZE = sizeof(Chip8State);
+
+// Keyframes are encoded against an all-zero state
+static const std::array<uint8_t, FRAME_SIZE> zeroFrame{};
+
+// An unchanged run shorter than a token header is cheaper to keep inside the changed run
+static constexpr std::size_t TOKEN_HEADER_SIZE = 2 * sizeof(uint16_t);
+
+RewindBuffer::RewindBuffer(std::size_t arenaSize, std::size_t maxFrames, unsigned int keyframeInterval)
+	: keyframeInterval(keyframeInterval)
+{
+	if (arenaSize < 2 * FRAME_SIZE || arenaSize > UINT32_MAX)
+		throw std::runtime_error("Rewind arena size must be between two states and 4GB\n");
+
+	if (maxFrames < 2 || keyframeInterval == 0)
+		throw std::runtime_error("Rewind buffer needs at least two frames and a keyframe interval\n");
+
+	arena.resize(arenaSize);
+	records.resize(maxFrames);
+}
+
+void RewindBuffer::Push(const Chip8State& state)
+{
+	if (count == records.size())
+		EvictOldest();
+
+	std::size_t offset = Reserve();
+
+	// Reserve() may have evicted the keyframe of the newest deltas, start over from a keyframe then
+	bool keyframe = count == 0 || sinceKeyframe + 1 >= keyframeInterval;
+	const uint8_t* previous = keyframe ? zeroFrame.data() : reinterpret_cast<const uint8_t*>(&current);
+
+	std::size_t size = Encode(reinterpret_cast<const uint8_t*>(&state), previous, FRAME_SIZE, arena.data() + offset);
+
+	At(count) = Record{static_cast<uint32_t>(offset), static_cast<uint16_t>(size), keyframe};
+	++count;
+	sinceKeyframe = keyframe ? 0 : sinceKeyframe + 1;
+
+	head = (offset + size) % arena.size();
+	used += size;
+	current = state;
+}
+
+bool RewindBuffer::StepBack(Chip8State& state)
+{
+	if (count < 2)
+		return false;
+
+	const Record newest = At(count - 1);
+
+	if (!newest.keyframe)
+	{
+		// frame ^ (frame ^ previous) = previous
+		Apply(newest, current);
+		--sinceKeyframe;
+	}
+	else
+	{
+		// The previous frame closes the previous segment, replay it from its keyframe
+		std::size_t last = count - 2;
+		std::size_t key = last;
+		while (!At(key).keyframe)
+			--key;
+
+		for (std::size_t age = key; age <= last; ++age)
+			Apply(At(age), current);
+		sinceKeyframe = static_cast<unsigned int>(last - key);
+	}
+
+	used -= (head + arena.size() - newest.offset) % arena.size();
+	head = newest.offset;
+	--count;
+
+	state = current;
+	return true;
+}
+
+void RewindBuffer::Clear()
+{
+	first = 0;
+	count = 0;
+	head = 0;
+	tail = 0;
+	used = 0;
+	sinceKeyframe = 0;
+}
+
+std::size_t RewindBuffer::Reserve()
+{
+	while (true)
+	{
+		if (count == 0)
+		{
+			Clear();
+			return 0;
+		}
+
+		// Frames in [tail, head), free space after head then before tail
+		if (head > tail || used == 0)
+		{
+			if (arena.size() - head >= FRAME_SIZE)
+				return head;
+
+			if (tail >= FRAME_SIZE)
+			{
+				// Leave the end of the arena as padding, released with the frame before it
+				used += arena.size() - head;
+				head = 0;
+				return head;
+			}
+		}
+		// Frames in [tail, end) and [0, head), free space between them
+		else if (tail - head >= FRAME_SIZE)
+		{
+			return head;
+		}
+
+		EvictOldest();
+	}
+}
+
+void RewindBuffer::EvictOldest()
+{
+	// A delta is useless without its keyframe, drop the whole segment
+	do
+	{
+		if (count == 1)
+		{
+			Clear();
+			return;
+		}
+
+		std::size_t next = At(1).offset;
+		used -= (next + arena.size() - tail) % arena.size();
+		tail = next;
+		first = (first + 1) % records.size();
+		--count;
+	} while (!At(0).keyframe);
+}
+
+void RewindBuffer::Apply(const Record& record, Chip8State& state) const
+{
+	uint8_t* target = reinterpret_cast<uint8_t*>(&state);
+	const uint8_t* in = arena.data() + record.offset;
+	const uint8_t* end = in + record.size;
+
+	if (record.keyframe)
+		std::memset(target, 0, FRAME_SIZE);
+
+	if (record.size == FRAME_SIZE)
+	{
+		for (std::size_t i = 0; i < FRAME_SIZE; ++i)
+			target[i] ^= in[i];
+		return;
+	}
+
+	std::size_t position = 0;
+	while (in < end)
+	{
+		uint16_t skip, length;
+		std::memcpy(&skip, in, sizeof(skip));
+		std::memcpy(&length, in + sizeof(skip), sizeof(length));
+		in += TOKEN_HEADER_SIZE;
+
+		position += skip;
+		for (uint16_t i = 0; i < length; ++i)
+			target[position + i] ^= in[i];
+
+		position += length;
+		in += length;
+	}
+}
+
+std::size_t RewindBuffer::Encode(const uint8_t* a, const uint8_t* b, std::size_t size, uint8_t* out)
+{
+	std::size_t position = 0;
+	std::size_t written = 0;
+
+	while (position < size)
+	{
+		// Unchanged run, a word at a time
+		std::size_t start = position;
+		while (position + sizeof(uint64_t) <= size)
+		{
+			uint64_t x, y;
+			std::memcpy(&x, a + position, sizeof(x));
+			std::memcpy(&y, b + position, sizeof(y));
+			if (x != y)
+				break;
+			position += sizeof(uint64_t);
+		}
+		while (position < size && a[position] == b[position])
+			++position;
+
+		// Trailing unchanged bytes need no token
+		if (position == size)
+			break;
+
+		std::size_t skip = position - start;
+
+		// Changed run, until an unchanged run long enough to pay for a new token
+		std::size_t changed = position;
+		while (position < size)
+		{
+			std::size_t same = 0;
+			while (same < TOKEN_HEADER_SIZE && position + same < size && a[position + same] == b[position + same])
+				++same;
+
+			if (same == TOKEN_HEADER_SIZE || position + same == size)
+				break;
+			position += same + 1;
+		}
+		std::size_t length = position - changed;
+
+		// Not smaller than the raw delta, store that instead
+		if (written + TOKEN_HEADER_SIZE + length >= size)
+		{
+			for (std::size_t i = 0; i < size; ++i)
+				out[i] = a[i] ^ b[i];
+			return size;
+		}
+
+		uint16_t header[2] = {static_cast<uint16_t>(skip), static_cast<uint16_t>(length)};
+		std::memcpy(out + written, header, TOKEN_HEADER_SIZE);
+		written += TOKEN_HEADER_SIZE;
+
+		for (std::size_t i = 0; i < length; ++i)
+			out[written + i] = a[changed + i] ^ b[changed + i];
+		written += length;
+	}
+
+	return written;
+}
@@ -0,0 +1,156 @@
+#include "RomStore.h"
+#include "Movie.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHIP8_ROM_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<const RomImage> RomImage::Map(const std::string& filename)
+{
+	std::shared_ptr<RomImage> image(new RomImage());
+	image->name = filename;
+
+#ifdef CHIP8_ROM_MMAP
+	int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw std::runtime_error("Failed to open the ROM " + filename + "\n");
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("Failed to read the ROM " + filename + "\n");
+	}
+
+	// Check the size first, an empty file cannot be mapped and a huge one is not worth it
+	std::size_t size = static_cast<std::size_t>(info.st_size);
+	if (size == 0 || size > MAX_ROM_SIZE)
+	{
+		close(fd);
+		Validate(size, filename);
+	}
+
+	void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+		throw std::runtime_error("Failed to map the ROM " + filename + "\n");
+
+	image->mapping = mapping;
+	image->mappingSize = size;
+	image->data = std::span<const uint8_t>(static_cast<const uint8_t*>(mapping), size);
+#else
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+		throw std::runtime_error("Failed to open the ROM " + filename + "\n");
+
+	image->buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	image->data = image->buffer;
+#endif
+
+	image->Seal();
+	return image;
+}
+
+std::shared_ptr<const RomImage> RomImage::Copy(std::span<const uint8_t> rom, const std::string& name)
+{
+	Validate(rom.size(), name);
+
+	std::shared_ptr<RomImage> image(new RomImage());
+	image->name = name;
+	image->buffer.assign(rom.begin(), rom.end());
+	image->data = image->buffer;
+	image->Seal();
+	return image;
+}
+
+void RomImage::Validate(std::size_t size, const std::string& name)
+{
+	if (size == 0)
+		throw std::runtime_error("The ROM " + name + " is empty\n");
+	if (size > MAX_ROM_SIZE)
+		throw std::runtime_error("The ROM " + name + " is bigger than the memory above 0x200\n");
+}
+
+RomImage::~RomImage()
+{
+#ifdef CHIP8_ROM_MMAP
+	if (mapping)
+		munmap(mapping, mappingSize);
+#endif
+}
+
+void RomImage::Seal()
+{
+	Validate(data.size(), name);
+	hash = Movie::HashRom(data);
+}
+
+std::shared_ptr<const RomImage> RomStore::Open(const std::string& filename)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto found = paths.find(filename);
+		if (found != paths.end())
+			return found->second;
+	}
+
+	// Map outside the lock, the file system is the slow part
+	std::shared_ptr<const RomImage> image = RomImage::Map(filename);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	image = Intern(std::move(image));
+	paths.emplace(filename, image);
+	return image;
+}
+
+std::shared_ptr<const RomImage> RomStore::Add(std::span<const uint8_t> rom, const std::string& name)
+{
+	RomImage::Validate(rom.size(), name);
+	uint64_t hash = Movie::HashRom(rom);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = images.find(hash);
+	if (found != images.end() && std::ranges::equal(found->second->get_data(), rom))
+		return found->second;
+
+	return Intern(RomImage::Copy(rom, name));
+}
+
+std::shared_ptr<const RomImage> RomStore::Find(uint64_t hash) const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto found = images.find(hash);
+	return found != images.end() ? found->second : nullptr;
+}
+
+std::size_t RomStore::get_size() const
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return images.size();
+}
+
+void RomStore::Clear()
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	paths.clear();
+	images.clear();
+}
+
+std::shared_ptr<const RomImage> RomStore::Intern(std::shared_ptr<const RomImage> image)
+{
+	auto [found, inserted] = images.emplace(image->get_hash(), image);
+	if (inserted || !std::ranges::equal(found->second->get_data(), image->get_data()))
+		return image;
+
+	// Same contents already held, the new image is dropped (and unmapped) right away
+	return found->second;
+}
@@ -0,0 +1,320 @@
+#include "XoChip.h"
+#include "Framebuffer.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <stdexcept>
+
+XoChip::XoChip(Chip8QuirkProfile profile)
+	: quirkProfile(profile)
+{
+	// Load both fonts into memory
+	std::copy(fontset.begin(), fontset.end(), memory.begin() + FONTSET_START_ADDRESS);
+	std::copy(bigFontset.begin(), bigFontset.end(), memory.begin() + BIG_FONTSET_START_ADDRESS);
+
+	// Set up function pointer tables
+	InitializeTables();
+}
+
+void XoChip::LoadROM(std::span<const uint8_t> rom)
+{
+	if (rom.size() > XO_MEMORY_SIZE - START_ADDRESS)
+		throw std::runtime_error("The size of the loaded ROM is bigger than actual memory size\n");
+
+	std::copy(rom.begin(), rom.end(), memory.begin() + START_ADDRESS);
+}
+
+void XoChip::Seed(uint64_t seed)
+{
+	rng.Seed(seed);
+}
+
+void XoChip::Cycle()
+{
+	opcode = Fetch(pc);
+	pc += 2;
+	((*this).*(table[opcode >> 12u]))();
+}
+
+void XoChip::Run(uint64_t cycles)
+{
+	for (uint64_t i = 0; i < cycles; ++i)
+	{
+		opcode = Fetch(pc);
+		pc += 2;
+		((*this).*(table[opcode >> 12u]))();
+	}
+}
+
+void XoChip::TickTimers()
+{
+	if (delayTimer > 0)
+		--delayTimer;
+	if (soundTimer > 0)
+		--soundTimer;
+}
+
+Chip8IdleState XoChip::get_idle_state() const
+{
+	if (is_halted())
+		return Chip8IdleState::Halted;
+
+	// Fx0A rewinds the PC onto itself as long as no key is down
+	if ((opcode & 0xF0FFu) == 0xF00Au && Fetch(pc) == opcode
+		&& std::none_of(keypad.begin(), keypad.end(), [](uint8_t key) { return key != 0; }))
+		return Chip8IdleState::WaitingForKey;
+
+	// LD Vx, DT ; SE/SNE Vx, kk ; JP back to the LD, with Vx already holding the timer.
+	// The PC may be on any of the three, the previous instruction of the loop must have just run.
+	for (uint16_t offset = 0; offset <= 4; offset += 2)
+	{
+		const uint16_t start = pc - offset;
+		if (start > 0x0FFFu - 4)
+			continue;
+
+		const uint16_t load = Fetch(start);
+		const uint16_t test = Fetch(start + 2);
+		const uint16_t jump = Fetch(start + 4);
+		const uint16_t previous = offset == 0 ? jump : Fetch(pc - 2);
+		const uint8_t Vx = (load & 0x0F00u) >> 8u;
+		const uint8_t byte = test & 0x00FFu;
+
+		if ((load & 0xF0FFu) != 0xF007u || jump != (0x1000u | start) || ((test & 0x0F00u) >> 8u) != Vx
+			|| opcode != previous || registers[Vx] != delayTimer)
+			continue;
+
+		// The loop goes on as long as the test does not skip the jump
+		if ((test & 0xF000u) == 0x3000u && delayTimer != byte)
+			return Chip8IdleState::WaitingForTimer;
+		if ((test & 0xF000u) == 0x4000u && delayTimer == byte)
+			return Chip8IdleState::WaitingForTimer;
+	}
+
+	return Chip8IdleState::Running;
+}
+
+uint64_t XoChip::SkipIdleCycles(uint64_t cycles) const
+{
+	switch (get_idle_state())
+	{
+	case Chip8IdleState::Halted:
+	case Chip8IdleState::WaitingForKey:
+		return cycles;
+	case Chip8IdleState::WaitingForTimer:
+		// Whole iterations only, the CPU must end at the same point of the loop
+		return cycles - cycles % 3;
+	case Chip8IdleState::Running:
+	default:
+		return 0;
+	}
+}
+
+uint64_t XoChip::StateHash() const
+{
+	uint64_t hash = 0xCBF29CE484222325ULL;  // FNV-1a 64-bit offset basis
+
+	auto mix = [&hash](const void* data, std::size_t size) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		for (std::size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ULL;       // FNV-1a 64-bit prime
+		}
+	};
+
+	mix(registers.data(), registers.size());
+	mix(memory.data(), memory.size());
+	mix(&index, sizeof(index));
+	mix(&pc, sizeof(pc));
+	mix(&sp, sizeof(sp));
+	mix(stack.data(), stack.size() * sizeof(uint16_t));
+	mix(&delayTimer, sizeof(delayTimer));
+	mix(&soundTimer, sizeof(soundTimer));
+	for (const auto& plane : planes)
+		mix(plane.data(), plane.size() * sizeof(uint64_t));
+	mix(&planeMask, sizeof(planeMask));
+	mix(&hires, sizeof(hires));
+
+	return hash;
+}
+
+std::vector<uint32_t> XoChip::get_video(const std::array<uint32_t, 4>& palette) const
+{
+	std::vector<uint32_t> pixels(XO_VIDEO_WIDTH * XO_VIDEO_HEIGHT);
+	ExpandVideo(0, XO_VIDEO_HEIGHT, pixels.data(), XO_VIDEO_WIDTH * sizeof(uint32_t), palette);
+	return pixels;
+}
+
+void XoChip::ExpandVideo(unsigned int firstRow, unsigned int rowCount, uint32_t* pixels, int pitch,
+                         const std::array<uint32_t, 4>& palette) const
+{
+	ExpandPlanes(planes[0].data(), planes[1].data(), hires, firstRow, rowCount, pixels, pitch, palette);
+}
+
+uint64_t XoChip::get_video_dirty_rows() const
+{
+	if (hires)
+		return dirtyRows;
+
+	// Each lo-res row is drawn twice
+	uint64_t rows = 0;
+	for (uint64_t dirty = dirtyRows & 0xFFFFFFFFULL; dirty; dirty &= dirty - 1)
+		rows |= 3ULL << (2 * std::countr_zero(dirty));
+	return rows;
+}
+
+void XoChip::InitializeTables()
+{
+	// Fill all tables with OP_NULL
+	table.fill(&XoChip::OP_NULL);
+	table0.fill(&XoChip::OP_NULL);
+	table5.fill(&XoChip::OP_NULL);
+	table8.fill(&XoChip::OP_NULL);
+	tableE.fill(&XoChip::OP_NULL);
+	tableF.fill(&XoChip::OP_NULL);
+
+	// Primary opcode table
+	table[0x0] = &XoChip::Table0;
+	table[0x1] = &XoChip::OP_1nnn;
+	table[0x2] = &XoChip::OP_2nnn;
+	table[0x3] = &XoChip::OP_3xkk;
+	table[0x4] = &XoChip::OP_4xkk;
+	table[0x5] = &XoChip::Table5;
+	table[0x6] = &XoChip::OP_6xkk;
+	table[0x7] = &XoChip::OP_7xkk;
+	table[0x8] = &XoChip::Table8;
+	table[0x9] = &XoChip::OP_9xy0;
+	table[0xA] = &XoChip::OP_Annn;
+	table[0xC] = &XoChip::OP_Cxkk;
+	table[0xE] = &XoChip::TableE;
+	table[0xF] = &XoChip::TableF;
+
+	// Table 0 (Display and Return), the scrolls carry their amount in the last nibble
+	for (unsigned int n = 0; n < 0x10; ++n)
+	{
+		table0[0xC0 | n] = &XoChip::OP_00Cn;
+		table0[0xD0 | n] = &XoChip::OP_00Dn;
+	}
+	table0[0xE0] = &XoChip::OP_00E0;
+	table0[0xEE] = &XoChip::OP_00EE;
+	table0[0xFB] = &XoChip::OP_00FB;
+	table0[0xFC] = &XoChip::OP_00FC;
+	table0[0xFD] = &XoChip::OP_00FD;
+	table0[0xFE] = &XoChip::OP_00FE;
+	table0[0xFF] = &XoChip::OP_00FF;
+
+	// Table 5 (Register ranges)
+	table5[0x0] = &XoChip::OP_5xy0;
+	table5[0x2] = &XoChip::OP_5xy2;
+	table5[0x3] = &XoChip::OP_5xy3;
+
+	// Table 8 (Arithmetic)
+	table8[0x0] = &XoChip::OP_8xy0;
+	table8[0x4] = &XoChip::OP_8xy4;
+	table8[0x5] = &XoChip::OP_8xy5;
+	table8[0x7] = &XoChip::OP_8xy7;
+
+	// Table E (Key handling)
+	tableE[0x1] = &XoChip::OP_ExA1;
+	tableE[0xE] = &XoChip::OP_Ex9E;
+
+	// Table F (Timers, memory, keyboard, planes and audio)
+	tableF[0x00] = &XoChip::OP_F000;
+	tableF[0x01] = &XoChip::OP_Fn01;
+	tableF[0x02] = &XoChip::OP_F002;
+	tableF[0x07] = &XoChip::OP_Fx07;
+	tableF[0x0A] = &XoChip::OP_Fx0A;
+	tableF[0x15] = &XoChip::OP_Fx15;
+	tableF[0x18] = &XoChip::OP_Fx18;
+	tableF[0x1E] = &XoChip::OP_Fx1E;
+	tableF[0x29] = &XoChip::OP_Fx29;
+	tableF[0x30] = &XoChip::OP_Fx30;
+	tableF[0x33] = &XoChip::OP_Fx33;
+	tableF[0x3A] = &XoChip::OP_Fx3A;
+	tableF[0x75] = &XoChip::OP_Fx75;
+	tableF[0x85] = &XoChip::OP_Fx85;
+
+	// Quirk-dependent handlers (Bnnn, Dxyn, 8xy1-3, 8xy6, 8xyE, Fx55, Fx65), specialized per
+	// profile as in Chip8: the choice is made once here, never while executing
+	switch (quirkProfile)
+	{
+		case Chip8QuirkProfile::Default:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Default)>();
+			break;
+		case Chip8QuirkProfile::Cosmac:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Cosmac)>();
+			break;
+		case Chip8QuirkProfile::SuperChip:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::SuperChip)>();
+			break;
+		case Chip8QuirkProfile::XoChip:
+		default:
+			InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::XoChip)>();
+			break;
+	}
+}
+
+void XoChip::Table0()
+{
+	((*this).*(table0[opcode & 0x00FFu]))();
+}
+
+void XoChip::Table5()
+{
+	((*this).*(table5[opcode & 0x000Fu]))();
+}
+
+void XoChip::Table8()
+{
+	((*this).*(table8[opcode & 0x000Fu]))();
+}
+
+void XoChip::TableE()
+{
+	((*this).*(tableE[opcode & 0x000Fu]))();
+}
+
+void XoChip::TableF()
+{
+	((*this).*(tableF[opcode & 0x00FFu]))();
+}
+
+void XoChip::ClearPlanes(uint8_t mask)
+{
+	for (unsigned int plane = 0; plane < XO_PLANE_COUNT; ++plane)
+	{
+		if (mask & (1u << plane))
+			planes[plane].fill(0);
+	}
+	dirtyRows = ~0ULL;
+}
+
+void XoChip::ScrollRows(int rows)
+{
+	const int height = static_cast<int>(get_height());
+	rows = std::clamp(rows, -height, height);
+
+	for (unsigned int plane = 0; plane < XO_PLANE_COUNT; ++plane)
+	{
+		if (!(planeMask & (1u << plane)))
+			continue;
+
+		// Whole rows move at once, the rows uncovered are cleared
+		const std::ptrdiff_t shift = static_cast<std::ptrdiff_t>(std::abs(rows)) * XO_ROW_WORDS;
+		uint64_t* first = planes[plane].data();
+		uint64_t* last = first + height * XO_ROW_WORDS;
+		if (rows > 0)
+		{
+			std::copy_backward(first, last - shift, last);
+			std::fill(first, first + shift, 0);
+		}
+		else if (rows < 0)
+		{
+			std::copy(first + shift, last, first);
+			std::fill(last - shift, last, 0);
+		}
+	}
+
+	dirtyRows = ~0ULL;
+}
@@ -0,0 +1,525 @@
+#include "XoChip.h"
+
+#include <cstdlib>
+
+// Ors a left-aligned sprite row into a packed row at column `x`
+static inline void PlaceSprite(uint64_t sprite, unsigned int x, uint64_t (&row)[XO_ROW_WORDS])
+{
+	if (x < 64)
+	{
+		row[0] |= sprite >> x;
+		if (x)
+			row[1] |= sprite << (64u - x);
+	}
+	else
+		row[1] |= sprite >> (x - 64u);
+}
+
+void XoChip::OP_00Cn()
+{
+	ScrollRows(opcode & 0x000Fu);
+}
+
+void XoChip::OP_00Dn()
+{
+	ScrollRows(-static_cast<int>(opcode & 0x000Fu));
+}
+
+void XoChip::OP_00E0()
+{
+	ClearPlanes(planeMask);
+}
+
+void XoChip::OP_00EE()
+{
+	--sp;
+	pc = stack[sp];
+}
+
+void XoChip::OP_00FB()
+{
+	for (unsigned int plane = 0; plane < XO_PLANE_COUNT; ++plane)
+	{
+		if (!(planeMask & (1u << plane)))
+			continue;
+
+		// The low nibble of the left word carries over into the right word
+		for (unsigned int y = 0; y < get_height(); ++y)
+		{
+			uint64_t* row = &planes[plane][y * XO_ROW_WORDS];
+			if (hires)
+				row[1] = (row[1] >> 4u) | (row[0] << 60u);
+			row[0] >>= 4u;
+		}
+	}
+	dirtyRows = ~0ULL;
+}
+
+void XoChip::OP_00FC()
+{
+	for (unsigned int plane = 0; plane < XO_PLANE_COUNT; ++plane)
+	{
+		if (!(planeMask & (1u << plane)))
+			continue;
+
+		// The high nibble of the right word carries over into the left word
+		for (unsigned int y = 0; y < get_height(); ++y)
+		{
+			uint64_t* row = &planes[plane][y * XO_ROW_WORDS];
+			if (hires)
+			{
+				row[0] = (row[0] << 4u) | (row[1] >> 60u);
+				row[1] <<= 4u;
+			}
+			else
+				row[0] <<= 4u;
+		}
+	}
+	dirtyRows = ~0ULL;
+}
+
+void XoChip::OP_00FD()
+{
+	// Stay on the instruction, the program is over
+	exited = true;
+	pc -= 2;
+}
+
+void XoChip::OP_00FE()
+{
+	hires = false;
+	ClearPlanes(0x3);
+}
+
+void XoChip::OP_00FF()
+{
+	hires = true;
+	ClearPlanes(0x3);
+}
+
+void XoChip::OP_1nnn()
+{
+	pc = opcode & 0x0FFFu;
+}
+
+void XoChip::OP_2nnn()
+{
+	stack[sp] = pc;
+	++sp;
+	pc = opcode & 0x0FFFu;
+}
+
+void XoChip::OP_3xkk()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	if (registers[Vx] == (opcode & 0x00FFu))
+		SkipNext();
+}
+
+void XoChip::OP_4xkk()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	if (registers[Vx] != (opcode & 0x00FFu))
+		SkipNext();
+}
+
+void XoChip::OP_5xy0()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+
+	if (registers[Vx] == registers[Vy])
+		SkipNext();
+}
+
+void XoChip::OP_5xy2()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	int step = Vx <= Vy ? 1 : -1;
+
+	for (int i = 0, reg = Vx; i <= std::abs(Vy - Vx); ++i, reg += step)
+		memory[static_cast<uint16_t>(index + i)] = registers[reg];
+}
+
+void XoChip::OP_5xy3()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	int step = Vx <= Vy ? 1 : -1;
+
+	for (int i = 0, reg = Vx; i <= std::abs(Vy - Vx); ++i, reg += step)
+		registers[reg] = memory[static_cast<uint16_t>(index + i)];
+}
+
+void XoChip::OP_6xkk()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	registers[Vx] = opcode & 0x00FFu;
+}
+
+void XoChip::OP_7xkk()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	registers[Vx] += opcode & 0x00FFu;
+}
+
+void XoChip::OP_8xy0()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	registers[Vx] = registers[Vy];
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_8xy1()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	registers[Vx] |= registers[Vy];
+
+	if constexpr (Quirks.logicResetsVF)
+		registers[0xF] = 0;
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_8xy2()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	registers[Vx] &= registers[Vy];
+
+	if constexpr (Quirks.logicResetsVF)
+		registers[0xF] = 0;
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_8xy3()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	registers[Vx] ^= registers[Vy];
+
+	if constexpr (Quirks.logicResetsVF)
+		registers[0xF] = 0;
+}
+
+void XoChip::OP_8xy4()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	uint16_t sum = registers[Vx] + registers[Vy];
+
+	// The flag is written last, so VF used as Vx still ends up holding the flag
+	registers[Vx] = sum & 0xFFu;
+	registers[0xF] = sum > 0xFFu ? 1 : 0;
+}
+
+void XoChip::OP_8xy5()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	uint8_t flag = registers[Vx] >= registers[Vy] ? 1 : 0;
+
+	registers[Vx] -= registers[Vy];
+	registers[0xF] = flag;
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_8xy6()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	uint8_t source = Quirks.shiftReadsVy ? registers[Vy] : registers[Vx];
+	uint8_t flag = source & 0x1u;
+
+	registers[Vx] = source >> 1u;
+	registers[0xF] = flag;
+}
+
+void XoChip::OP_8xy7()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	uint8_t flag = registers[Vy] >= registers[Vx] ? 1 : 0;
+
+	registers[Vx] = registers[Vy] - registers[Vx];
+	registers[0xF] = flag;
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_8xyE()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	uint8_t source = Quirks.shiftReadsVy ? registers[Vy] : registers[Vx];
+	uint8_t flag = (source & 0x80u) >> 7u;
+
+	registers[Vx] = source << 1u;
+	registers[0xF] = flag;
+}
+
+void XoChip::OP_9xy0()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+
+	if (registers[Vx] != registers[Vy])
+		SkipNext();
+}
+
+void XoChip::OP_Annn()
+{
+	index = opcode & 0x0FFFu;
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_Bnnn()
+{
+	// SUPER-CHIP reads the offset from the register named by the high nibble of the address
+	const uint8_t Vx = Quirks.jumpAddsVx ? (opcode & 0x0F00u) >> 8u : 0;
+	pc = (opcode & 0x0FFFu) + registers[Vx];
+}
+
+void XoChip::OP_Cxkk()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	registers[Vx] = rng.NextByte() & (opcode & 0x00FFu);
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_Dxyn()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+	unsigned int height = opcode & 0x000Fu;
+
+	// n = 0 draws a 16x16 sprite, two bytes per row
+	const unsigned int width = height == 0 ? 16 : 8;
+	if (height == 0)
+		height = 16;
+
+	// Both screen sizes are powers of two, the wraparound is a mask rather than a division
+	const unsigned int screenWidth = get_width();
+	const unsigned int screenHeight = get_height();
+	const unsigned int xPos = registers[Vx] & (screenWidth - 1);
+	const unsigned int yPos = registers[Vy] & (screenHeight - 1);
+
+	uint64_t collision = 0;
+	uint16_t address = index;
+
+	// Each selected plane reads its own sprite, stored right after the previous plane's
+	for (unsigned int plane = 0; plane < XO_PLANE_COUNT; ++plane)
+	{
+		if (!(planeMask & (1u << plane)))
+			continue;
+
+		for (unsigned int row = 0; row < height; ++row)
+		{
+			uint64_t bits = memory[address];
+			if (width == 16)
+				bits = (bits << 8u) | memory[static_cast<uint16_t>(address + 1)];
+			address += width / 8;
+
+			// Rows past the bottom edge wrap around to row 0, or are clipped
+			unsigned int y = yPos + row;
+			if constexpr (!Quirks.spritesWrap)
+			{
+				if (y >= screenHeight)
+					continue;
+			}
+			y &= screenHeight - 1;
+
+			// Left-align the sprite row and split it over the row words, the pixels past the
+			// right edge fall off the row (the lo-res right word) or wrap around to column 0
+			uint64_t sprite = bits << (64u - width);
+			uint64_t mask[XO_ROW_WORDS] = {};
+			PlaceSprite(sprite, xPos, mask);
+			if constexpr (Quirks.spritesWrap)
+			{
+				if (xPos + width > screenWidth)
+					PlaceSprite(sprite << (screenWidth - xPos), 0, mask);
+			}
+			if (!hires)
+				mask[1] = 0;
+
+			uint64_t* line = &planes[plane][y * XO_ROW_WORDS];
+
+			// Pixels on in both the sprite and the screen collide, then XOR toggles them
+			collision |= (line[0] & mask[0]) | (line[1] & mask[1]);
+			line[0] ^= mask[0];
+			line[1] ^= mask[1];
+
+			if (mask[0] | mask[1])
+				dirtyRows |= 1ULL << y;
+		}
+	}
+
+	registers[0xF] = collision ? 1 : 0;
+}
+
+void XoChip::OP_Ex9E()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	if (keypad[registers[Vx] & 0x0Fu])
+		SkipNext();
+}
+
+void XoChip::OP_ExA1()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	if (!keypad[registers[Vx] & 0x0Fu])
+		SkipNext();
+}
+
+void XoChip::OP_F000()
+{
+	index = Fetch(pc);
+	pc += 2;
+}
+
+void XoChip::OP_Fn01()
+{
+	planeMask = (opcode & 0x0F00u) >> 8u & 0x3u;
+}
+
+void XoChip::OP_F002()
+{
+	for (unsigned int i = 0; i < audioPattern.size(); ++i)
+		audioPattern[i] = memory[static_cast<uint16_t>(index + i)];
+}
+
+void XoChip::OP_Fx07()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	registers[Vx] = delayTimer;
+}
+
+void XoChip::OP_Fx0A()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	for (uint8_t i = 0; i < NUM_KEYS; ++i)
+	{
+		if (keypad[i])
+		{
+			registers[Vx] = i;
+			return;
+		}
+	}
+
+	// No key was pressed, so we decrement the program counter to wait
+	pc -= 2;
+}
+
+void XoChip::OP_Fx15()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	delayTimer = registers[Vx];
+}
+
+void XoChip::OP_Fx18()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	soundTimer = registers[Vx];
+}
+
+void XoChip::OP_Fx1E()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	index += registers[Vx];
+}
+
+void XoChip::OP_Fx29()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	index = FONTSET_START_ADDRESS + (registers[Vx] & 0x0Fu) * FONT_SIZE;
+}
+
+void XoChip::OP_Fx30()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	index = BIG_FONTSET_START_ADDRESS + (registers[Vx] & 0x0Fu) * BIG_FONT_SIZE;
+}
+
+void XoChip::OP_Fx33()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	uint8_t value = registers[Vx];
+
+	memory[static_cast<uint16_t>(index + 2)] = value % 10;
+	memory[static_cast<uint16_t>(index + 1)] = value / 10 % 10;
+	memory[index] = value / 100;
+}
+
+void XoChip::OP_Fx3A()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+	pitch = registers[Vx];
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_Fx55()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	for (uint8_t i = 0; i <= Vx; ++i)
+		memory[static_cast<uint16_t>(index + i)] = registers[i];
+
+	if constexpr (Quirks.memoryAdvancesIndex)
+		index += Vx + 1;
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::OP_Fx65()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	for (uint8_t i = 0; i <= Vx; ++i)
+		registers[i] = memory[static_cast<uint16_t>(index + i)];
+
+	if constexpr (Quirks.memoryAdvancesIndex)
+		index += Vx + 1;
+}
+
+void XoChip::OP_Fx75()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	for (uint8_t i = 0; i <= Vx; ++i)
+		flags[i] = registers[i];
+}
+
+void XoChip::OP_Fx85()
+{
+	uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+
+	for (uint8_t i = 0; i <= Vx; ++i)
+		registers[i] = flags[i];
+}
+
+template<Chip8Quirks Quirks>
+void XoChip::InitializeQuirkTables()
+{
+	table[0xB] = &XoChip::OP_Bnnn<Quirks>;
+	table[0xD] = &XoChip::OP_Dxyn<Quirks>;
+
+	table8[0x1] = &XoChip::OP_8xy1<Quirks>;
+	table8[0x2] = &XoChip::OP_8xy2<Quirks>;
+	table8[0x3] = &XoChip::OP_8xy3<Quirks>;
+	table8[0x6] = &XoChip::OP_8xy6<Quirks>;
+	table8[0xE] = &XoChip::OP_8xyE<Quirks>;
+
+	tableF[0x55] = &XoChip::OP_Fx55<Quirks>;
+	tableF[0x65] = &XoChip::OP_Fx65<Quirks>;
+}
+
+// One specialization of the quirk-dependent handlers per profile
+template void XoChip::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Default)>();
+template void XoChip::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::Cosmac)>();
+template void XoChip::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::SuperChip)>();
+template void XoChip::InitializeQuirkTables<QuirksOf(Chip8QuirkProfile::XoChip)>();
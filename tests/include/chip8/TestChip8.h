@@ -58,7 +58,7 @@ protected:
         return chip8.keypad;  // Return a reference to the keypad array
     }
 
-    inline std::array<uint32_t, VIDEO_HEIGHT * VIDEO_WIDTH>& get_video() {
+    inline std::array<uint64_t, VIDEO_HEIGHT>& get_video() {
         return chip8.video;  // Return a reference to the video array
     }
     
@@ -66,5 +66,22 @@ protected:
         return chip8.opcode;
     }
 
+    // Compares the architectural state of two CPUs (used to check engines against each other)
+    inline ::testing::AssertionResult SameState(const Chip8& a, const Chip8& b) {
+        if (a.registers != b.registers)
+            return ::testing::AssertionFailure() << "registers differ";
+        if (a.memory != b.memory)
+            return ::testing::AssertionFailure() << "memory differs";
+        if (a.index != b.index || a.pc != b.pc || a.sp != b.sp)
+            return ::testing::AssertionFailure() << "index/pc/sp differ";
+        if (a.stack != b.stack)
+            return ::testing::AssertionFailure() << "stack differs";
+        if (a.delayTimer != b.delayTimer || a.soundTimer != b.soundTimer)
+            return ::testing::AssertionFailure() << "timers differ";
+        if (a.video != b.video)
+            return ::testing::AssertionFailure() << "video differs";
+        return ::testing::AssertionSuccess();
+    }
+
 
 };
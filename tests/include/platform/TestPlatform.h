@@ -6,7 +6,7 @@ class TestPlatform : public  ::testing::Test
 protected:
     Platform platform = Platform("Test", 640, 320, 64, 32);
     uint8_t keys[NUM_KEYS] = {0};
-    SDL_Event event;
+    SDL_Event event{};
 
     void SetUp() override {}
 
@@ -0,0 +1,126 @@
+#include "BatchRunner.h"
+#include "ThreadPool.h"
+#include "XoChip.h"
+#include "Tests_common.h"
+
+#include <atomic>
+#include <filesystem>
+
+// 0x200: LD V0, K ; 0x202: LD V1, 0x20 ; 0x204: ADD V1, V0 ; 0x206: JP 0x206
+static const std::vector<uint8_t> waitKeyRom = {0xF0, 0x0A, 0x61, 0x20, 0x81, 0x04, 0x12, 0x06};
+
+// ====== Testing the work-stealing pool ======
+
+TEST(TestThreadPool, RunsEveryTask) {
+    ThreadPool pool(4);
+    std::atomic<int> counter{0};
+
+    for (int i = 0; i < 1000; ++i)
+        pool.Submit([&counter] { counter.fetch_add(1, std::memory_order_relaxed); });
+    pool.Wait();
+
+    ASSERT_EQ(counter.load(), 1000) << "Some tasks were lost";
+    ASSERT_EQ(pool.get_size(), 4u);
+}
+
+// ====== Testing the batch runner ======
+
+TEST(TestBatchRunner, ScriptedInput) {
+    BatchJob job;
+    job.name = "wait-key";
+    job.rom = RomImage::Copy(waitKeyRom);
+    job.cycles = 1000;
+    job.inputs = {{50, 0x7, true}};
+
+    BatchResult result = BatchRunner::RunJob(job);
+    ASSERT_TRUE(result.error.empty()) << result.error;
+    ASSERT_TRUE(result.halted) << "The key press did not release the ROM";
+    ASSERT_EQ(result.cycles, 60u) << "The run did not stop at the halt check following the key press";
+
+    // Same end state as driving the CPU by hand
+    Chip8 chip8;
+    chip8.LoadROM(waitKeyRom);
+    chip8.Run(50);
+    chip8.SetKey(0x7, true);
+    chip8.Run(10);
+    for (int i = 0; i < 6; ++i)
+        chip8.TickTimers();
+    ASSERT_EQ(result.stateHash, chip8.StateHash());
+
+    // Without the key the ROM never leaves Fx0A
+    job.inputs.clear();
+    BatchResult idle = BatchRunner::RunJob(job);
+    ASSERT_FALSE(idle.halted);
+    ASSERT_EQ(idle.cycles, 1000u);
+    ASSERT_EQ(idle.frames, 100u);
+    ASSERT_NE(idle.stateHash, result.stateHash);
+}
+
+TEST(TestBatchRunner, DeterministicAcrossThreadsAndEngines) {
+    auto rom = RomImage::Copy(waitKeyRom);
+    std::vector<BatchJob> jobs;
+    for (Chip8Engine engine : {Chip8Engine::Table, Chip8Engine::Predecoded, Chip8Engine::Block, Chip8Engine::Jit})
+        for (int i = 0; i < 8; ++i)
+            jobs.push_back(BatchJob{"job", rom, 500, {{static_cast<uint64_t>(10 * i), 0x3, true}}, 0, engine});
+
+    BatchRunner runner(4);
+    std::vector<BatchResult> results = runner.Run(jobs);
+    ASSERT_EQ(results.size(), jobs.size());
+
+    // Results come back in job order and do not depend on the worker nor the engine
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        BatchResult expected = BatchRunner::RunJob(jobs[i % 8]);
+        ASSERT_EQ(results[i].stateHash, expected.stateHash) << "job " << i;
+        ASSERT_EQ(results[i].cycles, expected.cycles) << "job " << i;
+    }
+}
+
+TEST(TestBatchRunner, ExtendedProfilesRunOnXoChip) {
+    BatchJob job;
+    job.rom = RomImage::Copy(waitKeyRom);
+    job.cycles = 1000;
+    job.inputs = {{50, 0x7, true}};
+
+    // schip and xochip jobs get the extended core, with the same scheduler and scripted input
+    for (Chip8QuirkProfile profile : {Chip8QuirkProfile::SuperChip, Chip8QuirkProfile::XoChip})
+    {
+        job.quirks = profile;
+        BatchResult result = BatchRunner::RunJob(job);
+        ASSERT_TRUE(result.error.empty()) << result.error;
+        ASSERT_TRUE(result.halted);
+        ASSERT_EQ(result.cycles, 60u);
+
+        XoChip xo(profile);
+        xo.LoadROM(waitKeyRom);
+        xo.Run(50);
+        xo.SetKey(0x7, true);
+        xo.Run(10);
+        for (int i = 0; i < 6; ++i)
+            xo.TickTimers();
+        ASSERT_EQ(result.stateHash, xo.StateHash()) << QuirkProfileName(profile);
+    }
+}
+
+TEST(TestBatchRunner, LoadInputScript) {
+    std::string path = "./temp_inputs.txt";
+    {
+        std::ofstream out(path);
+        out << "# cycle key action\n"
+            << "120 A up\n"
+            << "\n"
+            << "10 a down\n";
+    }
+
+    std::vector<InputEvent> events = BatchRunner::LoadInputScript(path);
+    std::filesystem::remove(path);
+
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].cycle, 10u);
+    EXPECT_EQ(events[0].key, 0xA);
+    EXPECT_TRUE(events[0].pressed);
+    EXPECT_EQ(events[1].cycle, 120u);
+    EXPECT_FALSE(events[1].pressed);
+
+    ASSERT_THROW(BatchRunner::LoadInputScript("./missing_inputs.txt"), std::runtime_error);
+}
@@ -1,5 +1,7 @@
 // #include "chip8/TestChip8.h"
 #include <TestChip8.h>
+#include "Movie.h"
+#include "Scheduler.h"
 
 // ====== Testing base class functions ======
 
@@ -9,9 +11,15 @@ TEST_F(TestChip8, ConstructorDestructor) {
 }
 
 TEST_F(TestChip8, GetVideo) {
-    auto testData = generateRandomData<uint32_t, VIDEO_WIDTH * VIDEO_HEIGHT>();
-    std::copy(testData.begin(), testData.end(), get_video().begin());  // Fill the video array
-    ASSERT_EQ(chip8.get_video(), testData) << "The video geter is broken\n";
+    auto testData = generateRandomData<uint64_t, VIDEO_HEIGHT>();
+    std::copy(testData.begin(), testData.end(), get_video().begin());  // Fill the packed video array
+
+    std::array<uint32_t, VIDEO_WIDTH * VIDEO_HEIGHT> expected;
+    for (unsigned int i = 0; i < expected.size(); ++i)
+        expected[i] = (testData[i / VIDEO_WIDTH] >> (63 - i % VIDEO_WIDTH)) & 1 ? 0xFFFFFFFF : 0;
+
+    ASSERT_EQ(chip8.get_video(), expected) << "The video geter is broken\n";
+    ASSERT_EQ(chip8.get_framebuffer(), testData) << "The framebuffer geter is broken\n";
 }
 
 TEST_F(TestChip8, GetKeypad) {
@@ -20,6 +28,29 @@ TEST_F(TestChip8, GetKeypad) {
     ASSERT_EQ(chip8.get_keypad(), testData) << "The keypad geter is broken\n";
 }
 
+TEST_F(TestChip8, ZeroCopyViews) {
+    // Views and references alias the CPU state instead of copying it
+    ASSERT_EQ(chip8.get_keypad().data(), get_keypad().data()) << "get_keypad() returned a copy";
+    ASSERT_EQ(chip8.get_memory().data(), get_memory().data()) << "get_memory() returned a copy";
+    ASSERT_EQ(chip8.get_registers().data(), get_registers().data()) << "get_registers() returned a copy";
+    ASSERT_EQ(chip8.get_framebuffer().data(), get_video().data()) << "get_framebuffer() returned a copy";
+
+    get_registers()[3] = 0x42;
+    ASSERT_EQ(chip8.get_registers()[3], 0x42);
+}
+
+TEST_F(TestChip8, SetKey) {
+    chip8.SetKey(0xA, true);
+    ASSERT_EQ(chip8.get_keypad()[0xA], 1) << "SetKey didn't press the key";
+    chip8.SetKey(0xA, false);
+    ASSERT_EQ(chip8.get_keypad()[0xA], 0) << "SetKey didn't release the key";
+    chip8.SetKey(NUM_KEYS, true);   // out of range, ignored
+
+    // Input backends write through the mutable view
+    chip8.get_keypad_input()[5] = 1;
+    ASSERT_EQ(chip8.get_keypad()[5], 1) << "The keypad input view doesn't reach the CPU";
+}
+
 // ====== Testing loading ROM ======
 
 TEST_F(TestChip8, EmptyFilenameError) {
@@ -111,10 +142,539 @@ TEST_F(TestChip8, CycleTimers) {
     get_delayTimer() = testData.size()/2;
     get_soundTimer() = testData.size()/2;
 
+    // Instructions no longer drive the timers, only the 60 Hz tick does
     for (int i=1; i<testData.size()/2; i++){
         chip8.Cycle();
 
+        ASSERT_EQ(get_delayTimer(), testData.size()/2) << "Delay timer was decremented by an instruction.";
+        ASSERT_EQ(get_soundTimer(), testData.size()/2) << "Sound timer was decremented by an instruction.";
+    }
+
+    for (int i=1; i<testData.size()/2; i++){
+        chip8.TickTimers();
+
         ASSERT_EQ(get_delayTimer(), testData.size()/2-i) << "Delay timer was not decremented.";
         ASSERT_EQ(get_soundTimer(), testData.size()/2-i) << "Sound timer was not decremented.";
     }
-}
\ No newline at end of file
+}
+
+TEST_F(TestChip8, HaltOnJumpToSelf) {
+    tempFilePath = "./temp_file.ch8";
+    // 0x200: LD V0, 0x05 ; 0x202: JP 0x202
+    std::array<uint8_t, 4> testData = {0x60, 0x05, 0x12, 0x02};
+    writeFile(tempFilePath, testData);
+    chip8.LoadROM(tempFilePath);
+
+    chip8.Cycle();
+    ASSERT_FALSE(chip8.is_halted()) << "A plain load was considered a halt.\n";
+
+    chip8.Cycle();
+    ASSERT_TRUE(chip8.is_halted()) << "A jump to itself was not considered a halt.\n";
+    ASSERT_EQ(chip8.get_pc(), 0x202) << "The halted PC is not on the jump instruction.\n";
+}
+
+// ====== Testing execution engines ======
+
+// Loop that rewrites one of its own instructions with Fx55 on the first pass
+const std::array<uint8_t, 16> selfModifyingRom = {
+    0xA2, 0x0A,     // 0x200: LD I, 0x20A
+    0x60, 0x63,     // 0x202: LD V0, 0x63
+    0x61, 0x42,     // 0x204: LD V1, 0x42
+    0x74, 0x01,     // 0x206: ADD V4, 0x01
+    0x65, 0x00,     // 0x208: LD V5, 0x00
+    0x62, 0x99,     // 0x20A: LD V2, 0x99 -> becomes LD V3, 0x42
+    0xF1, 0x55,     // 0x20C: LD [I], V1
+    0x12, 0x06      // 0x20E: JP 0x206
+};
+
+TEST_F(TestChip8, PredecodedMatchesTable) {
+    tempFilePath = "./temp_file.ch8";
+    writeFile(tempFilePath, selfModifyingRom);
+
+    Chip8 predecoded(Chip8Engine::Predecoded);
+    chip8.LoadROM(tempFilePath);
+    predecoded.LoadROM(tempFilePath);
+
+    for (int i = 0; i < 13; ++i) {
+        chip8.Cycle();
+        predecoded.Cycle();
+        ASSERT_TRUE(SameState(chip8, predecoded)) << "Engines diverged at cycle " << i;
+    }
+
+    EXPECT_EQ(get_registers()[2], 0x99) << "Original instruction was not executed";
+    EXPECT_EQ(get_registers()[3], 0x42) << "Rewritten instruction was not executed";
+}
+
+TEST_F(TestChip8, PredecodedRunMatchesCycle) {
+    tempFilePath = "./temp_file.ch8";
+    writeFile(tempFilePath, selfModifyingRom);
+
+    Chip8 predecoded(Chip8Engine::Predecoded);
+    chip8.LoadROM(tempFilePath);
+    predecoded.LoadROM(tempFilePath);
+
+    for (int i = 0; i < 1000; ++i)
+        chip8.Cycle();
+    predecoded.Run(1000);
+
+    ASSERT_TRUE(SameState(chip8, predecoded));
+}
+
+TEST_F(TestChip8, BlockMatchesTable) {
+    tempFilePath = "./temp_file.ch8";
+    writeFile(tempFilePath, selfModifyingRom);
+
+    Chip8 block(Chip8Engine::Block);
+    chip8.LoadROM(tempFilePath);
+    block.LoadROM(tempFilePath);
+
+    // Uneven budgets end inside blocks as well as on their boundaries
+    for (int budget : {1, 2, 3, 5, 7, 11, 13, 64, 1000}) {
+        for (int i = 0; i < budget; ++i)
+            chip8.Cycle();
+        block.Run(budget);
+        ASSERT_TRUE(SameState(chip8, block)) << "Engines diverged after a budget of " << budget;
+    }
+
+    EXPECT_EQ(get_registers()[3], 0x42) << "Rewritten instruction was not executed";
+}
+
+// Builds a loop of random instructions, mostly ones the native engines translate (VF operands included)
+std::array<uint8_t, 256> randomAluRom(unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::array<uint16_t, 10> aluOps = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE, 0x8};
+    std::array<uint8_t, 256> rom{};
+
+    for (size_t i = 0; i + 4 < rom.size(); i += 2) {
+        uint16_t x = gen() % 16, y = gen() % 16, kk = gen() % 256;
+        uint16_t instruction = 0;
+        switch (gen() % 10) {
+            case 0: instruction = 0x6000 | (x << 8) | kk; break;
+            case 1: instruction = 0x7000 | (x << 8) | kk; break;
+            case 2: instruction = 0x3000 | (x << 8) | kk; break;
+            case 3: instruction = 0x9000 | (x << 8) | (y << 4); break;
+            case 4: instruction = 0xA300 | kk; break;
+            case 5: instruction = 0xF033 | (x << 8); break;
+            case 6: instruction = 0xF015 | (x << 8); break;
+            case 7: instruction = 0xF007 | (x << 8); break;
+            default: instruction = 0x8000 | (x << 8) | (y << 4) | aluOps[gen() % aluOps.size()]; break;
+        }
+        rom[i] = instruction >> 8;
+        rom[i + 1] = instruction & 0xFF;
+    }
+
+    // Loop back to the start, twice in case the last random instruction skips
+    rom[rom.size() - 4] = 0x12;
+    rom[rom.size() - 3] = 0x00;
+    rom[rom.size() - 2] = 0x12;
+    rom[rom.size() - 1] = 0x00;
+    return rom;
+}
+
+TEST_F(TestChip8, JitMatchesTable) {
+    tempFilePath = "./temp_file.ch8";
+    writeFile(tempFilePath, selfModifyingRom);
+
+    Chip8 jit(Chip8Engine::Jit);
+    chip8.LoadROM(tempFilePath);
+    jit.LoadROM(tempFilePath);
+
+    for (int budget : {1, 2, 3, 5, 7, 11, 13, 64, 1000}) {
+        for (int i = 0; i < budget; ++i)
+            chip8.Cycle();
+        jit.Run(budget);
+        ASSERT_TRUE(SameState(chip8, jit)) << "Engines diverged after a budget of " << budget;
+    }
+
+    EXPECT_EQ(get_registers()[3], 0x42) << "Rewritten instruction was not executed";
+}
+
+TEST_F(TestChip8, JitMatchesTableOnRandomPrograms) {
+    tempFilePath = "./temp_file.ch8";
+
+    for (unsigned int seed = 0; seed < 32; ++seed) {
+        writeFile(tempFilePath, randomAluRom(seed));
+
+        Chip8 table;
+        Chip8 jit(Chip8Engine::Jit);
+        table.LoadROM(tempFilePath);
+        jit.LoadROM(tempFilePath);
+
+        for (int step = 0; step < 20; ++step) {
+            table.Run(97);
+            jit.Run(97);
+            ASSERT_TRUE(SameState(table, jit)) << "Engines diverged with seed " << seed << " at step " << step;
+        }
+    }
+}
+
+// ====== Testing dirty display tracking ======
+
+TEST_F(TestChip8, DirtyRows) {
+    ASSERT_TRUE(chip8.is_dirty()) << "A reset display was not marked for presentation";
+    chip8.ClearDirty();
+    ASSERT_FALSE(chip8.is_dirty());
+    ASSERT_EQ(chip8.get_dirty_rows(), 0ull);
+
+    // Font sprite "0" at (0, 4) touches rows 4 to 8
+    get_index() = FONTSET_START_ADDRESS;
+    get_registers()[0] = 0;
+    get_registers()[1] = 4;
+    get_opcode() = 0xD015;
+    chip8.OP_Dxyn();
+
+    ASSERT_TRUE(chip8.is_dirty()) << "OP_Dxyn didn't mark the display dirty";
+    ASSERT_EQ(chip8.get_dirty_rows(), 0x1F0ull) << "OP_Dxyn marked the wrong rows";
+
+    chip8.ClearDirty();
+    chip8.OP_00E0();
+    ASSERT_EQ(chip8.get_dirty_rows(), ALL_ROWS_DIRTY) << "OP_00E0 didn't mark every row";
+}
+
+// ====== Testing the frame scheduler ======
+
+TEST_F(TestChip8, SchedulerFixedRatio) {
+    get_delayTimer() = 10;
+    Scheduler scheduler(chip8, SchedulerMode::FixedRatio, 4);
+
+    // The tick lands on the 4th instruction whatever the batch sizes
+    ASSERT_EQ(scheduler.RunCycles(3), 0u);
+    ASSERT_EQ(get_delayTimer(), 10) << "Timer ticked inside a frame";
+    ASSERT_EQ(scheduler.RunCycles(1), 1u);
+    ASSERT_EQ(get_delayTimer(), 9) << "Timer did not tick at the end of the frame";
+    ASSERT_EQ(scheduler.RunCycles(9), 2u);
+    ASSERT_EQ(get_delayTimer(), 7);
+    ASSERT_EQ(get_pc(), START_ADDRESS + 2 * 13);
+
+    // One Pump() is one frame, the wall clock is ignored
+    ASSERT_EQ(scheduler.Pump(Scheduler::Clock::time_point{}), 1u);
+    ASSERT_EQ(get_delayTimer(), 6);
+    ASSERT_EQ(get_pc(), START_ADDRESS + 2 * 16);
+    ASSERT_EQ(scheduler.get_frame_count(), 4u);
+}
+
+TEST_F(TestChip8, SchedulerRealTime) {
+    get_delayTimer() = 100;
+    auto epoch = Scheduler::Clock::now();
+    Scheduler scheduler(chip8, SchedulerMode::RealTime, 5, epoch);
+
+    ASSERT_EQ(scheduler.Pump(epoch), 0u) << "A frame ran before its deadline";
+    ASSERT_EQ(get_pc(), START_ADDRESS);
+
+    // 2.5 periods later two frames are due
+    ASSERT_EQ(scheduler.Pump(epoch + Scheduler::FRAME_PERIOD * 5 / 2), 2u);
+    ASSERT_EQ(get_pc(), START_ADDRESS + 2 * 10);
+    ASSERT_EQ(get_delayTimer(), 98);
+    ASSERT_EQ(scheduler.get_next_deadline(), epoch + Scheduler::FRAME_PERIOD * 3);
+
+    // A long stall only catches up a few frames, the deadlines stay aligned on the epoch
+    ASSERT_EQ(scheduler.Pump(epoch + Scheduler::FRAME_PERIOD * 100), MAX_CATCHUP_FRAMES);
+    ASSERT_EQ(get_delayTimer(), 98 - MAX_CATCHUP_FRAMES);
+    ASSERT_EQ(scheduler.get_next_deadline(), epoch + Scheduler::FRAME_PERIOD * 101);
+}
+
+TEST_F(TestChip8, SchedulerUncapped) {
+    get_delayTimer() = 100;
+    auto epoch = Scheduler::Clock::now();
+    Scheduler scheduler(chip8, SchedulerMode::Uncapped, 8, epoch);
+
+    // The CPU runs a batch on every call, the timers wait for the wall clock
+    ASSERT_EQ(scheduler.Pump(epoch), 0u);
+    ASSERT_EQ(scheduler.Pump(epoch), 0u);
+    ASSERT_EQ(get_pc(), START_ADDRESS + 2 * 16);
+    ASSERT_EQ(get_delayTimer(), 100);
+
+    ASSERT_EQ(scheduler.Pump(epoch + Scheduler::FRAME_PERIOD * 3), 3u);
+    ASSERT_EQ(get_delayTimer(), 97);
+}
+
+TEST_F(TestChip8, SchedulerWaitForNextFrame) {
+    auto epoch = Scheduler::Clock::now();
+    Scheduler scheduler(chip8, SchedulerMode::RealTime, 5, epoch);
+
+    // Waking up exactly makes the next frame due, and only that one
+    scheduler.WaitForNextFrame();
+    auto now = Scheduler::Clock::now();
+    ASSERT_GE(now, epoch + Scheduler::FRAME_PERIOD) << "Woke up before the deadline";
+    ASSERT_GE(scheduler.Pump(now), 1u);
+}
+
+TEST_F(TestChip8, SchedulerUncappedSleepsWhenIdle) {
+    chip8.LoadROM(std::vector<uint8_t>{0x12, 0x00});
+    auto epoch = Scheduler::Clock::now();
+    Scheduler scheduler(chip8, SchedulerMode::Uncapped, 8, epoch);
+    scheduler.Pump(epoch);
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::Halted);
+
+    // A queued key change ends the wait at once
+    InputQueue input;
+    scheduler.SetInput(&input);
+    input.TryPush(KeyEvent{epoch, 0x1, true});
+    scheduler.WaitForNextFrame();
+    ASSERT_LT(Scheduler::Clock::now(), epoch + Scheduler::FRAME_PERIOD) << "Slept over a key change";
+
+    // Otherwise the halted CPU sleeps up to the next timer tick
+    KeyEvent event;
+    input.TryPop(event);
+    scheduler.WaitForNextFrame();
+    ASSERT_GE(Scheduler::Clock::now(), epoch + Scheduler::FRAME_PERIOD) << "An idle CPU kept the host busy";
+}
+
+TEST_F(TestChip8, SchedulerAppliesQueuedKeys) {
+    auto epoch = Scheduler::Clock::now();
+    Scheduler scheduler(chip8, SchedulerMode::RealTime, 10, epoch);
+    InputQueue input;
+    MovieRecorder recorder(0, 10, {});
+    scheduler.SetInput(&input, &recorder);
+
+    // A tap shorter than a frame, polled at once: the press lands on its instruction, the
+    // release is held back until the key was down for a whole frame
+    input.TryPush(KeyEvent{epoch + Scheduler::FRAME_PERIOD / 2, 0x5, true});
+    input.TryPush(KeyEvent{epoch + Scheduler::FRAME_PERIOD * 6 / 10, 0x5, false});
+    input.TryPush(KeyEvent{epoch + Scheduler::FRAME_PERIOD * 3, 0xA, true});
+
+    scheduler.Pump(epoch + Scheduler::FRAME_PERIOD);
+    ASSERT_EQ(chip8.get_keypad()[0x5], 1) << "The tap was not seen";
+    scheduler.Pump(epoch + Scheduler::FRAME_PERIOD * 2);
+    ASSERT_EQ(chip8.get_keypad()[0x5], 0);
+    scheduler.Pump(epoch + Scheduler::FRAME_PERIOD * 3);
+    ASSERT_EQ(chip8.get_keypad()[0xA], 0) << "A key change was applied before its time";
+    scheduler.Pump(epoch + Scheduler::FRAME_PERIOD * 4);
+    ASSERT_EQ(chip8.get_keypad()[0xA], 1);
+    ASSERT_EQ(input.get_size(), 0u);
+
+    const std::vector<InputEvent>& events = recorder.get_movie().events;
+    ASSERT_EQ(events.size(), 3u);
+    ASSERT_EQ(events[0].cycle, 5u);
+    ASSERT_EQ(events[1].cycle, 15u);
+    ASSERT_FALSE(events[1].pressed);
+    ASSERT_EQ(events[2].cycle, 30u);
+    ASSERT_EQ(events[2].key, 0xA);
+}
+
+TEST_F(TestChip8, SchedulerFlushesQueuedKeys) {
+    auto epoch = Scheduler::Clock::now();
+    Scheduler scheduler(chip8, SchedulerMode::RealTime, 10, epoch);
+    InputQueue input;
+    scheduler.SetInput(&input);
+
+    // Nothing runs while rewinding, every change still reaches the keypad at once
+    input.TryPush(KeyEvent{epoch + Scheduler::FRAME_PERIOD * 5, 0x5, true});
+    input.TryPush(KeyEvent{epoch + Scheduler::FRAME_PERIOD * 5, 0x5, false});
+    input.TryPush(KeyEvent{epoch + Scheduler::FRAME_PERIOD * 9, 0xA, true});
+    scheduler.FlushInput();
+    ASSERT_EQ(input.get_size(), 0u);
+    ASSERT_EQ(chip8.get_keypad()[0x5], 0);
+    ASSERT_EQ(chip8.get_keypad()[0xA], 1);
+    ASSERT_EQ(scheduler.get_cycle_count(), 0u);
+}
+
+// ====== Testing save states ======
+
+TEST_F(TestChip8, SaveStateRoundTrip) {
+    for (Chip8Engine engine : {Chip8Engine::Table, Chip8Engine::Jit}) {
+        Chip8 machine(engine);
+        machine.Seed(0x9E3779B9ull);
+        machine.LoadROM(randomAluRom(3));
+        machine.Run(500);
+
+        Chip8State state;
+        machine.SaveState(state);
+
+        // Diverge, then come back: the rest of the run must be identical
+        Chip8 reference(engine);
+        reference.LoadState(state);
+        machine.Run(700);
+        machine.LoadState(state);
+        ASSERT_TRUE(SameState(machine, reference)) << "LoadState didn't restore the state";
+
+        machine.Run(300);
+        reference.Run(300);
+        ASSERT_TRUE(SameState(machine, reference)) << "Runs diverged after LoadState";
+        ASSERT_TRUE(reference.is_dirty()) << "LoadState didn't mark the display dirty";
+    }
+}
+
+TEST_F(TestChip8, SaveStateRestoresRandomGenerator) {
+    // 0x200: RND V0, 0xFF ; 0x202: RND V1, 0xFF ; 0x204: JP 0x200
+    std::array<uint8_t, 6> rom = {0xC0, 0xFF, 0xC1, 0xFF, 0x12, 0x00};
+    chip8.Seed(0x9E3779B9ull);
+    chip8.LoadROM(rom);
+
+    Chip8State state;
+    chip8.SaveState(state);
+    chip8.Run(2);
+    uint8_t first = get_registers()[0], second = get_registers()[1];
+
+    chip8.LoadState(state);
+    chip8.Run(2);
+    ASSERT_EQ(get_registers()[0], first) << "The random sequence was not restored";
+    ASSERT_EQ(get_registers()[1], second) << "The random sequence was not restored";
+}
+
+TEST_F(TestChip8, RandomGeneratorIsDeterministic) {
+    // 0x200: RND V1, 0xFF ; 0x202: LD I, 0x300 ; 0x204: ADD I, V1 ; 0x206: LD V0, [I]
+    // 0x208: ADD V0, 0x01 ; 0x20A: LD [I], V0 (counts every byte drawn) ; 0x20C: JP 0x200
+    std::array<uint8_t, 14> rom = {0xC1, 0xFF, 0xA3, 0x00, 0xF1, 0x1E, 0xF0, 0x65,
+                                   0x70, 0x01, 0xF0, 0x55, 0x12, 0x00};
+
+    // Fresh CPUs draw the same sequence, a new seed draws another one
+    Chip8 first, second, reseeded;
+    reseeded.Seed(1);
+    for (Chip8* machine : {&first, &second, &reseeded}) {
+        machine->LoadROM(rom);
+        machine->Run(7 * 4096);
+    }
+    ASSERT_EQ(first.StateHash(), second.StateHash()) << "The default seed is not deterministic";
+    ASSERT_NE(first.StateHash(), reseeded.StateHash()) << "The seed is ignored";
+
+    // Every byte value comes out, close to 16 times each
+    std::span<const uint8_t, MEMORY_SIZE> memory = first.get_memory();
+    for (unsigned int value = 0; value < 256; ++value) {
+        EXPECT_GT(memory[0x300 + value], 0) << "byte " << value << " never drawn";
+        EXPECT_LT(memory[0x300 + value], 48) << "byte " << value << " drawn too often";
+    }
+}
+
+TEST_F(TestChip8, SaveStateFile) {
+    tempFilePath = "./temp_state.c8s";
+    chip8.LoadROM(randomAluRom(5));
+    chip8.Run(100);
+    chip8.SaveState(tempFilePath);
+
+    Chip8 restored;
+    restored.LoadState(tempFilePath);
+    ASSERT_TRUE(SameState(chip8, restored)) << "The save state file didn't restore the state";
+
+    // A corrupted header is rejected before touching the machine
+    Chip8State state;
+    chip8.SaveState(state);
+    state.version = CHIP8_STATE_VERSION + 1;
+    ASSERT_THROW(restored.LoadState(state), std::runtime_error);
+    ASSERT_THROW(restored.LoadState("./missing_state.c8s"), std::runtime_error);
+}
+
+TEST_F(TestChip8, LoadStateInvalidatesChangedCode) {
+    tempFilePath = "./temp_file.ch8";
+    writeFile(tempFilePath, selfModifyingRom);
+
+    // The snapshot holds the original code, the machine runs over its own rewritten code
+    for (Chip8Engine engine : {Chip8Engine::Predecoded, Chip8Engine::Block, Chip8Engine::Jit}) {
+        Chip8 machine(engine);
+        machine.LoadROM(tempFilePath);
+        Chip8State state;
+        machine.SaveState(state);
+
+        Chip8 reference;
+        reference.LoadROM(tempFilePath);
+
+        // 41 cycles stop right after the rewritten instruction was cached again
+        for (int round = 0; round < 3; ++round) {
+            machine.Run(41);
+            machine.LoadState(state);
+            reference.LoadState(state);
+            machine.Run(40);
+            reference.Run(40);
+            ASSERT_TRUE(SameState(machine, reference)) << "Stale cached code ran after LoadState, round " << round;
+        }
+    }
+}
+
+TEST_F(TestChip8, ProfilerCountsHandlersAndAddresses) {
+    if (!CHIP8_PROFILING) {
+        ASSERT_THROW(chip8.EnableProfiling(), std::runtime_error) << "Profiling enabled without the hooks";
+        return;
+    }
+
+    // 0x200: LD V0, 0x01 ; 0x202: ADD V1, 0x01 ; 0x204: JP 0x202
+    std::array<uint8_t, 6> rom = {0x60, 0x01, 0x71, 0x01, 0x12, 0x02};
+
+    // Every engine reports the real handlers, not the lazy decode stub, and a JIT CPU is interpreted
+    for (Chip8Engine engine : {Chip8Engine::Table, Chip8Engine::Predecoded, Chip8Engine::Block, Chip8Engine::Jit}) {
+        Chip8 machine(engine);
+        machine.LoadROM(rom);
+        machine.EnableProfiling();
+        machine.Run(1 + 2 * 100);
+
+        const Profiler* profiler = machine.get_profiler();
+        ASSERT_NE(profiler, nullptr);
+        EXPECT_EQ(profiler->get_total(), 201u);
+        EXPECT_EQ(profiler->get_count(0x6000), 1u);
+        EXPECT_EQ(profiler->get_count(0x7000), 100u);
+        EXPECT_EQ(profiler->get_count(0x1000), 100u);
+        EXPECT_EQ(profiler->get_pc_count(0x202), 100u);
+        EXPECT_EQ(profiler->get_pc_count(0x204), 100u);
+        EXPECT_EQ(machine.get_registers()[1], 100) << "Profiling changed the execution";
+
+        std::ostringstream folded;
+        profiler->WriteFolded(folded);
+        EXPECT_EQ(folded.str(), "OP_6xkk;0x200 1\nOP_7xkk;0x202 100\nOP_1nnn;0x204 100\n");
+    }
+}
+
+// 0x200: LD V0, 0x05 ; 0x202: LD DT, V0 ; 0x204: LD V1, DT ; 0x206: SE V1, 0x00 ; 0x208: JP 0x204
+// 0x20A: LD V2, K ; 0x20C: JP 0x20C
+static const std::array<uint8_t, 14> idleRom = {0x60, 0x05, 0xF0, 0x15, 0xF1, 0x07, 0x31, 0x00,
+                                                0x12, 0x04, 0xF2, 0x0A, 0x12, 0x0C};
+
+TEST_F(TestChip8, IdleStateDetection) {
+    chip8.LoadROM(idleRom);
+
+    // The timer loop is only reported once a full iteration left Vx equal to the timer
+    chip8.Run(2);
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::Running);
+    chip8.Run(3);
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::WaitingForTimer);
+    ASSERT_EQ(chip8.SkipIdleCycles(100), 99u) << "Only whole iterations can be skipped";
+    for (uint16_t pc : {0x206, 0x208, 0x204}) {
+        chip8.Run(1);
+        ASSERT_EQ(chip8.get_pc(), pc);
+        ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::WaitingForTimer) << "Loop missed at " << pc;
+    }
+    chip8.TickTimers();
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::Running) << "V1 no longer holds the timer";
+
+    // Once the timer expires the loop exits to the key wait
+    for (int i = 0; i < 4; ++i)
+        chip8.TickTimers();
+    chip8.Run(4);
+    ASSERT_EQ(chip8.get_pc(), 0x20A);
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::WaitingForKey);
+    ASSERT_EQ(chip8.SkipIdleCycles(100), 100u);
+
+    chip8.SetKey(0x3, true);
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::Running) << "A key down was ignored";
+    chip8.Run(2);
+    ASSERT_EQ(chip8.get_registers()[2], 0x3);
+    ASSERT_EQ(chip8.get_idle_state(), Chip8IdleState::Halted);
+    ASSERT_EQ(chip8.SkipIdleCycles(100), 100u);
+}
+
+TEST_F(TestChip8, SchedulerSkipsIdleLoopsExactly) {
+    // A scheduled CPU skips the idle loops, a plain one interprets them: both must agree at every frame
+    for (Chip8Engine engine : {Chip8Engine::Table, Chip8Engine::Predecoded, Chip8Engine::Block, Chip8Engine::Jit}) {
+        Chip8 skipping(engine), reference(engine);
+        skipping.LoadROM(idleRom);
+        reference.LoadROM(idleRom);
+        // Frames are not a whole number of loop iterations, the skip has to leave the remainder to the engine
+        Scheduler scheduler(skipping, SchedulerMode::FixedRatio, 101);
+
+        for (int frame = 0; frame < 20; ++frame) {
+            if (frame == 12) {
+                skipping.SetKey(0x7, true);
+                reference.SetKey(0x7, true);
+            }
+
+            scheduler.RunFrames(1);
+            reference.Run(101);
+            reference.TickTimers();
+
+            Chip8State expected, actual;
+            reference.SaveState(expected);
+            skipping.SaveState(actual);
+            ASSERT_EQ(std::memcmp(&expected, &actual, sizeof(Chip8State)), 0) << "Skipping diverged at frame " << frame;
+        }
+        ASSERT_EQ(skipping.get_registers()[2], 0x7);
+        ASSERT_EQ(scheduler.get_cycle_count(), 2020u);
+    }
+}
@@ -0,0 +1,66 @@
+#include "Framebuffer.h"
+#include "Tests_common.h"
+
+// ====== Testing the packed framebuffer expansion ======
+
+TEST(TestFramebuffer, ScalarExpansion) {
+    std::array<uint64_t, VIDEO_HEIGHT> rows = {0};
+    rows[0] = 0x8000000000000001ull;    // leftmost and rightmost pixels
+    rows[1] = 0xF0ull << 56;            // first 4 pixels
+
+    std::array<uint32_t, VIDEO_WIDTH * VIDEO_HEIGHT> pixels;
+    ExpandFramebufferScalar(rows.data(), VIDEO_HEIGHT, pixels.data(), VIDEO_WIDTH * sizeof(uint32_t));
+
+    EXPECT_EQ(pixels[0], PIXEL_ON_COLOR);
+    EXPECT_EQ(pixels[1], PIXEL_OFF_COLOR);
+    EXPECT_EQ(pixels[VIDEO_WIDTH - 1], PIXEL_ON_COLOR);
+    for (unsigned int col = 0; col < 8; ++col)
+        EXPECT_EQ(pixels[VIDEO_WIDTH + col], col < 4 ? PIXEL_ON_COLOR : PIXEL_OFF_COLOR) << "column " << col;
+}
+
+TEST(TestFramebuffer, SimdMatchesScalar) {
+    auto rows = generateRandomData<uint64_t, VIDEO_HEIGHT>();
+    const uint32_t on = 0x33FF66FF, off = 0x101020FF;
+
+    // Destination rows padded like a locked texture with a larger pitch
+    const int pitch = (VIDEO_WIDTH + 8) * sizeof(uint32_t);
+    std::vector<uint32_t> expected((VIDEO_WIDTH + 8) * VIDEO_HEIGHT, 0xDEADBEEF);
+    std::vector<uint32_t> actual(expected);
+
+    ExpandFramebufferScalar(rows.data(), VIDEO_HEIGHT, expected.data(), pitch, on, off);
+    ExpandFramebuffer(rows.data(), VIDEO_HEIGHT, actual.data(), pitch, on, off);
+
+    ASSERT_EQ(actual, expected) << "Vectorized expansion differs from the scalar one";
+}
+
+// ====== Testing the bit-plane expansion ======
+
+TEST(TestFramebuffer, PlanesMatchPerPixelReference) {
+    std::vector<uint64_t> plane0(XO_VIDEO_HEIGHT * XO_ROW_WORDS), plane1(plane0.size());
+    auto random0 = generateRandomData<uint64_t, XO_VIDEO_HEIGHT * XO_ROW_WORDS>();
+    auto random1 = generateRandomData<uint64_t, XO_VIDEO_HEIGHT * XO_ROW_WORDS>();
+    std::copy(random0.begin(), random0.end(), plane0.begin());
+    std::copy(random1.begin(), random1.end(), plane1.begin());
+    plane0[3] = plane1[3] = 0;  // an empty word takes the fill path
+
+    const std::array<uint32_t, 4> palette = {0x000000FF, 0xFFFFFFFF, 0xFF0000FF, 0x00FF00FF};
+    for (bool hires : {false, true}) {
+        // Rows from the middle of a lo-res pair, into a padded pitch
+        const unsigned int firstRow = 3, rowCount = 40;
+        const int pitch = (XO_VIDEO_WIDTH + 4) * sizeof(uint32_t);
+        std::vector<uint32_t> pixels((XO_VIDEO_WIDTH + 4) * rowCount);
+        ExpandPlanes(plane0.data(), plane1.data(), hires, firstRow, rowCount, pixels.data(), pitch, palette);
+
+        const unsigned int scale = hires ? 1 : 2;
+        for (unsigned int row = 0; row < rowCount; ++row) {
+            for (unsigned int x = 0; x < XO_VIDEO_WIDTH; ++x) {
+                const unsigned int column = x / scale;
+                const unsigned int word = (firstRow + row) / scale * XO_ROW_WORDS + column / 64;
+                const unsigned int bit = 63 - column % 64;
+                const uint32_t expected = palette[((plane0[word] >> bit) & 1u) | (((plane1[word] >> bit) & 1u) << 1)];
+                ASSERT_EQ(pixels[row * (XO_VIDEO_WIDTH + 4) + x], expected)
+                    << (hires ? "hi-res" : "lo-res") << " row " << firstRow + row << " column " << x;
+            }
+        }
+    }
+}
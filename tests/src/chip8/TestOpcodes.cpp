@@ -5,7 +5,7 @@
 TEST_F(TestChip8, OP_00E0) {
     get_video().fill(1);
     chip8.OP_00E0();
-    std::array<uint32_t, VIDEO_HEIGHT*VIDEO_WIDTH> video_null = {0};
+    std::array<uint64_t, VIDEO_HEIGHT> video_null = {0};
     ASSERT_EQ(get_video(), video_null) << "OP_00E0 didn't reset the video display";
 }
 
@@ -102,9 +102,39 @@ TEST_F(TestChip8, OP_00EE) {
 
 // }
 
-// TEST_F(TestChip8, OP_Dxyn) {
+TEST_F(TestChip8, OP_Dxyn) {
+    // Font sprite "0" at (2, 3), 5 rows high
+    get_index() = FONTSET_START_ADDRESS;
+    get_registers()[0] = 2;
+    get_registers()[1] = 3;
+    get_opcode() = 0xD015;
 
-// }
+    chip8.OP_Dxyn();
+    for (unsigned int row = 0; row < FONT_SIZE; ++row)
+        ASSERT_EQ(get_video()[3 + row], static_cast<uint64_t>(fontset[row]) << (56 - 2))
+            << "OP_Dxyn drew row " << row << " wrong";
+    ASSERT_EQ(get_registers()[0xF], 0) << "OP_Dxyn reported a collision on an empty screen";
+
+    // Drawing the same sprite again erases it and collides
+    chip8.OP_Dxyn();
+    std::array<uint64_t, VIDEO_HEIGHT> video_null = {0};
+    ASSERT_EQ(get_video(), video_null) << "OP_Dxyn didn't XOR the sprite";
+    ASSERT_EQ(get_registers()[0xF], 1) << "OP_Dxyn didn't report the collision";
+}
+
+TEST_F(TestChip8, OP_Dxyn_Clipping) {
+    // Sprite "0" at (62, 30): only 2 columns and 2 rows are visible
+    get_index() = FONTSET_START_ADDRESS;
+    get_registers()[0] = 62;
+    get_registers()[1] = 30;
+    get_opcode() = 0xD015;
+
+    chip8.OP_Dxyn();
+    ASSERT_EQ(get_video()[30], 0x3ull) << "OP_Dxyn didn't clip on the right edge";
+    ASSERT_EQ(get_video()[31], 0x2ull) << "OP_Dxyn didn't clip on the right edge";
+    for (unsigned int row = 0; row < 30; ++row)
+        ASSERT_EQ(get_video()[row], 0ull) << "OP_Dxyn wrapped the sprite to row " << row;
+}
 
 // TEST_F(TestChip8, OP_Ex9E) {
 
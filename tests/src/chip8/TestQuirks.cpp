@@ -0,0 +1,96 @@
+#include "Chip8.h"
+#include "Tests_common.h"
+
+// 0x200: LD V1, 5 ; LD V2, 12 ; SHR V1, V2 ; LD VF, 7 ; OR V3, V2 ; LD V4, VF ;
+// 0x20C: LD I, 0x300 ; LD V0, 0x99 ; LD [I], V0 ; LD [I], V0 ; LD V0, 4 ; JP V0, 0x21C
+// 0x220: LD VA, 1 ; JP 0x222 (nnn + V0)    0x228: LD VA, 2 ; JP 0x22A (xnn + V2)
+static std::vector<uint8_t> quirkRom() {
+    std::vector<uint8_t> rom = {0x61, 0x05, 0x62, 0x0C, 0x81, 0x26, 0x6F, 0x07, 0x83, 0x21, 0x84, 0xF0,
+                                0xA3, 0x00, 0x60, 0x99, 0xF0, 0x55, 0xF0, 0x55, 0x60, 0x04, 0xB2, 0x1C};
+    rom.resize(0x20);
+    rom.insert(rom.end(), {0x6A, 0x01, 0x12, 0x22, 0x00, 0x00, 0x00, 0x00, 0x6A, 0x02, 0x12, 0x2A});
+    return rom;
+}
+
+// ====== Testing the profiles ======
+
+TEST(TestQuirks, ProfilesOnEveryEngine) {
+    struct Expected {
+        Chip8QuirkProfile profile;
+        uint8_t shifted;    // V1: 5 >> 1, or 12 >> 1 when the shift reads Vy
+        uint8_t flag;       // V4: VF after OR, 7 unless the logic ops reset it
+        uint8_t second;     // [0x301]: written by the second Fx55 only if I advanced
+        uint8_t target;     // VA: 1 for nnn + V0, 2 for xnn + Vx
+    };
+    const std::vector<Expected> profiles = {
+        {Chip8QuirkProfile::Default, 2, 7, 0x00, 1},
+        {Chip8QuirkProfile::Cosmac, 6, 0, 0x99, 1},
+        {Chip8QuirkProfile::SuperChip, 2, 7, 0x00, 2},
+        {Chip8QuirkProfile::XoChip, 6, 7, 0x99, 1},
+    };
+
+    for (const Expected& expected : profiles) {
+        // The JIT translates the shifts and logic ops natively, it must follow the profile too
+        for (Chip8Engine engine : {Chip8Engine::Table, Chip8Engine::Predecoded, Chip8Engine::Block, Chip8Engine::Jit}) {
+            std::string label = std::string(QuirkProfileName(expected.profile)) + " on engine "
+                + std::to_string(static_cast<int>(engine));
+
+            Chip8 chip8(engine, expected.profile);
+            ASSERT_EQ(chip8.get_quirk_profile(), expected.profile);
+            chip8.LoadROM(quirkRom());
+            chip8.Run(20);
+
+            ASSERT_TRUE(chip8.is_halted()) << label;
+            ASSERT_EQ(chip8.get_registers()[0x1], expected.shifted) << label;
+            ASSERT_EQ(chip8.get_registers()[0x3], 12) << label;
+            ASSERT_EQ(chip8.get_registers()[0x4], expected.flag) << label;
+            ASSERT_EQ(chip8.get_memory()[0x300], 0x99) << label;
+            ASSERT_EQ(chip8.get_memory()[0x301], expected.second) << label;
+            ASSERT_EQ(chip8.get_registers()[0xA], expected.target) << label;
+        }
+    }
+}
+
+TEST(TestQuirks, SpritesClipOrWrap) {
+    // 0x200: LD V0, 60 ; LD V1, 30 ; LD I, 0x20A ; DRW V0, V1, 4 ; JP 0x208 ; sprite 0xFF x4
+    std::vector<uint8_t> rom = {0x60, 0x3C, 0x61, 0x1E, 0xA2, 0x0A, 0xD0, 0x14, 0x12, 0x08, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    Chip8 clipped, wrapped(Chip8Engine::Table, Chip8QuirkProfile::XoChip);
+    clipped.LoadROM(rom);
+    wrapped.LoadROM(rom);
+    wrapped.ClearDirty();
+    clipped.Run(5);
+    wrapped.Run(5);
+
+    // Columns 60-63, then 0-3 when wrapping; rows 30, 31, then 0, 1 when wrapping
+    for (unsigned int row : {30u, 31u}) {
+        ASSERT_EQ(clipped.get_framebuffer()[row], 0xFULL);
+        ASSERT_EQ(wrapped.get_framebuffer()[row], 0xF00000000000000FULL);
+    }
+    for (unsigned int row : {0u, 1u}) {
+        ASSERT_EQ(clipped.get_framebuffer()[row], 0ULL);
+        ASSERT_EQ(wrapped.get_framebuffer()[row], 0xF00000000000000FULL);
+    }
+    ASSERT_EQ(wrapped.get_dirty_rows(), 0xC0000003ULL);
+}
+
+// ====== Testing the profile selection ======
+
+TEST(TestQuirks, DetectsReachableInstructions) {
+    // JP 0x204 over a 00FF that is only data, then a sprite made of 00 FF bytes
+    std::vector<uint8_t> plain = {0x12, 0x04, 0x00, 0xFF, 0xA2, 0x0A, 0xD0, 0x12, 0x12, 0x08, 0x00, 0xFF};
+    ASSERT_EQ(DetectQuirkProfile(plain), Chip8QuirkProfile::Default) << "Sprite data was taken for code";
+
+    // HIGH reached through a call, and a skip over it
+    std::vector<uint8_t> schip = {0x22, 0x04, 0x12, 0x02, 0x30, 0x00, 0x00, 0xFF, 0x00, 0xEE};
+    ASSERT_EQ(DetectQuirkProfile(schip), Chip8QuirkProfile::SuperChip);
+
+    // A long load wins over the SUPER-CHIP instructions
+    std::vector<uint8_t> xochip = {0x00, 0xFF, 0xF0, 0x00, 0x03, 0x00, 0x12, 0x06};
+    ASSERT_EQ(DetectQuirkProfile(xochip), Chip8QuirkProfile::XoChip);
+    ASSERT_EQ(DetectQuirkProfile({}), Chip8QuirkProfile::Default);
+
+    for (auto profile : {Chip8QuirkProfile::Default, Chip8QuirkProfile::Cosmac, Chip8QuirkProfile::SuperChip, Chip8QuirkProfile::XoChip})
+        ASSERT_EQ(ParseQuirkProfile(QuirkProfileName(profile)), profile);
+    ASSERT_THROW(ParseQuirkProfile("vip"), std::runtime_error);
+}
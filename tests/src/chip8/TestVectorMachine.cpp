@@ -0,0 +1,113 @@
+#include "VectorMachine.h"
+#include "Tests_common.h"
+
+// Random ROM mixing vectorized and scalar instructions, with lane-dependent branches (Cxkk)
+static std::vector<uint8_t> randomDivergentRom(unsigned int seed) {
+    std::mt19937 gen(seed);
+    std::array<uint16_t, 10> aluOps = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE, 0x8};
+    std::vector<uint8_t> rom(256);
+
+    for (size_t i = 0; i + 4 < rom.size(); i += 2) {
+        uint16_t x = gen() % 16, y = gen() % 16, kk = gen() % 256;
+        uint16_t instruction = 0;
+        switch (gen() % 14) {
+            case 0: instruction = 0x6000 | (x << 8) | kk; break;
+            case 1: instruction = 0x7000 | (x << 8) | kk; break;
+            case 2: instruction = 0x3000 | (x << 8) | kk; break;
+            case 3: instruction = 0x4000 | (x << 8) | kk; break;
+            case 4: instruction = 0x9000 | (x << 8) | (y << 4); break;
+            case 5: instruction = 0xA300 | kk; break;
+            case 6: instruction = 0xF033 | (x << 8); break;
+            case 7: instruction = 0xF015 | (x << 8); break;
+            case 8: instruction = 0xF007 | (x << 8); break;
+            case 9: instruction = 0xC000 | (x << 8) | kk; break;
+            case 10: instruction = 0xF01E | (x << 8); break;
+            case 11: instruction = 0x5000 | (x << 8) | (y << 4); break;
+            default: instruction = 0x8000 | (x << 8) | (y << 4) | aluOps[gen() % aluOps.size()]; break;
+        }
+        rom[i] = instruction >> 8;
+        rom[i + 1] = instruction & 0xFF;
+    }
+
+    // Loop back to the start, twice in case the last random instruction skips
+    rom[rom.size() - 4] = 0x12;
+    rom[rom.size() - 3] = 0x00;
+    rom[rom.size() - 2] = 0x12;
+    rom[rom.size() - 1] = 0x00;
+    return rom;
+}
+
+// One distinct seed per lane
+static uint64_t laneSeed(size_t lane) {
+    return 0x9E3779B9ull * (lane + 1);
+}
+
+// ====== Testing the lockstep engine against scalar machines ======
+
+TEST(TestVectorMachine, MatchesScalarOnRandomPrograms) {
+    const size_t lanes = 37;    // not a multiple of the SIMD width
+
+    for (unsigned int seed = 0; seed < 8; ++seed) {
+        std::vector<uint8_t> rom = randomDivergentRom(seed);
+
+        VectorMachine vm(lanes);
+        vm.LoadROM(rom);
+        for (size_t lane = 0; lane < lanes; ++lane)
+            vm.Seed(lane, laneSeed(lane));
+
+        std::vector<std::unique_ptr<Chip8>> scalar;
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            scalar.push_back(std::make_unique<Chip8>());
+            scalar[lane]->Seed(laneSeed(lane));
+            scalar[lane]->LoadROM(rom);
+        }
+
+        size_t maxGroups = 0;
+        for (int frame = 0; frame < 30; ++frame) {
+            for (int i = 0; i < 10; ++i) {
+                vm.Step();
+                maxGroups = std::max(maxGroups, vm.get_group_count());
+            }
+            vm.TickTimers();
+
+            for (size_t lane = 0; lane < lanes; ++lane) {
+                scalar[lane]->Run(10);
+                scalar[lane]->TickTimers();
+            }
+        }
+
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            ASSERT_EQ(vm.get_pc(lane), scalar[lane]->get_pc()) << "seed " << seed << " lane " << lane;
+            ASSERT_EQ(vm.StateHash(lane), scalar[lane]->StateHash()) << "seed " << seed << " lane " << lane;
+        }
+        ASSERT_LE(maxGroups, lanes);
+    }
+}
+
+TEST(TestVectorMachine, LanesDivergeAndStayConverged) {
+    // 0x200: LD V0, 0x62 ; 0x202: RND V1, 0xFF ; 0x204: LD I, 0x20A ; 0x206: LD [I], V1
+    // 0x208: LD V3, 0x00 ; 0x20A: (written by each lane: LD V2, V1) ; 0x20C: JP 0x20C
+    std::vector<uint8_t> rom = {0x60, 0x62, 0xC1, 0xFF, 0xA2, 0x0A, 0xF1, 0x55,
+                                0x63, 0x00, 0x00, 0x00, 0x12, 0x0C};
+    const size_t lanes = 64;
+
+    VectorMachine vm(lanes);
+    vm.LoadROM(rom);
+    for (size_t lane = 0; lane < lanes; ++lane)
+        vm.Seed(lane, laneSeed(lane));
+
+    vm.Run(5);
+    ASSERT_EQ(vm.get_group_count(), 1u) << "Lanes on the same instruction were not grouped";
+
+    // Every lane now runs the instruction it wrote itself
+    vm.Step();
+    ASSERT_GT(vm.get_group_count(), 1u) << "Self-modified lanes were not split";
+
+    vm.Run(4);
+    ASSERT_EQ(vm.get_group_count(), 1u) << "Lanes did not reconverge on the final jump";
+
+    for (size_t lane = 0; lane < lanes; ++lane) {
+        ASSERT_EQ(vm.get_register(lane, 2), vm.get_register(lane, 1)) << "lane " << lane;
+        ASSERT_EQ(vm.get_pc(lane), 0x20C);
+    }
+}
@@ -0,0 +1,93 @@
+#include "Movie.h"
+#include "BatchRunner.h"
+#include "Tests_common.h"
+
+#include <filesystem>
+#include <fstream>
+
+// 0x200: LD V0, K ; 0x202: ADD V1, V0 ; 0x204: RND V2, 0xFF ; 0x206: ADD V3, V2 ; 0x208: JP 0x200
+static const std::vector<uint8_t> keyRom = {0xF0, 0x0A, 0x81, 0x04, 0xC2, 0xFF, 0x83, 0x24, 0x12, 0x00};
+
+// ====== Testing the movie file ======
+
+TEST(TestMovie, SaveLoadRoundTrip) {
+    std::string path = "./temp_movie.c8m";
+    MovieRecorder recorder(42, 15, keyRom, Chip8QuirkProfile::Cosmac);
+
+    std::array<uint8_t, NUM_KEYS> keypad{};
+    keypad[0x3] = 1;
+    recorder.Record(10, keypad);
+    recorder.Record(20, keypad);            // nothing changed, nothing recorded
+    keypad[0x3] = 0;
+    keypad[0xF] = 1;
+    recorder.Record(1'000'000'000'000ULL, keypad);
+
+    const Movie& recorded = recorder.get_movie();
+    ASSERT_EQ(recorded.events.size(), 3u);
+    recorded.Save(path);
+
+    // Three events in a few bytes past the header
+    ASSERT_LT(std::filesystem::file_size(path), 32u + 16u);
+
+    Movie loaded = Movie::Load(path);
+    EXPECT_EQ(loaded.seed, 42u);
+    EXPECT_EQ(loaded.instructionsPerFrame, 15u);
+    EXPECT_EQ(loaded.romHash, Movie::HashRom(keyRom));
+    EXPECT_EQ(loaded.quirks, Chip8QuirkProfile::Cosmac) << "The replay would run other quirks";
+    ASSERT_EQ(loaded.events.size(), 3u);
+    for (std::size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(loaded.events[i].cycle, recorded.events[i].cycle) << "event " << i;
+        EXPECT_EQ(loaded.events[i].key, recorded.events[i].key) << "event " << i;
+        EXPECT_EQ(loaded.events[i].pressed, recorded.events[i].pressed) << "event " << i;
+    }
+
+    // A profile unknown to this version is rejected
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(6);
+        file.put(static_cast<char>(0x7F));
+    }
+    ASSERT_THROW(Movie::Load(path), std::runtime_error);
+    recorded.Save(path);
+
+    // A truncated file is rejected
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    ASSERT_THROW(Movie::Load(path), std::runtime_error);
+    std::filesystem::remove(path);
+
+    ASSERT_THROW(Movie::Load("./missing_movie.c8m"), std::runtime_error);
+}
+
+// ====== Testing the replay ======
+
+TEST(TestMovie, ReplayMatchesRecordedSession) {
+    const unsigned int instructionsPerFrame = 7;
+    const uint64_t seed = 1234;
+
+    // Live session: keys change between frames, as when polled by the main loop
+    Chip8 live;
+    live.Seed(seed);
+    live.LoadROM(keyRom);
+    Scheduler scheduler(live, SchedulerMode::FixedRatio, instructionsPerFrame);
+    MovieRecorder recorder(seed, instructionsPerFrame, keyRom);
+
+    for (int frame = 0; frame < 300; ++frame) {
+        uint8_t key = (frame / 5) % NUM_KEYS;
+        live.SetKey(key, (frame / 3) % 2 == 0);
+        recorder.Record(scheduler.get_cycle_count(), live.get_keypad());
+        scheduler.Pump();
+    }
+    ASSERT_EQ(scheduler.get_cycle_count(), 300u * instructionsPerFrame);
+    ASSERT_GT(recorder.get_movie().events.size(), 50u);
+
+    // Replay without any live input, on every engine
+    const Movie& movie = recorder.get_movie();
+    for (Chip8Engine engine : {Chip8Engine::Table, Chip8Engine::Predecoded, Chip8Engine::Block, Chip8Engine::Jit}) {
+        BatchJob job{"replay", RomImage::Copy(keyRom), scheduler.get_cycle_count(),
+                     movie.events, movie.seed, engine, movie.instructionsPerFrame};
+
+        BatchResult result = BatchRunner::RunJob(job);
+        ASSERT_TRUE(result.error.empty()) << result.error;
+        ASSERT_EQ(result.stateHash, live.StateHash()) << "The replay diverged from the session";
+    }
+}
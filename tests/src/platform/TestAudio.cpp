@@ -0,0 +1,142 @@
+#include "Audio.h"
+#include "Tests_common.h"
+
+#include <thread>
+
+// ====== Testing the ring ======
+
+TEST(TestAudio, RingIsBoundedFifo) {
+    SpscRing<int, 4> ring;
+    int value = -1;
+    ASSERT_EQ(ring.Peek(), nullptr);
+    ASSERT_FALSE(ring.TryPop(value));
+
+    // Several laps so the indices wrap around the slots
+    for (int lap = 0; lap < 3; ++lap) {
+        for (int i = 0; i < 4; ++i)
+            ASSERT_TRUE(ring.TryPush(lap * 4 + i));
+        ASSERT_FALSE(ring.TryPush(99)) << "A full ring accepted an element";
+        ASSERT_EQ(ring.get_size(), 4u);
+
+        ASSERT_EQ(*ring.Peek(), lap * 4);
+        for (int i = 0; i < 4; ++i) {
+            ASSERT_TRUE(ring.TryPop(value));
+            ASSERT_EQ(value, lap * 4 + i);
+        }
+        ASSERT_FALSE(ring.TryPop(value));
+    }
+}
+
+TEST(TestAudio, RingKeepsOrderAcrossThreads) {
+    const int count = 200000;
+    SpscRing<int, 64> ring;
+
+    std::thread producer([&ring] {
+        for (int i = 0; i < count; ++i)
+            while (!ring.TryPush(i))
+                std::this_thread::yield();
+    });
+
+    int expected = 0, value = 0;
+    while (expected < count) {
+        if (!ring.TryPop(value)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ASSERT_EQ(value, expected) << "Element lost or reordered";
+        ++expected;
+    }
+    producer.join();
+    ASSERT_EQ(ring.get_size(), 0u);
+}
+
+// ====== Testing the synthesiser ======
+
+TEST(TestAudio, EdgesLandOnTheirSample) {
+    AudioSynth synth(48000, 256);
+    std::vector<int16_t> out(256, 1);
+
+    // The first buffer anchors the clocks, the edges play one buffer later
+    ASSERT_TRUE(synth.SetTone(true, 1000));
+    ASSERT_TRUE(synth.SetTone(true, 1010)) << "An unchanged state must not be queued";
+    ASSERT_TRUE(synth.SetTone(false, 1100));
+    synth.Render(out.data(), out.size());
+    for (int16_t sample : out)
+        ASSERT_EQ(sample, 0);
+    ASSERT_EQ(synth.get_playhead(), 1000u);
+
+    // 440 Hz: 54.5 samples per half period, the beep starts high
+    synth.Render(out.data(), out.size());
+    ASSERT_EQ(out[0], AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[54], AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[55], -AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[99], -AUDIO_AMPLITUDE);
+    for (std::size_t i = 100; i < out.size(); ++i)
+        ASSERT_EQ(out[i], 0) << "The beeper did not stop at sample " << i;
+}
+
+TEST(TestAudio, PatternPlaysAtItsPitch) {
+    AudioSynth synth(48000, 256);
+    std::vector<int16_t> out(2048);
+
+    // 4000 bits per second at pitch 64: 12 samples per bit, 1536 per loop of the 128 bits
+    std::array<uint8_t, AUDIO_PATTERN_SIZE> pattern{0xF0};
+    ASSERT_TRUE(synth.SetPattern(pattern, 64, 0));
+    ASSERT_TRUE(synth.SetTone(true, 0));
+    synth.Render(out.data(), 256);
+    synth.Render(out.data(), out.size());
+    ASSERT_EQ(out[0], AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[47], AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[48], -AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[1535], -AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[1536], AUDIO_AMPLITUDE) << "The pattern did not loop";
+
+    // 48 steps up is an octave: 6 samples per bit, from the start of the next beep
+    ASSERT_TRUE(synth.SetPattern(pattern, 112, synth.get_playhead()));
+    synth.SetTone(false, synth.get_playhead());
+    synth.SetTone(true, synth.get_playhead());
+    synth.Render(out.data(), 256);
+    ASSERT_EQ(out[22], AUDIO_AMPLITUDE);
+    ASSERT_EQ(out[25], -AUDIO_AMPLITUDE);
+}
+
+TEST(TestAudio, DriftReanchorsTheClocks) {
+    AudioSynth synth(48000, 256);
+    std::vector<int16_t> out(256);
+    synth.SetTone(true, 0);
+    synth.Render(out.data(), out.size());
+    synth.Render(out.data(), out.size());
+    ASSERT_EQ(out[0], AUDIO_AMPLITUDE);
+
+    // An edge far ahead of the playhead is delayed by one buffer, not by its lead
+    synth.SetTone(false, 100000);
+    synth.Render(out.data(), out.size());
+    ASSERT_NE(out[255], 0);
+    synth.Render(out.data(), out.size());
+    ASSERT_EQ(out[0], 0);
+
+    // A late edge plays at once
+    synth.SetTone(true, synth.get_playhead() - 100);
+    synth.Render(out.data(), out.size());
+    ASSERT_EQ(out[0], AUDIO_AMPLITUDE);
+}
+
+// ====== Testing the device ======
+
+TEST(TestAudio, DummyDriverKeepsLatencyLow) {
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    {
+        AudioOutput audio;
+        ASSERT_TRUE(audio.is_open()) << "The dummy driver did not open";
+        ASSERT_LT(audio.get_latency(), 0.020);
+
+        // The callback runs on the SDL audio thread meanwhile
+        std::array<uint8_t, AUDIO_PATTERN_SIZE> pattern{0xAA};
+        for (int i = 0; i < 20; ++i) {
+            audio.SetTone(i % 2 == 0);
+            audio.SetPattern(pattern, static_cast<uint8_t>(64 + i));
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    SDL_setenv("SDL_AUDIODRIVER", "", 1);
+}
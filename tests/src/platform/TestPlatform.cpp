@@ -52,6 +52,79 @@ TEST_F(TestPlatform, ProcessInputKeyOutBound) {
         EXPECT_EQ(keys[i], 0) << "key " << i << " is considered pressed";
 }
 
+TEST_F(TestPlatform, ProcessInputQueuesTaps) {
+    // A press and a release polled together both reach the queue, in order
+    event.key.timestamp = SDL_GetTicks();
+    KeyDown(event, (int)'x');
+    KeyUp(event);
+    KeyDown(event, (int)'b');
+    InputQueue input;
+    platform.ProcessInput(input);
+
+    KeyEvent change;
+    ASSERT_TRUE(input.TryPop(change));
+    EXPECT_EQ(change.key, 0);
+    EXPECT_TRUE(change.pressed);
+    EXPECT_LE(change.time, std::chrono::steady_clock::now());
+    ASSERT_TRUE(input.TryPop(change));
+    EXPECT_EQ(change.key, 0);
+    EXPECT_FALSE(change.pressed);
+    EXPECT_FALSE(input.TryPop(change)) << "A key outside of the keypad was queued";
+}
+
+TEST_F(TestPlatform, ProcessInputIgnoresRepeats) {
+    // Holding a key makes the keyboard repeat its press
+    KeyDown(event, (int)'x');
+    event.key.repeat = 1;
+    KeyDown(event, (int)'x');
+    KeyDown(event, (int)'x');
+    event.key.repeat = 0;
+    KeyUp(event);
+    InputQueue input;
+    platform.ProcessInput(input);
+
+    KeyEvent change;
+    ASSERT_TRUE(input.TryPop(change));
+    EXPECT_TRUE(change.pressed);
+    ASSERT_TRUE(input.TryPop(change));
+    EXPECT_FALSE(change.pressed) << "A repeated press was queued";
+    EXPECT_FALSE(input.TryPop(change));
+}
+
+TEST_F(TestPlatform, ProcessInputKeepsReleasesOfAFullQueue) {
+    InputQueue input;
+    while (input.TryPush(KeyEvent{{}, 0x5, true})) {}
+
+    KeyDown(event, (int)'x');
+    KeyUp(event);
+    platform.ProcessInput(input);
+    ASSERT_EQ(input.get_size(), input.get_capacity());
+
+    // Once the CPU reads the queue again the key ends up released
+    KeyEvent change;
+    while (input.TryPop(change))
+        ASSERT_EQ(change.key, 0x5);
+    platform.ProcessInput(input);
+    ASSERT_TRUE(input.TryPop(change)) << "The release was lost";
+    EXPECT_EQ(change.key, 0);
+    EXPECT_FALSE(change.pressed);
+    EXPECT_FALSE(input.TryPop(change));
+}
+
+TEST_F(TestPlatform, ProcessInputRewindKey) {
+    KeyDown(event, SDLK_BACKSPACE);
+    platform.ProcessInput(keys);
+
+    // Backspace rewinds without touching the CHIP-8 keypad
+    EXPECT_TRUE(platform.is_rewinding()) << "Backspace does not start rewinding";
+    for (int i=0; i<NUM_KEYS; i++)
+        EXPECT_EQ(keys[i], 0) << "key " << i << " is considered pressed";
+
+    KeyUp(event);
+    platform.ProcessInput(keys);
+    EXPECT_FALSE(platform.is_rewinding()) << "Releasing Backspace does not stop rewinding";
+}
+
 TEST_F(TestPlatform, ProcessInputQuitEvent) {
     // Simulate SDL_QUIT event
     event.type = SDL_QUIT;
@@ -72,4 +145,24 @@ TEST_F(TestPlatform, UpdateRunsWithoutCrash) {
 
     // TODO: check value in memory to ensure correct update
     SUCCEED() << "Platform::Update crashed";
-}
\ No newline at end of file
+}
+
+TEST_F(TestPlatform, UpdatePackedRunsWithoutCrash) {
+    std::array<uint64_t, VIDEO_HEIGHT> rows = {0};
+    rows[0] = 0xFFull;
+    platform.SetColors(0x00FF00FF, 0x000000FF);
+    platform.UpdatePacked(rows.data());
+
+    SUCCEED() << "Platform::UpdatePacked crashed";
+}
+
+TEST_F(TestPlatform, UpdatePackedDirtyRows) {
+    std::array<uint64_t, VIDEO_HEIGHT> rows = {0};
+    rows[5] = 0xF0ull << 56;
+
+    // Only rows 5 to 6 are uploaded, and no row means no upload at all
+    platform.UpdatePacked(rows.data(), 0x60ull);
+    platform.UpdatePacked(rows.data(), 0);
+
+    SUCCEED() << "Platform::UpdatePacked crashed on a partial update";
+}
@@ -0,0 +1,55 @@
+#include "TripleBuffer.h"
+#include "Tests_common.h"
+
+#include <thread>
+
+// ====== Testing the hand-over ======
+
+TEST(TestTripleBuffer, ConsumerGetsTheNewestValue) {
+    TripleBuffer<int> buffer;
+    ASSERT_FALSE(buffer.Update()) << "Nothing was published yet";
+    ASSERT_EQ(buffer.get_read_buffer(), 0);
+
+    buffer.get_write_buffer() = 1;
+    buffer.Publish();
+    ASSERT_TRUE(buffer.Update());
+    ASSERT_EQ(buffer.get_read_buffer(), 1);
+    ASSERT_FALSE(buffer.Update());
+    ASSERT_EQ(buffer.get_read_buffer(), 1) << "The front slot changed without a publication";
+
+    // Values the consumer missed are dropped, never queued
+    for (int value = 2; value <= 5; ++value) {
+        buffer.get_write_buffer() = value;
+        buffer.Publish();
+    }
+    ASSERT_TRUE(buffer.Update());
+    ASSERT_EQ(buffer.get_read_buffer(), 5);
+    ASSERT_FALSE(buffer.Update());
+}
+
+TEST(TestTripleBuffer, FramesAreNeverTorn) {
+    const uint64_t count = 100000;
+    TripleBuffer<std::array<uint64_t, VIDEO_HEIGHT>> frames;
+
+    // Every row of frame n holds n, a torn frame mixes two values
+    std::thread producer([&frames] {
+        for (uint64_t n = 1; n <= count; ++n) {
+            frames.get_write_buffer().fill(n);
+            frames.Publish();
+        }
+    });
+
+    uint64_t last = 0;
+    while (last < count) {
+        if (!frames.Update()) {
+            std::this_thread::yield();
+            continue;
+        }
+        const auto& frame = frames.get_read_buffer();
+        for (uint64_t row : frame)
+            ASSERT_EQ(row, frame[0]) << "Torn frame";
+        ASSERT_GT(frame[0], last) << "An older frame came back";
+        last = frame[0];
+    }
+    producer.join();
+}
@@ -0,0 +1,95 @@
+#include "RewindBuffer.h"
+#include "Chip8.h"
+#include "Tests_common.h"
+
+#include <cstring>
+
+// 0x200: RND V0, 0xFF ; 0x202: RND V1, 0x1F ; 0x204: LD I, 0x300 ; 0x206: LD B, V0
+// 0x208: DRW V0, V1, 3 ; 0x20A: JP 0x200
+static const std::vector<uint8_t> drawingRom = {0xC0, 0xFF, 0xC1, 0x1F, 0xA3, 0x00, 0xF0, 0x33,
+                                                0xD0, 0x13, 0x12, 0x00};
+
+// Runs the ROM one frame at a time and records every frame in the buffer and in `history`
+static void recordFrames(RewindBuffer& rewind, std::vector<Chip8State>& history, int frames) {
+    Chip8 chip8;
+    chip8.Seed(0x9E3779B9ull);
+    chip8.LoadROM(drawingRom);
+
+    for (int frame = 0; frame < frames; ++frame) {
+        chip8.Run(6);
+        chip8.TickTimers();
+
+        Chip8State state;
+        chip8.SaveState(state);
+        rewind.Push(state);
+        history.push_back(state);
+    }
+}
+
+// ====== Testing the rewind history ======
+
+TEST(TestRewindBuffer, StepBackRestoresEveryFrame) {
+    RewindBuffer rewind(DEFAULT_REWIND_ARENA_SIZE, DEFAULT_REWIND_FRAMES, 16);
+    std::vector<Chip8State> history;
+    recordFrames(rewind, history, 200);
+
+    ASSERT_EQ(rewind.get_frame_count(), 200u);
+    ASSERT_LT(rewind.get_used_bytes(), 200 * sizeof(Chip8State) / 4) << "Frames are not delta-compressed";
+
+    // Back over deltas and keyframes down to the first frame
+    Chip8State state;
+    for (int frame = 198; frame >= 0; --frame) {
+        ASSERT_TRUE(rewind.StepBack(state)) << "frame " << frame;
+        ASSERT_EQ(std::memcmp(&state, &history[frame], sizeof(state)), 0) << "frame " << frame;
+    }
+    ASSERT_FALSE(rewind.StepBack(state));
+    ASSERT_EQ(rewind.get_frame_count(), 1u);
+
+    // The restored state runs on
+    Chip8 chip8;
+    chip8.LoadState(state);
+    ASSERT_EQ(chip8.get_pc(), history[0].pc);
+}
+
+TEST(TestRewindBuffer, BoundedArenaEvictsOldestFrames) {
+    // Room for a handful of raw states only, the arena wraps many times
+    const std::size_t arenaSize = 6 * sizeof(Chip8State);
+    RewindBuffer rewind(arenaSize, DEFAULT_REWIND_FRAMES, 8);
+    std::vector<Chip8State> history;
+    recordFrames(rewind, history, 2000);
+
+    std::size_t kept = rewind.get_frame_count();
+    ASSERT_GT(kept, 8u);
+    ASSERT_LT(kept, 2000u);
+    ASSERT_LE(rewind.get_used_bytes(), rewind.get_capacity());
+
+    Chip8State state;
+    for (std::size_t age = 2; age <= kept; ++age) {
+        ASSERT_TRUE(rewind.StepBack(state)) << "age " << age;
+        ASSERT_EQ(std::memcmp(&state, &history[history.size() - age], sizeof(state)), 0) << "age " << age;
+    }
+    ASSERT_FALSE(rewind.StepBack(state));
+
+    // Recording resumes from the rewound frame
+    rewind.Push(history[0]);
+    ASSERT_TRUE(rewind.StepBack(state));
+    ASSERT_EQ(std::memcmp(&state, &history[history.size() - kept], sizeof(state)), 0);
+}
+
+TEST(TestRewindBuffer, BoundedFrameCount) {
+    RewindBuffer rewind(DEFAULT_REWIND_ARENA_SIZE, 50, 10);
+    std::vector<Chip8State> history;
+    recordFrames(rewind, history, 500);
+
+    // Whole segments are evicted, so between 40 and 50 frames remain
+    ASSERT_LE(rewind.get_frame_count(), 50u);
+    ASSERT_GE(rewind.get_frame_count(), 40u);
+
+    rewind.Clear();
+    ASSERT_EQ(rewind.get_frame_count(), 0u);
+    ASSERT_EQ(rewind.get_used_bytes(), 0u);
+
+    Chip8State state;
+    ASSERT_FALSE(rewind.StepBack(state));
+    ASSERT_THROW(RewindBuffer(sizeof(Chip8State)), std::runtime_error);
+}
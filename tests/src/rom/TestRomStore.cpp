@@ -0,0 +1,83 @@
+#include "RomStore.h"
+#include "Chip8.h"
+#include "Movie.h"
+#include "Tests_common.h"
+
+#include <filesystem>
+
+// 0x200: LD V0, 0x2A ; 0x202: JP 0x202
+static const std::vector<uint8_t> smallRom = {0x60, 0x2A, 0x12, 0x02};
+
+static void writeRom(const std::string& path, std::span<const uint8_t> rom) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+}
+
+// ====== Testing the ROM images ======
+
+TEST(TestRomStore, MappedImageLoadsLikeReadROM) {
+    std::string path = "./temp_rom.bin";
+    writeRom(path, smallRom);
+
+    // Any extension is accepted, only the contents are checked
+    std::shared_ptr<const RomImage> image = RomImage::Map(path);
+    ASSERT_TRUE(std::ranges::equal(image->get_data(), smallRom));
+    ASSERT_EQ(image->get_hash(), Movie::HashRom(smallRom));
+
+    Chip8 mapped, copied;
+    mapped.LoadROM(image->get_data());
+    copied.LoadROM(smallRom);
+    mapped.Run(2);
+    copied.Run(2);
+    ASSERT_EQ(mapped.StateHash(), copied.StateHash());
+    ASSERT_EQ(mapped.get_registers()[0], 0x2A);
+
+    image.reset();
+    std::filesystem::remove(path);
+}
+
+TEST(TestRomStore, RejectsInvalidRoms) {
+    std::string path = "./temp_rom_empty.ch8";
+    writeRom(path, {});
+    ASSERT_THROW(RomImage::Map(path), std::runtime_error) << "An empty file was accepted";
+    ASSERT_THROW(RomImage::Map("./missing_rom.ch8"), std::runtime_error);
+
+    std::vector<uint8_t> huge(MAX_ROM_SIZE + 1, 0x00);
+    writeRom(path, huge);
+    ASSERT_THROW(RomImage::Map(path), std::runtime_error) << "A ROM larger than the memory was accepted";
+    ASSERT_THROW(RomImage::Copy(huge), std::runtime_error);
+    ASSERT_NO_THROW(RomImage::Copy(std::span<const uint8_t>(huge).first(MAX_ROM_SIZE)));
+
+    std::filesystem::remove(path);
+}
+
+// ====== Testing the store ======
+
+TEST(TestRomStore, DeduplicatesByPathAndContents) {
+    std::string first = "./temp_rom_a.ch8", second = "./temp_rom_b.ch8";
+    writeRom(first, smallRom);
+    writeRom(second, smallRom);
+
+    RomStore store;
+    std::shared_ptr<const RomImage> a = store.Open(first);
+    ASSERT_EQ(store.Open(first), a) << "The same path was mapped twice";
+    ASSERT_EQ(store.Open(second), a) << "Identical files did not share an image";
+    ASSERT_EQ(store.Add(smallRom, "buffer"), a) << "An identical buffer did not share an image";
+    ASSERT_EQ(store.Find(Movie::HashRom(smallRom)), a);
+    ASSERT_EQ(store.get_size(), 1u);
+
+    // Other contents get their own image, which outlives the store
+    std::vector<uint8_t> other = {0x61, 0x01, 0x12, 0x02};
+    std::shared_ptr<const RomImage> b = store.Add(other, "other");
+    ASSERT_NE(b, a);
+    ASSERT_EQ(store.get_size(), 2u);
+    ASSERT_EQ(store.Find(0), nullptr);
+
+    store.Clear();
+    ASSERT_EQ(store.get_size(), 0u);
+    ASSERT_TRUE(std::ranges::equal(b->get_data(), other));
+
+    a.reset();
+    std::filesystem::remove(first);
+    std::filesystem::remove(second);
+}
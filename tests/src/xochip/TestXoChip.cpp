@@ -0,0 +1,248 @@
+#include "XoChip.h"
+#include "Scheduler.h"
+#include "Tests_common.h"
+
+#include <bit>
+
+// Runs a ROM up to its final jump to itself
+static void runRom(XoChip& xo, const std::vector<uint8_t>& rom) {
+    xo.LoadROM(rom);
+    for (int i = 0; i < 1000 && !xo.is_halted(); ++i)
+        xo.Cycle();
+    ASSERT_TRUE(xo.is_halted()) << "The test ROM did not finish";
+}
+
+// Pixel (x, y) of a plane, in the coordinates of the current mode
+static bool pixel(const XoChip& xo, unsigned int plane, unsigned int x, unsigned int y) {
+    return (xo.get_plane(plane)[y * XO_ROW_WORDS + x / 64] >> (63 - x % 64)) & 1u;
+}
+
+// ====== Testing the display ======
+
+TEST(TestXoChip, HiresSpriteSpansBothWords) {
+    // 0x200: HIGH ; LD V0, 60 ; LD V1, 5 ; LD I, 0x210 ; DRW V0, V1, 0 ; DRW V0, V1, 0 ; JP 0x20C ; 0x210: 16x16 sprite
+    std::vector<uint8_t> rom = {0x00, 0xFF, 0x60, 0x3C, 0x61, 0x05, 0xA2, 0x10, 0xD0, 0x10, 0xD0, 0x10, 0x12, 0x0C};
+    rom.resize(0x10);
+    rom.insert(rom.end(), 32, 0xFF);
+
+    XoChip xo;
+    xo.LoadROM(rom);
+    xo.Run(5);
+    ASSERT_TRUE(xo.is_hires());
+    ASSERT_EQ(xo.get_registers()[0xF], 0);
+
+    // Columns 60 to 75 of rows 5 to 20: the low nibble of word 0 and the top 12 bits of word 1
+    auto plane = xo.get_plane(0);
+    for (unsigned int y = 0; y < XO_VIDEO_HEIGHT; ++y) {
+        bool drawn = y >= 5 && y < 21;
+        ASSERT_EQ(plane[y * XO_ROW_WORDS], drawn ? 0xFULL : 0ULL) << "row " << y;
+        ASSERT_EQ(plane[y * XO_ROW_WORDS + 1], drawn ? 0xFFF0000000000000ULL : 0ULL) << "row " << y;
+    }
+    ASSERT_EQ(xo.get_dirty_rows() & 0x1FFFE0ULL, 0x1FFFE0ULL);
+
+    // Drawing it again erases it and reports the collision
+    xo.ClearDirty();
+    xo.Cycle();
+    ASSERT_EQ(xo.get_registers()[0xF], 1);
+    ASSERT_EQ(xo.get_dirty_rows(), 0x1FFFE0ULL);
+    for (uint64_t word : xo.get_plane(0))
+        ASSERT_EQ(word, 0ULL);
+}
+
+TEST(TestXoChip, SpritesWrapAroundTheEdges) {
+    // 0x200: HIGH ; LD V0, 124 ; LD V1, 62 ; LD I, 0x20E ; DRW V0, V1, 4 ; JP 0x20C ; sprite 0xFF x4
+    std::vector<uint8_t> rom = {0x00, 0xFF, 0x60, 0x7C, 0x61, 0x3E, 0xA2, 0x0E, 0xD0, 0x14, 0x12, 0x0A,
+                                0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF};
+    XoChip xo;
+    runRom(xo, rom);
+
+    // Columns 124-127 then 0-3, rows 62, 63 then 0, 1
+    for (unsigned int y : {62u, 63u, 0u, 1u}) {
+        for (unsigned int x : {124u, 127u, 0u, 3u})
+            ASSERT_TRUE(pixel(xo, 0, x, y)) << x << "," << y;
+        ASSERT_FALSE(pixel(xo, 0, 4, y));
+        ASSERT_FALSE(pixel(xo, 0, 123, y));
+    }
+
+    // In lo-res the same sprite wraps at column 64, word 1 stays empty
+    rom[1] = 0xFE;
+    rom[3] = 60;
+    rom[5] = 30;
+    XoChip lores;
+    runRom(lores, rom);
+    ASSERT_TRUE(pixel(lores, 0, 63, 31));
+    ASSERT_TRUE(pixel(lores, 0, 3, 0));
+    ASSERT_FALSE(pixel(lores, 0, 4, 0));
+    for (unsigned int y = 0; y < XO_VIDEO_HEIGHT; ++y)
+        ASSERT_EQ(lores.get_plane(0)[y * XO_ROW_WORDS + 1], 0ULL);
+}
+
+TEST(TestXoChip, ScrollsShiftWholeWords) {
+    // 0x200: HIGH ; LD V0, 62 ; LD V1, 10 ; LD I, 0x214 ; DRW V0, V1, 1 ; SCR ; SCD 3 ; SCU 5 ; SCL ; JP 0x212
+    std::vector<uint8_t> rom = {0x00, 0xFF, 0x60, 0x3E, 0x61, 0x0A, 0xA2, 0x14, 0xD0, 0x11,
+                                0x00, 0xFB, 0x00, 0xC3, 0x00, 0xD5, 0x00, 0xFC, 0x12, 0x12, 0x80};
+
+    // Stop after each scroll: a single pixel moves from (62, 10)
+    std::vector<std::array<unsigned int, 2>> positions = {{66, 10}, {66, 13}, {66, 8}, {62, 8}};
+    XoChip xo;
+    xo.LoadROM(rom);
+    xo.Run(5);
+    ASSERT_TRUE(pixel(xo, 0, 62, 10));
+    for (auto [x, y] : positions) {
+        xo.Cycle();
+        ASSERT_TRUE(pixel(xo, 0, x, y)) << "expected at " << x << "," << y;
+        unsigned int lit = 0;
+        for (uint64_t word : xo.get_plane(0))
+            lit += std::popcount(word);
+        ASSERT_EQ(lit, 1u) << "A scroll duplicated or lost pixels";
+    }
+
+    // Scrolled past the edge, the pixel is gone
+    XoChip edge;
+    std::vector<uint8_t> down = {0x00, 0xFF, 0x61, 0x3F, 0xA2, 0x0C, 0xD0, 0x11, 0x00, 0xC1, 0x12, 0x0A, 0x80};
+    runRom(edge, down);
+    for (uint64_t word : edge.get_plane(0))
+        ASSERT_EQ(word, 0ULL);
+}
+
+TEST(TestXoChip, PlanesAreDrawnAndClearedSeparately) {
+    // 0x200: PLANE 3 ; LD I, 0x20E ; DRW V0, V0, 1 ; PLANE 1 ; CLS ; JP 0x20A ; (plane 1: 0xF0, plane 2: 0x0F)
+    std::vector<uint8_t> rom = {0xF3, 0x01, 0xA2, 0x0E, 0xD0, 0x01, 0xF1, 0x01, 0x00, 0xE0, 0x12, 0x0A, 0x00, 0x00, 0xF0, 0x0F};
+
+    XoChip xo;
+    xo.LoadROM(rom);
+    xo.Run(3);
+    ASSERT_EQ(xo.get_plane(0)[0], 0xF0ULL << 56);
+    ASSERT_EQ(xo.get_plane(1)[0], 0x0FULL << 56) << "Plane 2 did not read the sprite following plane 1";
+
+    // Lo-res pixels are doubled, each plane has its own colour
+    std::vector<uint32_t> video = xo.get_video();
+    ASSERT_EQ(video.size(), XO_VIDEO_WIDTH * XO_VIDEO_HEIGHT);
+    ASSERT_EQ(video[0], XO_DEFAULT_PALETTE[1]);
+    ASSERT_EQ(video[XO_VIDEO_WIDTH + 7], XO_DEFAULT_PALETTE[1]);
+    ASSERT_EQ(video[8], XO_DEFAULT_PALETTE[2]);
+    ASSERT_EQ(video[16], XO_DEFAULT_PALETTE[0]);
+
+    // 00E0 only clears the selected plane
+    xo.Run(2);
+    ASSERT_EQ(xo.get_plane_mask(), 1);
+    ASSERT_EQ(xo.get_plane(0)[0], 0ULL);
+    ASSERT_EQ(xo.get_plane(1)[0], 0x0FULL << 56);
+}
+
+TEST(TestXoChip, DirtyRowsCoverTheVisibleDisplay) {
+    // 0x200: LD I, 0x20A ; LD V1, 5 ; DRW V0, V1, 2 ; JP 0x208 ; (sprite: 0xFF, 0x81)
+    std::vector<uint8_t> rom = {0xA2, 0x0A, 0x61, 0x05, 0xD0, 0x12, 0x12, 0x06, 0x00, 0x00, 0xFF, 0x81};
+
+    XoChip xo;
+    xo.LoadROM(rom);
+    xo.ClearDirty();
+    xo.Run(3);
+    ASSERT_EQ(xo.get_dirty_rows(), 0x3ULL << 5);
+    ASSERT_EQ(xo.get_video_dirty_rows(), 0xFULL << 10) << "A lo-res row must cover two visible rows";
+
+    // Drawing the dirty rows alone gives the same pixels as the whole display
+    std::vector<uint32_t> video = xo.get_video();
+    std::vector<uint32_t> rows(4 * XO_VIDEO_WIDTH);
+    xo.ExpandVideo(10, 4, rows.data(), XO_VIDEO_WIDTH * sizeof(uint32_t));
+    ASSERT_TRUE(std::equal(rows.begin(), rows.end(), video.begin() + 10 * XO_VIDEO_WIDTH));
+    ASSERT_EQ(rows[0], XO_DEFAULT_PALETTE[1]);
+    ASSERT_EQ(rows[2 * XO_VIDEO_WIDTH + 2], XO_DEFAULT_PALETTE[0]);
+}
+
+// ====== Testing the instructions ======
+
+TEST(TestXoChip, LongLoadAndSkips) {
+    // 0x200: SE V0, 0 ; LD I, 0x1234 (4 bytes, skipped whole) ; LD I, long 0xFFF0 ; LD [I], V2 ; JP 0x20C
+    std::vector<uint8_t> rom = {0x30, 0x00, 0xF0, 0x00, 0x12, 0x34, 0xF0, 0x00, 0xFF, 0xF0, 0xF2, 0x55, 0x12, 0x0C};
+    XoChip xo;
+    xo.LoadROM(rom);
+    xo.Cycle();
+    ASSERT_EQ(xo.get_pc(), 0x206) << "The skip did not step over both words of F000";
+    xo.Cycle();
+    ASSERT_EQ(xo.get_index(), 0xFFF0);
+    xo.Cycle();
+    ASSERT_EQ(xo.get_index(), 0xFFF3) << "Fx55 did not advance I";
+    ASSERT_EQ(xo.get_pc(), 0x20C);
+}
+
+TEST(TestXoChip, RegisterRangesFlagsAndFonts) {
+    // 0x200: LD V1, 1 ; LD V2, 2 ; LD V3, 3 ; LD I, 0x300 ; SAVE V3 - V1 ; LOAD V4 - V6 ; SAVEFLAGS V3 ; EXIT
+    std::vector<uint8_t> rom = {0x61, 0x01, 0x62, 0x02, 0x63, 0x03, 0xA3, 0x00, 0x53, 0x12, 0x54, 0x63,
+                                0xF3, 0x75, 0x00, 0xFD};
+    XoChip xo;
+    runRom(xo, rom);
+
+    auto memory = xo.get_memory();
+    ASSERT_EQ(memory[0x300], 3);
+    ASSERT_EQ(memory[0x302], 1) << "5xy2 did not store in reverse order";
+    ASSERT_EQ(xo.get_registers()[4], 3);
+    ASSERT_EQ(xo.get_registers()[6], 1);
+    ASSERT_EQ(xo.get_index(), 0x300) << "5xy2/5xy3 must not move I";
+    ASSERT_EQ(xo.get_flags()[3], 3);
+    ASSERT_EQ(xo.get_pc(), 0x20E) << "00FD did not stop the program";
+
+    // The big font follows the small one in low memory
+    XoChip fonts;
+    fonts.LoadROM(std::vector<uint8_t>{0x60, 0x07, 0xF0, 0x30});
+    fonts.Run(2);
+    ASSERT_EQ(fonts.get_index(), BIG_FONTSET_START_ADDRESS + 7 * BIG_FONT_SIZE);
+    ASSERT_EQ(fonts.get_memory()[fonts.get_index() + 4], bigFontset[7 * BIG_FONT_SIZE + 4]);
+}
+
+TEST(TestXoChip, SuperChipProfileKeepsItsQuirks) {
+    // 0x200: LD V0, 0x81 ; LD V1, 4 ; LD V2, 4 ; SHR V0, V1 ; LD I, 0x300 ; LD [I], V1 ; JP V2, 0x210
+    // 0x20E: JP 0x20E ; JP 0x210 ; JP 0x212 ; JP 0x214
+    std::vector<uint8_t> rom = {0x60, 0x81, 0x61, 0x04, 0x62, 0x04, 0x80, 0x16, 0xA3, 0x00, 0xF1, 0x55,
+                                0xB2, 0x10, 0x12, 0x0E, 0x12, 0x10, 0x12, 0x12, 0x12, 0x14};
+
+    // SUPER-CHIP: shift Vx, I unchanged, Bxnn jumps to xnn + Vx
+    XoChip schip(Chip8QuirkProfile::SuperChip);
+    ASSERT_EQ(schip.get_quirk_profile(), Chip8QuirkProfile::SuperChip);
+    runRom(schip, rom);
+    ASSERT_EQ(schip.get_registers()[0], 0x40);
+    ASSERT_EQ(schip.get_registers()[0xF], 1);
+    ASSERT_EQ(schip.get_index(), 0x300);
+    ASSERT_EQ(schip.get_memory()[0x301], 4);
+    ASSERT_EQ(schip.get_pc(), 0x214);
+
+    // XO-CHIP: shift Vy, I advanced, Bnnn jumps to nnn + V0
+    XoChip xo;
+    runRom(xo, rom);
+    ASSERT_EQ(xo.get_registers()[0], 2);
+    ASSERT_EQ(xo.get_registers()[0xF], 0);
+    ASSERT_EQ(xo.get_index(), 0x302);
+    ASSERT_EQ(xo.get_pc(), 0x212);
+
+    // 0x200: LD V0, 60 ; LD I, 0x208 ; DRW V0, V1, 1 ; JP 0x206 ; (sprite: 0xFF)
+    std::vector<uint8_t> edge = {0x60, 0x3C, 0xA2, 0x08, 0xD0, 0x11, 0x12, 0x06, 0xFF};
+    XoChip clipped(Chip8QuirkProfile::SuperChip), wrapped;
+    runRom(clipped, edge);
+    runRom(wrapped, edge);
+    ASSERT_EQ(clipped.get_plane(0)[0], 0xFULL) << "SUPER-CHIP sprites are clipped at the edge";
+    ASSERT_EQ(wrapped.get_plane(0)[0], 0xF00000000000000FULL);
+}
+
+// ====== Testing the shared scheduler ======
+
+TEST(TestXoChip, SchedulerAppliesKeysAndSkipsIdleCycles) {
+    // 0x200: LD V0, K ; JP 0x202
+    XoChip xo;
+    xo.LoadROM(std::vector<uint8_t>{0xF0, 0x0A, 0x12, 0x02});
+    auto epoch = XoScheduler::Clock::now();
+    XoScheduler scheduler(xo, SchedulerMode::RealTime, 100, epoch);
+    InputQueue input;
+    scheduler.SetInput(&input);
+
+    scheduler.Pump(epoch + XoScheduler::FRAME_PERIOD);
+    ASSERT_EQ(xo.get_idle_state(), Chip8IdleState::WaitingForKey);
+    ASSERT_EQ(xo.get_pc(), START_ADDRESS);
+
+    // The press lands on the instruction matching its time, not at the frame boundary
+    input.TryPush(KeyEvent{epoch + XoScheduler::FRAME_PERIOD * 3 / 2, 0x7, true});
+    scheduler.Pump(epoch + XoScheduler::FRAME_PERIOD * 2);
+    ASSERT_EQ(xo.get_keypad()[0x7], 1);
+    ASSERT_EQ(xo.get_registers()[0], 0x7);
+    ASSERT_EQ(xo.get_idle_state(), Chip8IdleState::Halted);
+    ASSERT_EQ(scheduler.get_cycle_count(), 200u);
+}